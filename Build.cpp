@@ -1,48 +1,12 @@
 
 #include "Ease.hpp"
+#include "src/ShaderBuild.hpp"
 
 EASE_WATCH_ME;
 
-void compile_shaders() {
-	std::filesystem::path shader_dir = std::filesystem::current_path() / "src" / "shaders";
-
-	// for every file in the shader directory
-	for (const std::filesystem::directory_entry& entry : std::filesystem::directory_iterator(shader_dir))
-	{
-		// if the file is a file
-		if (entry.is_regular_file()) {
-			// if the file is a shader file
-			if (entry.path().extension() == ".frag") {
-				// compile the shader
-				std::string output_name = "frag_" + entry.path().filename().replace_extension(".spv").generic_string();
-				std::filesystem::path input_path = entry.path();
-				std::filesystem::path output_path =
-					std::filesystem::current_path() / "assets" / "shaders" / output_name;
-
-				std::string command = "glslc " + input_path.generic_string();
-				command += " -o " + output_path.generic_string();
-				printf("Compiling fragment shader: %s\n", command.c_str());
-				system(command.c_str());
-			}
-			else if (entry.path().extension() == ".vert") {
-				// compile the shader
-				std::string output_name = "vert_" + entry.path().filename().replace_extension(".spv").generic_string();
-				std::filesystem::path input_path = entry.path();
-				std::filesystem::path output_path =
-					std::filesystem::current_path() / "assets" / "shaders" / output_name;
-
-				std::string command = "glslc " + input_path.generic_string();
-				command += " -o " + output_path.generic_string();
-				printf("Compiling vertex shader:   %s\n", command.c_str());
-				system(command.c_str());
-			}
-		}
-	}
-}
-
 Build build(Flags flags) noexcept {
 	flags.no_install_path = true;
-	compile_shaders();
+	build_shaders();
 	
 	Build b = Build::get_default(flags);
 	b.flags.subsystem = Flags::Subsystem::Console;
@@ -0,0 +1,155 @@
+#include "AssetLoader.hpp"
+
+#include "SDL3/SDL.h"
+
+#include <algorithm>
+#include <filesystem>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+Asset_Loader Asset_Loader::loader;
+
+Asset_Loader::File* Asset_Loader::find(const char* path) {
+	for (File& file : files) {
+		if (file.path == path)
+			return &file;
+	}
+	return nullptr;
+}
+
+void Asset_Loader::request(const char* path) {
+	if (find(path))
+		return;
+
+	if (!queue) {
+		queue = SDL_CreateAsyncIOQueue();
+		if (!queue) {
+			printf("Failed to create async I/O queue: %s\n", SDL_GetError());
+			return;
+		}
+	}
+
+	File file;
+	file.path = path;
+	file.requested_ns = SDL_GetTicksNS();
+	// The index, files grows while reads are in flight.
+	void* userdata = (void*)(uintptr_t)files.size();
+	if (SDL_LoadFileAsync(path, queue, userdata)) {
+		in_flight += 1;
+	} else {
+		// Missing, load reads it again to report the error like SDL_LoadFile did.
+		file.done = true;
+		file.arrived_ns = file.requested_ns;
+	}
+	files.push_back(std::move(file));
+}
+
+void Asset_Loader::request_directory(const char* directory, const char* extension) {
+	std::error_code error;
+	for (const auto& entry : std::filesystem::directory_iterator(directory, error)) {
+		if (!entry.is_regular_file())
+			continue;
+		if (entry.path().extension().generic_string() != extension)
+			continue;
+		std::string path = (std::filesystem::path(directory) / entry.path().filename())
+			.generic_string();
+		request(path.c_str());
+	}
+	if (error)
+		printf("Failed to list %s: %s\n", directory, error.message().c_str());
+}
+
+bool Asset_Loader::wait_one(i32 timeout_ms) {
+	SDL_AsyncIOOutcome outcome;
+	if (!SDL_WaitAsyncIOResult(queue, &outcome, timeout_ms))
+		return false;
+
+	in_flight -= 1;
+	File& file = files[(usz)(uintptr_t)outcome.userdata];
+	file.done = true;
+	file.arrived_ns = SDL_GetTicksNS();
+	if (outcome.result == SDL_ASYNCIO_COMPLETE) {
+		file.ok = true;
+		file.data = outcome.buffer;
+		file.size = (usz)outcome.bytes_transferred;
+	} else {
+		SDL_free(outcome.buffer);
+	}
+	return true;
+}
+
+void* Asset_Loader::load(const char* path, usz* size) {
+	File* file = find(path);
+	if (file && !file->taken) {
+		// Files what already arrived first so their times stay close to the truth, then waits.
+		// wait_one may file any of the reads, file stays valid as nothing is requested here.
+		while (in_flight > 0 && wait_one(0)) {
+		}
+		while (!file->done && in_flight > 0) {
+			if (!wait_one(-1))
+				break;
+		}
+
+		file->taken = true;
+		if (file->ok) {
+			*size = file->size;
+			void* data = file->data;
+			file->data = nullptr;
+			return data;
+		}
+	}
+
+	size_t n = 0;
+	void* data = SDL_LoadFile(path, &n);
+	*size = n;
+	return data;
+}
+
+void Asset_Loader::finish() {
+	while (in_flight > 0) {
+		if (!wait_one(-1))
+			break;
+	}
+	if (queue) {
+		SDL_DestroyAsyncIOQueue(queue);
+		queue = nullptr;
+	}
+
+	u64 first_ns = UINT64_MAX;
+	u64 last_ns = 0;
+	usz bytes = 0;
+	usz loaded = 0;
+	usz unused = 0;
+	const File* slowest = nullptr;
+	for (File& file : files) {
+		if (!file.taken && file.data) {
+			SDL_free(file.data);
+			file.data = nullptr;
+			unused += 1;
+		}
+		file.taken = true;
+		if (!file.ok)
+			continue;
+
+		loaded += 1;
+		bytes += file.size;
+		u64 duration = file.arrived_ns - file.requested_ns;
+		first_ns = std::min(first_ns, file.requested_ns);
+		last_ns = std::max(last_ns, file.arrived_ns);
+		if (!slowest || duration > slowest->arrived_ns - slowest->requested_ns)
+			slowest = &file;
+	}
+	if (!slowest)
+		return;
+
+	printf(
+		"Assets: %zu files, %.2f MB in %.2f ms, slowest %s in %.2f ms, %zu unused\n",
+		loaded,
+		bytes / (1024.0 * 1024.0),
+		(last_ns - first_ns) / 1e6,
+		slowest->path.c_str(),
+		(slowest->arrived_ns - slowest->requested_ns) / 1e6,
+		unused
+	);
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include "Common.hpp"
+
+#include "SDL3/SDL_asyncio.h"
+
+#include <string>
+#include <vector>
+
+// Reads files with SDL's async I/O so that all of them are in flight at once, and boot waits for
+// the slowest file instead of the sum of them. The boot requests every file it will read, then
+// whoever reads a file calls load instead of SDL_LoadFile and only waits for that one. A path
+// that was not requested, or was already taken, is read right away with SDL_LoadFile, so hot
+// reloads and rebakes see the disk as it is now. Main thread only.
+struct Asset_Loader {
+	struct File {
+		std::string path;
+		void* data = nullptr;
+		usz size = 0;
+		bool done = false;
+		bool ok = false;
+		bool taken = false;
+		u64 requested_ns = 0;
+		u64 arrived_ns = 0; // when the loader saw it complete
+	};
+
+	SDL_AsyncIOQueue* queue = nullptr;
+	std::vector<File> files;
+	usz in_flight = 0;
+
+	void request(const char* path);
+	// Requests the files of directory whose name ends with extension.
+	void request_directory(const char* directory, const char* extension);
+
+	// The content of path like SDL_LoadFile would return it, free it with SDL_free.
+	void* load(const char* path, usz* size);
+
+	// Waits for the reads still in flight, frees what nobody took and prints how long the files
+	// took to arrive.
+	void finish();
+
+	static Asset_Loader loader;
+
+	File* find(const char* path);
+	// Waits up to timeout_ms, -1 for ever, for the next read to complete and files it.
+	bool wait_one(i32 timeout_ms);
+};
@@ -1,63 +1,46 @@
 #include "Atmosphere.hpp"
 #include "Maths.hpp"
+#include <algorithm>
+#include <string.h>
 #include <vector>
 #include "imgui/imgui.h"
 
-bool Atmosphere::create_pipeline(SDL_GPUDevice* gpu) {
-	SDL_GPUShader* vertex_shader = nullptr;
-	SDL_GPUShader* fragment_shader = nullptr;
-
-	{
-		size_t vertex_size = 0;
-		void* plain_vertex = SDL_LoadFile("assets/shaders/vert_atmosphere.spv", &vertex_size);
-		defer {
-			SDL_free(plain_vertex);
-		};
-
-		size_t fragment_size = 0;
-		void* plain_fragment = SDL_LoadFile("assets/shaders/frag_atmosphere.spv", &fragment_size);
-		defer {
-			SDL_free(plain_fragment);
-		};
-
-		if (!plain_vertex || !plain_fragment) {
-			printf("Failed to load shader files: %s\n", SDL_GetError());
-			return false;
-		}
-
-		SDL_GPUShaderCreateInfo vertex_info = {};
-		vertex_info.code_size = vertex_size;
-		vertex_info.code = (u8*)plain_vertex;
-		vertex_info.entrypoint = "main";
-		vertex_info.format = SDL_GPU_SHADERFORMAT_SPIRV;
-		vertex_info.stage = SDL_GPU_SHADERSTAGE_VERTEX;
-		vertex_info.num_samplers = 0;
-		vertex_info.num_storage_textures = 0;
-		vertex_info.num_storage_buffers = 0;
-		vertex_info.num_uniform_buffers = 2;
-		vertex_shader = SDL_CreateGPUShader(gpu, &vertex_info);
-
-		SDL_GPUShaderCreateInfo fragment_info = {};
-		fragment_info.code_size = fragment_size;
-		fragment_info.code = (u8*)plain_fragment;
-		fragment_info.entrypoint = "main";
-		fragment_info.format = SDL_GPU_SHADERFORMAT_SPIRV;
-		fragment_info.stage = SDL_GPU_SHADERSTAGE_FRAGMENT;
-		fragment_info.num_samplers = 0;
-		fragment_info.num_storage_textures = 0;
-		fragment_info.num_storage_buffers = 0;
-		fragment_info.num_uniform_buffers = 2;
-		fragment_shader = SDL_CreateGPUShader(gpu, &fragment_info);
-	}
+// Draws FullscreenQuad::quad with vert_atmosphere and the given fragment shader, both with two
+// uniform buffers.
+static SDL_GPUGraphicsPipeline* create_fullscreen_pipeline(
+	SDL_GPUDevice* gpu,
+	const char* fragment_path,
+	u32 num_samplers,
+	const SDL_GPUColorTargetDescription& color_target_desc,
+	SDL_GPUSampleCount sample_count
+) {
+	Pipeline_Desc desc = FullscreenQuad::pipeline_desc();
+	desc.vertex = { .path = "assets/shaders/vert_atmosphere.spv", .num_uniform_buffers = 2 };
+	desc.fragment = {
+		.path = fragment_path, .num_samplers = num_samplers, .num_uniform_buffers = 2
+	};
+	desc.sample_count = sample_count;
+	desc.color_targets = { color_target_desc };
+	return Pipeline_Factory::factory.create(gpu, desc);
+}
 
-	if (!vertex_shader || !fragment_shader) {
-		printf("Failed to create shaders: %s\n", SDL_GetError());
-		return false;
-	}
+bool Atmosphere::create_pipeline(SDL_GPUDevice* gpu, const Render_Settings& settings) {
+	// The scattering alone at render scale, alpha is the guide of the upsample.
+	pipeline = create_fullscreen_pipeline(
+		gpu,
+		"assets/shaders/frag_atmosphere.spv",
+		2,
+		{ .format = settings.scaled_format },
+		SDL_GPU_SAMPLECOUNT_1
+	);
 
-	SDL_GPUColorTargetDescription color_target_desc[] = {
+	// Then added over the scene: color + scattering where the scene alpha is 1.
+	upsample_pipeline = create_fullscreen_pipeline(
+		gpu,
+		"assets/shaders/frag_upsample.spv",
+		1,
 		{
-			.format = SDL_GPU_TEXTUREFORMAT_R32G32B32A32_FLOAT,
+			.format = settings.color_format,
 			.blend_state = {
 				.src_color_blendfactor = SDL_GPU_BLENDFACTOR_ONE,
 				.dst_color_blendfactor = SDL_GPU_BLENDFACTOR_DST_ALPHA,
@@ -68,72 +51,139 @@ bool Atmosphere::create_pipeline(SDL_GPUDevice* gpu) {
 				.enable_blend = true,
 				.enable_color_write_mask = false
 			}
-		}
-	};
-	SDL_GPUVertexBufferDescription vertex_buffer_desc[] = {
-		{
-			.slot = 0,
-			.pitch = sizeof(Vector2f),
-			.input_rate = SDL_GPU_VERTEXINPUTRATE_VERTEX
-		}
-	};
-	SDL_GPUVertexAttribute vertex_attributes[] = {
-		{
-			.location = 0,
-			.buffer_slot = 0,
-			.format = SDL_GPU_VERTEXELEMENTFORMAT_FLOAT2,
-			.offset = 0,
-		}
-	};
-	SDL_GPUGraphicsPipelineCreateInfo info = {
-		.vertex_shader = vertex_shader,
-		.fragment_shader = fragment_shader,
-		.vertex_input_state = {
-			.vertex_buffer_descriptions = vertex_buffer_desc,
-			.num_vertex_buffers = sizeof(vertex_buffer_desc) / sizeof(*vertex_buffer_desc),
-			.vertex_attributes = vertex_attributes,
-			.num_vertex_attributes = sizeof(vertex_attributes) / sizeof(*vertex_attributes),
-		},
-		.primitive_type = SDL_GPU_PRIMITIVETYPE_TRIANGLELIST,
-		.rasterizer_state = {
-			.fill_mode = SDL_GPU_FILLMODE_FILL,
-			.cull_mode = SDL_GPU_CULLMODE_NONE,
-			.front_face = SDL_GPU_FRONTFACE_COUNTER_CLOCKWISE,
 		},
-		.multisample_state = {
-			.sample_count = SDL_GPU_SAMPLECOUNT_8,
-		},
-		.depth_stencil_state = {
-			.enable_depth_test = false,
-			.enable_depth_write = false,
-			.enable_stencil_test = false,
-		},
-		.target_info = {
-			.color_target_descriptions = color_target_desc,
-			.num_color_targets = sizeof(color_target_desc) / sizeof(*color_target_desc),
-			.has_depth_stencil_target = false,
-		},
-	};
-	
-	if (pipeline)
-		SDL_ReleaseGPUGraphicsPipeline(gpu, pipeline);
-
-	pipeline = SDL_CreateGPUGraphicsPipeline(gpu, &info);
-	if (!pipeline) {
-		printf("Failed to create graphics pipeline: %s\n", SDL_GetError());
-		return false;
-	}
+		settings.sample_count
+	);
 
-	SDL_ReleaseGPUShader(gpu, vertex_shader);
-	SDL_ReleaseGPUShader(gpu, fragment_shader);
-	return true;
+	if (!upsample_sampler) {
+		upsample_sampler = SDL_CreateGPUSampler(gpu, &(SDL_GPUSamplerCreateInfo) {
+			.min_filter = SDL_GPU_FILTER_NEAREST,
+			.mag_filter = SDL_GPU_FILTER_NEAREST,
+			.mipmap_mode = SDL_GPU_SAMPLERMIPMAPMODE_NEAREST,
+			.address_mode_u = SDL_GPU_SAMPLERADDRESSMODE_CLAMP_TO_EDGE,
+			.address_mode_v = SDL_GPU_SAMPLERADDRESSMODE_CLAMP_TO_EDGE,
+			.address_mode_w = SDL_GPU_SAMPLERADDRESSMODE_CLAMP_TO_EDGE,
+		});
+	}
+	return pipeline && upsample_pipeline && upsample_sampler;
 }
 
 void Atmosphere::release(SDL_GPUDevice* gpu) {
-	if (pipeline) {
-		SDL_ReleaseGPUGraphicsPipeline(gpu, pipeline);
-	}
+	// The pipelines belong to Pipeline_Factory::factory.
 	pipeline = nullptr;
+
+	if (upsample_sampler)
+		SDL_ReleaseGPUSampler(gpu, upsample_sampler);
+	upsample_pipeline = nullptr;
+	upsample_sampler = nullptr;
+
+	if (rayleigh_texture)
+		SDL_ReleaseGPUTexture(gpu, rayleigh_texture);
+	if (mie_texture)
+		SDL_ReleaseGPUTexture(gpu, mie_texture);
+	if (lut_sampler)
+		SDL_ReleaseGPUSampler(gpu, lut_sampler);
+	if (lut_transfer_buffer)
+		SDL_ReleaseGPUTransferBuffer(gpu, lut_transfer_buffer);
+	rayleigh_texture = nullptr;
+	mie_texture = nullptr;
+	lut_sampler = nullptr;
+	lut_transfer_buffer = nullptr;
+	lut.valid = false;
+}
+
+Atmosphere_Lut_Key Atmosphere::lut_key() const {
+	Atmosphere_Lut_Key key;
+	key.ray_beta = uniform.ray_beta;
+	key.mie_beta = uniform.mie_beta;
+	key.absorption_beta = uniform.absorption_beta;
+	key.planet_radius = uniform.planet_radius;
+	key.thickness = std::max(uniform.thickness, 1e-3f);
+	key.height_ray = std::max(uniform.height_ray, 1e-4f);
+	key.height_mie = std::max(uniform.height_mie, 1e-4f);
+	key.height_absorption = uniform.height_absorption;
+	key.absorption_falloff = std::max(uniform.absorption_falloff, 1e-4f);
+	return key;
+}
+
+void Atmosphere::update(SDL_GPUDevice* gpu, std::vector<SDL_GPUFence*>& fences) {
+	constexpr u32 Width = Atmosphere_Lut::Scattering_Nu * Atmosphere_Lut::Scattering_Mu_S;
+	constexpr u32 Height = Atmosphere_Lut::Scattering_Mu;
+	constexpr u32 Depth = Atmosphere_Lut::Scattering_R;
+	constexpr u32 Table_Size = Width * Height * Depth * sizeof(Vector4f);
+
+	// Nothing is allocated until the tables are used, a bake takes a good fraction of a second
+	// and also waits for the sliders to be released.
+	if (!uniform.use_lut)
+		return;
+
+	if (!rayleigh_texture) {
+		SDL_GPUTextureCreateInfo texture_info = {
+			.type = SDL_GPU_TEXTURETYPE_3D,
+			.format = SDL_GPU_TEXTUREFORMAT_R32G32B32A32_FLOAT,
+			.usage = SDL_GPU_TEXTUREUSAGE_SAMPLER,
+			.width = Width,
+			.height = Height,
+			.layer_count_or_depth = Depth,
+			.num_levels = 1,
+			.sample_count = SDL_GPU_SAMPLECOUNT_1,
+		};
+		rayleigh_texture = SDL_CreateGPUTexture(gpu, &texture_info);
+		mie_texture = SDL_CreateGPUTexture(gpu, &texture_info);
+
+		lut_sampler = SDL_CreateGPUSampler(gpu, &(SDL_GPUSamplerCreateInfo) {
+			.min_filter = SDL_GPU_FILTER_LINEAR,
+			.mag_filter = SDL_GPU_FILTER_LINEAR,
+			.mipmap_mode = SDL_GPU_SAMPLERMIPMAPMODE_NEAREST,
+			.address_mode_u = SDL_GPU_SAMPLERADDRESSMODE_CLAMP_TO_EDGE,
+			.address_mode_v = SDL_GPU_SAMPLERADDRESSMODE_CLAMP_TO_EDGE,
+			.address_mode_w = SDL_GPU_SAMPLERADDRESSMODE_CLAMP_TO_EDGE,
+		});
+
+		lut_transfer_buffer = SDL_CreateGPUTransferBuffer(gpu, &(SDL_GPUTransferBufferCreateInfo) {
+			.usage = SDL_GPU_TRANSFERBUFFERUSAGE_UPLOAD,
+			.size = 2 * Table_Size
+		});
+
+		if (!rayleigh_texture || !mie_texture || !lut_sampler || !lut_transfer_buffer) {
+			printf("Failed to create the atmosphere tables: %s\n", SDL_GetError());
+			return;
+		}
+	}
+
+	Atmosphere_Lut_Key key = lut_key();
+	if (lut.valid && (lut.key == key || editing))
+		return;
+	lut.bake(key);
+
+	u8* pointer = (u8*)SDL_MapGPUTransferBuffer(gpu, lut_transfer_buffer, false);
+	memcpy(pointer, lut.rayleigh.data(), Table_Size);
+	memcpy(pointer + Table_Size, lut.mie.data(), Table_Size);
+	SDL_UnmapGPUTransferBuffer(gpu, lut_transfer_buffer);
+
+	SDL_GPUCommandBuffer* buffer = SDL_AcquireGPUCommandBuffer(gpu);
+	SDL_GPUCopyPass* copy = SDL_BeginGPUCopyPass(buffer);
+	SDL_GPUTexture* textures[] = { rayleigh_texture, mie_texture };
+	for (u32 i = 0; i < 2; i += 1) {
+		SDL_UploadToGPUTexture(
+			copy,
+			&(SDL_GPUTextureTransferInfo) {
+				.transfer_buffer = lut_transfer_buffer,
+				.offset = i * Table_Size,
+				.pixels_per_row = Width,
+				.rows_per_layer = Height,
+			},
+			&(SDL_GPUTextureRegion) {
+				.texture = textures[i],
+				.w = Width,
+				.h = Height,
+				.d = Depth,
+			},
+			false
+		);
+	}
+	SDL_EndGPUCopyPass(copy);
+	fences.push_back(SDL_SubmitGPUCommandBufferAndAcquireFence(buffer));
 }
 
 void Atmosphere::imgui() {
@@ -149,6 +199,13 @@ void Atmosphere::imgui() {
 	ImGui::SliderFloat("Height absorption", &uniform.height_absorption, 0.0f, 1.f);
 	ImGui::SliderFloat("Absorption falloff", &uniform.absorption_falloff, 0.0f, 1.f);
 	ImGui::SliderFloat("Intensity", &uniform.intensity, 0.0f, 100.f);
+	editing = ImGui::IsAnyItemActive();
+
+	bool use_lut = uniform.use_lut;
+	if (ImGui::Checkbox("Precomputed tables", &use_lut))
+		uniform.use_lut = use_lut;
+	if (uniform.use_lut && lut.valid && !(lut.key == lut_key()))
+		ImGui::Text("Raymarching until the tables are rebaked");
 	if (ImGui::Button("Reset")) {
 		uniform = {};
 	}
@@ -164,8 +221,48 @@ void Atmosphere::render(SDL_GPURenderPass* pass, SDL_GPUCommandBuffer* command)
 	SDL_PushGPUVertexUniformData(command, 0, &common_uniform, sizeof(common_uniform));
 	SDL_PushGPUFragmentUniformData(command, 0, &common_uniform, sizeof(common_uniform));
 
-	SDL_PushGPUVertexUniformData(command, 1, &uniform, sizeof(uniform));
-	SDL_PushGPUFragmentUniformData(command, 1, &uniform, sizeof(uniform));
+	// Stale tables would show the previous parameters, raymarching shows the current ones.
+	Uniform pushed = uniform;
+	pushed.use_lut = uniform.use_lut && lut.valid && lut.key == lut_key();
+
+	SDL_GPUTextureSamplerBinding samplers[] = {
+		{ .texture = rayleigh_texture, .sampler = lut_sampler },
+		{ .texture = mie_texture, .sampler = lut_sampler },
+	};
+	// Unset while the tables have never been used, the shader raymarches then.
+	if (rayleigh_texture)
+		SDL_BindGPUFragmentSamplers(pass, 0, samplers, 2);
+
+	SDL_PushGPUVertexUniformData(command, 1, &pushed, sizeof(pushed));
+	SDL_PushGPUFragmentUniformData(command, 1, &pushed, sizeof(pushed));
+
+	SDL_DrawGPUPrimitives(pass, 6, 1, 0, 0);
+}
+
+void Atmosphere::composite(
+	SDL_GPURenderPass* pass, SDL_GPUCommandBuffer* command, SDL_GPUTexture* scaled
+) {
+	SDL_BindGPUGraphicsPipeline(pass, upsample_pipeline);
+	SDL_BindGPUVertexBuffers(pass, 0, &(SDL_GPUBufferBinding) {
+		.buffer = FullscreenQuad::quad.vertex_buffer,
+		.offset = 0
+	}, 1);
+
+	SDL_BindGPUFragmentSamplers(pass, 0, &(SDL_GPUTextureSamplerBinding) {
+		.texture = scaled,
+		.sampler = upsample_sampler
+	}, 1);
+
+	Upsample_Uniform upsample = {
+		.eye = uniform.eye,
+		.planet_radius = uniform.planet_radius,
+		.low_width = uniform.width,
+		.low_height = uniform.height,
+	};
+	SDL_PushGPUVertexUniformData(command, 0, &common_uniform, sizeof(common_uniform));
+	SDL_PushGPUFragmentUniformData(command, 0, &common_uniform, sizeof(common_uniform));
+	SDL_PushGPUVertexUniformData(command, 1, &upsample, sizeof(upsample));
+	SDL_PushGPUFragmentUniformData(command, 1, &upsample, sizeof(upsample));
 
 	SDL_DrawGPUPrimitives(pass, 6, 1, 0, 0);
 }
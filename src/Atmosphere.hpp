@@ -2,6 +2,7 @@
 
 #include "SDL3/SDL.h"
 #include "Graphics.hpp"
+#include "AtmosphereLut.hpp"
 
 struct Atmosphere {
 	struct Uniform {
@@ -21,7 +22,7 @@ struct Atmosphere {
 
 		u32 width;
 		u32 height;
-		f32 planet_radius;
+		f32 planet_radius = 1.0f;
 		f32 thickness = 1.0f;
 		f32 density = 1.0f;
 
@@ -30,18 +31,45 @@ struct Atmosphere {
 		f32 height_absorption = 10.0f;
 		f32 absorption_falloff = 1.0f;
 		f32 intensity = 20.f;
+		// Samples the baked tables instead of raymarching, render clears it while they are stale.
+		u32 use_lut = 1;
+	};
+
+	// UpsampleBlock of upsample.frag.
+	struct Upsample_Uniform {
+		Vector3f eye;
+		f32 planet_radius;
+		u32 low_width;
+		u32 low_height;
 	};
 
 	Uniform uniform;
 	Common_Uniform common_uniform;
 
+	Atmosphere_Lut lut;
+	// Sliders being dragged, the tables wait for the value to settle before rebaking.
+	bool editing = false;
+	SDL_GPUTexture* rayleigh_texture = nullptr;
+	SDL_GPUTexture* mie_texture = nullptr;
+	SDL_GPUSampler* lut_sampler = nullptr;
+	SDL_GPUTransferBuffer* lut_transfer_buffer = nullptr;
 
 	SDL_GPUBuffer* shader_buffer = nullptr;
 	SDL_GPUGraphicsPipeline* pipeline = nullptr;
+	SDL_GPUGraphicsPipeline* upsample_pipeline = nullptr;
+	SDL_GPUSampler* upsample_sampler = nullptr;
 
-	bool create_pipeline(SDL_GPUDevice* gpu);
+	bool create_pipeline(SDL_GPUDevice* gpu, const Render_Settings& settings);
 	void release(SDL_GPUDevice* gpu);
 
+	// The parameters of uniform the tables depend on, clamped away from the degenerate shells.
+	Atmosphere_Lut_Key lut_key() const;
+	// Rebakes and uploads the tables when lut_key changed, must run before the first render.
+	void update(SDL_GPUDevice* gpu, std::vector<SDL_GPUFence*>& fences);
+
 	void imgui();
+	// The scattering into the scaled target of uniform.width x uniform.height.
 	void render(SDL_GPURenderPass* pass, SDL_GPUCommandBuffer* command);
+	// Upsamples what render drew into scaled over the scene, guided by the distance to the planet.
+	void composite(SDL_GPURenderPass* pass, SDL_GPUCommandBuffer* command, SDL_GPUTexture* scaled);
 };
\ No newline at end of file
@@ -0,0 +1,385 @@
+#include "AtmosphereLut.hpp"
+
+#include "Parallel.hpp"
+
+#include <algorithm>
+#include <math.h>
+
+static constexpr u32 Transmittance_Steps = 64;
+static constexpr u32 Scattering_Steps = 64;
+
+static f32 safe_sqrt(f32 x) {
+	return sqrtf(std::max(x, 0.f));
+}
+
+// Texel centers of a table of n texels map to 0 and 1.
+static f32 coord_from_unit(f32 x, u32 n) {
+	return 0.5f / (f32)n + x * (1.f - 1.f / (f32)n);
+}
+
+static f32 unit_from_coord(f32 u, u32 n) {
+	return (u - 0.5f / (f32)n) / (1.f - 1.f / (f32)n);
+}
+
+static Vector3f exp3(Vector3f v) {
+	return { expf(v.x), expf(v.y), expf(v.z) };
+}
+
+// Radii of the atmosphere shell, H is the distance to the top along the horizon at the ground.
+struct Atmosphere_Shell {
+	f32 bottom;
+	f32 top;
+	f32 H;
+	// Lowest mu_s the tables hold. Rays entering from outside on the night side cross lit air
+	// further down, so the whole range is kept.
+	f32 mu_s_min;
+
+	Atmosphere_Shell(const Atmosphere_Lut_Key& key) {
+		bottom = key.planet_radius;
+		top = key.planet_radius + key.thickness;
+		H = safe_sqrt(top * top - bottom * bottom);
+		mu_s_min = -1.f;
+	}
+
+	f32 distance_to_top(f32 r, f32 mu) const {
+		return std::max(-r * mu + safe_sqrt(r * r * (mu * mu - 1.f) + top * top), 0.f);
+	}
+	f32 distance_to_bottom(f32 r, f32 mu) const {
+		return std::max(-r * mu - safe_sqrt(r * r * (mu * mu - 1.f) + bottom * bottom), 0.f);
+	}
+	bool intersects_ground(f32 r, f32 mu) const {
+		return mu < 0.f && r * r * (mu * mu - 1.f) + bottom * bottom >= 0.f;
+	}
+};
+
+// Rayleigh, mie then absorption density at height h, like atmosphere.frag.
+static Vector3f atmosphere_density(const Atmosphere_Lut_Key& k, f32 h) {
+	f32 ray = expf(-h / k.height_ray);
+	f32 mie = expf(-h / k.height_mie);
+	f32 denom = (k.height_absorption - h) / k.absorption_falloff;
+	return { ray, mie, ray / (denom * denom + 1.f) };
+}
+
+static Vector3f extinction(const Atmosphere_Lut_Key& k, Vector3f optical_depth) {
+	return
+		k.ray_beta * optical_depth.x +
+		k.mie_beta * optical_depth.y +
+		k.absorption_beta * optical_depth.z;
+}
+
+// Bilinear and trilinear lookups with clamp to edge, like a linear sampler.
+static void linear_coord(f32 u, u32 n, u32& i0, u32& i1, f32& t) {
+	f32 x = std::clamp(u * (f32)n - 0.5f, 0.f, (f32)(n - 1));
+	i0 = (u32)x;
+	i1 = std::min(i0 + 1, n - 1);
+	t = x - (f32)i0;
+}
+
+static Vector4f lerp(Vector4f a, Vector4f b, f32 t) {
+	return {
+		a.x + (b.x - a.x) * t,
+		a.y + (b.y - a.y) * t,
+		a.z + (b.z - a.z) * t,
+		a.w + (b.w - a.w) * t,
+	};
+}
+
+static Vector4f sample_2d(const Vector4f* texels, u32 w, u32 h, f32 u, f32 v) {
+	u32 x0, x1, y0, y1;
+	f32 tx, ty;
+	linear_coord(u, w, x0, x1, tx);
+	linear_coord(v, h, y0, y1, ty);
+	Vector4f a = lerp(texels[y0 * w + x0], texels[y0 * w + x1], tx);
+	Vector4f b = lerp(texels[y1 * w + x0], texels[y1 * w + x1], tx);
+	return lerp(a, b, ty);
+}
+
+static Vector4f sample_3d(const Vector4f* texels, u32 w, u32 h, u32 d, f32 u, f32 v, f32 s) {
+	u32 z0, z1;
+	f32 tz;
+	linear_coord(s, d, z0, z1, tz);
+	Vector4f a = sample_2d(texels + z0 * w * h, w, h, u, v);
+	Vector4f b = sample_2d(texels + z1 * w * h, w, h, u, v);
+	return lerp(a, b, tz);
+}
+
+// Both tables split mu in two halves, the rays hitting the ground in [0, 0.5] by their distance
+// to the ground and the others in [0.5, 1] by their distance to the top. Each half goes from the
+// nadir or zenith at 0.5 to the horizon at 0 or 1, warped by 1 - sqrt(1 - x) since the scale
+// heights are a few percent of the thickness and the rays grazing the ground change the fastest.
+static f32 horizon_warp(f32 x) {
+	f32 y = std::clamp(1.f - x, 0.f, 1.f);
+	return 1.f - sqrtf(y);
+}
+
+static f32 horizon_unwarp(f32 x) {
+	f32 y = std::clamp(1.f - x, 0.f, 1.f);
+	return 1.f - y * y;
+}
+
+// rho is the distance to the horizon, sqrt(r^2 - bottom^2).
+static f32 mu_coord(const Atmosphere_Shell& shell, f32 r, f32 rho, f32 mu, bool ground, u32 n) {
+	f32 r_mu = r * mu;
+	f32 discriminant = r_mu * r_mu - r * r + shell.bottom * shell.bottom;
+	if (ground) {
+		f32 d = -r_mu - safe_sqrt(discriminant);
+		f32 d_min = r - shell.bottom;
+		f32 d_max = rho;
+		f32 x = d_max <= d_min ? 1.f : (d - d_min) / (d_max - d_min);
+		return 0.5f - 0.5f * coord_from_unit(horizon_warp(x), n / 2);
+	}
+
+	f32 d = -r_mu + safe_sqrt(discriminant + shell.H * shell.H);
+	f32 d_min = shell.top - r;
+	f32 d_max = rho + shell.H;
+	f32 x = d_max <= d_min ? 1.f : (d - d_min) / (d_max - d_min);
+	return 0.5f + 0.5f * coord_from_unit(horizon_warp(x), n / 2);
+}
+
+// Inverse of mu_coord for the texel center u.
+static f32 mu_from_coord(const Atmosphere_Shell& shell, f32 r, f32 u, u32 n, bool& ground) {
+	f32 rho = safe_sqrt(r * r - shell.bottom * shell.bottom);
+	ground = u < 0.5f;
+	if (ground) {
+		f32 d_min = r - shell.bottom;
+		f32 d_max = rho;
+		f32 x = horizon_unwarp(unit_from_coord(1.f - 2.f * u, n / 2));
+		f32 d = d_min + (d_max - d_min) * x;
+		return d == 0.f ? -1.f : std::clamp(-(rho * rho + d * d) / (2.f * r * d), -1.f, 1.f);
+	}
+
+	f32 d_min = shell.top - r;
+	f32 d_max = rho + shell.H;
+	f32 x = horizon_unwarp(unit_from_coord(2.f * u - 1.f, n / 2));
+	f32 d = d_min + (d_max - d_min) * x;
+	f32 H = shell.H;
+	return d == 0.f ? 1.f : std::clamp((H * H - rho * rho - d * d) / (2.f * r * d), -1.f, 1.f);
+}
+
+// Radius of the texel center v, the table is linear in the horizontal distance to the ground.
+static f32 r_from_coord(const Atmosphere_Shell& shell, f32 v, u32 n) {
+	f32 rho = shell.H * unit_from_coord(v, n);
+	return sqrtf(rho * rho + shell.bottom * shell.bottom);
+}
+
+// Texel coordinate along r and the distance to the horizon at r, what the lookups need of r.
+struct Radius_Coord {
+	f32 r;
+	f32 rho;
+	f32 v;
+
+	Radius_Coord() = default;
+	Radius_Coord(const Atmosphere_Shell& shell, f32 radius, u32 n) {
+		r = std::clamp(radius, shell.bottom, shell.top);
+		rho = safe_sqrt(r * r - shell.bottom * shell.bottom);
+		v = coord_from_unit(rho / shell.H, n);
+	}
+};
+
+static Vector3f lookup_transmittance(
+	const Atmosphere_Shell& shell, const std::vector<Vector4f>& texels, Radius_Coord r, f32 mu
+) {
+	constexpr u32 Mu = Atmosphere_Lut::Transmittance_Mu;
+	constexpr u32 R = Atmosphere_Lut::Transmittance_R;
+	f32 u = mu_coord(shell, r.r, r.rho, mu, shell.intersects_ground(r.r, mu), Mu);
+	return sample_2d(texels.data(), Mu, R, u, r.v);
+}
+
+static Vector4f lookup_scattering(
+	const std::vector<Vector4f>& texels,
+	const Atmosphere_Shell& shell,
+	f32 r,
+	f32 mu,
+	f32 mu_s,
+	f32 nu,
+	bool ground
+) {
+	constexpr u32 Nu = Atmosphere_Lut::Scattering_Nu;
+	constexpr u32 Mu_S = Atmosphere_Lut::Scattering_Mu_S;
+	constexpr u32 Mu = Atmosphere_Lut::Scattering_Mu;
+	constexpr u32 R = Atmosphere_Lut::Scattering_R;
+
+	Radius_Coord radius(shell, r, R);
+	f32 u_r = radius.v;
+	f32 u_mu = mu_coord(shell, radius.r, radius.rho, mu, ground, Mu);
+
+	f32 d = shell.distance_to_top(shell.bottom, mu_s);
+	f32 d_min = shell.top - shell.bottom;
+	f32 d_max = shell.H;
+	f32 a = (d - d_min) / (d_max - d_min);
+	f32 A = (shell.distance_to_top(shell.bottom, shell.mu_s_min) - d_min) / (d_max - d_min);
+	f32 u_mu_s = coord_from_unit(std::max(1.f - a / A, 0.f) / (1.f + a), Mu_S);
+	// nu goes by the azimuth of the light around the zenith, from the view ray at 0 to opposite
+	// it at 1, so every slice holds a nu the view and the light can have together.
+	f32 spread = safe_sqrt((1.f - mu * mu) * (1.f - mu_s * mu_s));
+	f32 cos_azimuth = spread > 0.f ? std::clamp((nu - mu * mu_s) / spread, -1.f, 1.f) : 1.f;
+	f32 u_nu = acosf(cos_azimuth) / PIf;
+
+	// nu slices are side by side along x, interpolated by hand.
+	f32 x = u_nu * (f32)(Nu - 1);
+	f32 slice = floorf(x);
+	f32 t = x - slice;
+	Vector4f s0 = sample_3d(
+		texels.data(), Nu * Mu_S, Mu, R, (slice + u_mu_s) / (f32)Nu, u_mu, u_r
+	);
+	Vector4f s1 = sample_3d(
+		texels.data(), Nu * Mu_S, Mu, R, (slice + 1.f + u_mu_s) / (f32)Nu, u_mu, u_r
+	);
+	return lerp(s0, s1, t);
+}
+
+void Atmosphere_Lut::bake(const Atmosphere_Lut_Key& k) {
+	key = k;
+	Atmosphere_Shell shell(key);
+
+	transmittance.resize(Transmittance_Mu * Transmittance_R);
+	parallel_for(Transmittance_R, 1, [&] (usz begin, usz end) {
+		for (usz j = begin; j < end; j += 1)
+		for (u32 i = 0; i < Transmittance_Mu; i += 1) {
+			// Rays hitting the ground go through the planet like the light rays of the shader,
+			// its density is what shadows them.
+			f32 r = r_from_coord(shell, (j + 0.5f) / Transmittance_R, Transmittance_R);
+			bool ground;
+			f32 u = (i + 0.5f) / Transmittance_Mu;
+			f32 mu = mu_from_coord(shell, r, u, Transmittance_Mu, ground);
+			f32 d = shell.distance_to_top(r, mu);
+
+			f32 dx = d / Transmittance_Steps;
+			Vector3f optical_depth = {};
+			for (u32 s = 0; s < Transmittance_Steps; s += 1) {
+				f32 t = (s + 0.5f) * dx;
+				f32 r_t = safe_sqrt(t * t + 2.f * r * mu * t + r * r);
+				optical_depth = optical_depth + atmosphere_density(key, r_t - shell.bottom) * dx;
+			}
+			// Deep under the ground the density overflows, a zero beta would turn it into nan.
+			optical_depth.x = std::min(optical_depth.x, 1e30f);
+			optical_depth.y = std::min(optical_depth.y, 1e30f);
+			optical_depth.z = std::min(optical_depth.z, 1e30f);
+			Vector3f transmission = exp3(extinction(key, optical_depth) * -1.f);
+			transmittance[j * Transmittance_Mu + i] = Vector4f(transmission, 1.f);
+		}
+	});
+
+	// Texels sharing (r, mu) share the view ray, only the light direction changes across the
+	// (nu, mu_s) row so the densities and view attenuation are computed once per row.
+	constexpr u32 Width = Scattering_Nu * Scattering_Mu_S;
+	rayleigh.resize(Width * Scattering_Mu * Scattering_R);
+	mie.resize(Width * Scattering_Mu * Scattering_R);
+	parallel_for(Scattering_Mu * Scattering_R, 4, [&] (usz begin, usz end) {
+		Vector3f step_ray[Scattering_Steps];
+		Vector3f step_mie[Scattering_Steps];
+		f32 step_r[Scattering_Steps];
+		Radius_Coord step_coord[Scattering_Steps];
+		f32 step_t[Scattering_Steps];
+
+		for (usz row = begin; row < end; row += 1) {
+			u32 y = (u32)(row % Scattering_Mu);
+			u32 z = (u32)(row / Scattering_Mu);
+
+			f32 r = r_from_coord(shell, (z + 0.5f) / Scattering_R, Scattering_R);
+			bool ground;
+			f32 mu = mu_from_coord(shell, r, (y + 0.5f) / Scattering_Mu, Scattering_Mu, ground);
+			f32 length = ground ? shell.distance_to_bottom(r, mu) : shell.distance_to_top(r, mu);
+
+			f32 dx = length / Scattering_Steps;
+			Vector3f optical_depth = {};
+			for (u32 s = 0; s < Scattering_Steps; s += 1) {
+				f32 t = (s + 0.5f) * dx;
+				f32 r_t = std::max(safe_sqrt(t * t + 2.f * r * mu * t + r * r), shell.bottom);
+				Vector3f density = atmosphere_density(key, r_t - shell.bottom) * dx;
+				optical_depth = optical_depth + density;
+
+				Vector3f view = exp3(extinction(key, optical_depth) * -1.f);
+				step_ray[s] = view * density.x;
+				step_mie[s] = view * density.y;
+				step_r[s] = r_t;
+				step_coord[s] = Radius_Coord(shell, r_t, Transmittance_R);
+				step_t[s] = t;
+			}
+
+			for (u32 x = 0; x < Width; x += 1) {
+				f32 u_nu = (f32)(x / Scattering_Mu_S) / (Scattering_Nu - 1);
+				f32 u_mu_s = ((x % Scattering_Mu_S) + 0.5f) / Scattering_Mu_S;
+
+				f32 x_mu_s = unit_from_coord(u_mu_s, Scattering_Mu_S);
+				f32 d_min = shell.top - shell.bottom;
+				f32 d_max = shell.H;
+				f32 D = shell.distance_to_top(shell.bottom, shell.mu_s_min);
+				f32 A = (D - d_min) / (d_max - d_min);
+				f32 a = (A - x_mu_s * A) / (1.f + x_mu_s * A);
+				f32 d = d_min + std::min(a, A) * (d_max - d_min);
+				f32 mu_s = d == 0.f
+					? 1.f
+					: std::clamp(
+						(shell.H * shell.H - d * d) / (2.f * shell.bottom * d), -1.f, 1.f
+					);
+
+				f32 spread = safe_sqrt((1.f - mu * mu) * (1.f - mu_s * mu_s));
+				f32 nu = mu * mu_s + spread * cosf(u_nu * PIf);
+
+				Vector3f total_ray = {};
+				Vector3f total_mie = {};
+				for (u32 s = 0; s < Scattering_Steps; s += 1) {
+					f32 mu_s_t = std::clamp((r * mu_s + step_t[s] * nu) / step_r[s], -1.f, 1.f);
+					Vector3f light =
+						::lookup_transmittance(shell, transmittance, step_coord[s], mu_s_t);
+					total_ray = total_ray + step_ray[s] * light;
+					total_mie = total_mie + step_mie[s] * light;
+				}
+
+				usz i = ((usz)z * Scattering_Mu + y) * Width + x;
+				rayleigh[i] = Vector4f(total_ray, optical_depth.x);
+				mie[i] = Vector4f(total_mie, 0.f);
+			}
+		}
+	});
+
+	valid = true;
+}
+
+Vector3f Atmosphere_Lut::lookup_transmittance(f32 r, f32 mu) const {
+	Atmosphere_Shell shell(key);
+	return ::lookup_transmittance(shell, transmittance, Radius_Coord(shell, r, Transmittance_R), mu);
+}
+
+Vector3f Atmosphere_Lut::scattering(
+	Vector3f start, Vector3f dir, Vector3f light_dir, Vector3f ambient_beta, f32 intensity
+) const {
+	constexpr f32 g = 0.7f;
+	Atmosphere_Shell shell(key);
+
+	// From outside the ray starts where it enters the atmosphere.
+	f32 r = length(start);
+	f32 r_mu = dot(start, dir);
+	if (r > shell.top) {
+		f32 discriminant = r_mu * r_mu - r * r + shell.top * shell.top;
+		f32 entry = -r_mu - safe_sqrt(discriminant);
+		if (discriminant < 0.f || entry < 0.f)
+			return {};
+		start = start + dir * entry;
+		r = shell.top;
+		r_mu = dot(start, dir);
+	}
+	r = std::clamp(r, shell.bottom, shell.top);
+
+	f32 mu = std::clamp(r_mu / r, -1.f, 1.f);
+	f32 mu_s = std::clamp(dot(start, light_dir) / r, -1.f, 1.f);
+	f32 nu = dot(dir, light_dir);
+	bool ground = shell.intersects_ground(r, mu);
+
+	Vector4f ray = lookup_scattering(rayleigh, shell, r, mu, mu_s, nu, ground);
+	Vector4f mie_total = lookup_scattering(mie, shell, r, mu, mu_s, nu, ground);
+
+	f32 gg = g * g;
+	f32 phase_ray = 3.f / (16.f * PIf) * (1.f + nu * nu);
+	f32 phase_mie = ground
+		? 0.f
+		: 3.f / (8.f * PIf) * ((1.f - gg) * (nu * nu + 1.f))
+			/ (powf(1.f + gg - 2.f * nu * g, 1.5f) * (2.f + gg));
+
+	return (
+		key.ray_beta * Vector3f(ray) * phase_ray +
+		key.mie_beta * Vector3f(mie_total) * phase_mie +
+		ambient_beta * ray.w
+	) * intensity;
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include "Common.hpp"
+#include "Maths.hpp"
+
+#include <vector>
+
+// Everything the tables depend on, Atmosphere rebakes them when it changes.
+struct Atmosphere_Lut_Key {
+	Vector3f ray_beta;
+	Vector3f mie_beta;
+	Vector3f absorption_beta;
+	f32 planet_radius = 1.f;
+	f32 thickness = 1.f;
+	f32 height_ray = 0.f;
+	f32 height_mie = 0.f;
+	f32 height_absorption = 0.f;
+	f32 absorption_falloff = 1.f;
+
+	bool operator==(const Atmosphere_Lut_Key& other) const = default;
+};
+
+// Single scattering of atmosphere.frag baked on the CPU, with the parametrization of Bruneton's
+// precomputed atmospheric scattering. r is the distance to the planet center, mu the cosine of
+// the view ray with the zenith, mu_s of the light with the zenith and nu of the view ray with the
+// light.
+//
+// transmittance is (mu, r) and holds the transmittance toward the top of the atmosphere, rays
+// hitting the ground go on through the planet like the light rays of the shader. rayleigh and
+// mie are 3D, (nu, mu_s) packed along x then mu then r, with nu stored by the azimuth of the
+// light around the zenith. They hold total_ray and total_mie of calculate_scattering from
+// (r, mu) to the ground or the top of the atmosphere, rayleigh also holds the rayleigh optical
+// depth of that segment in w. The phase functions, betas on the outside, ambient and intensity
+// are applied when sampling, like the shader does.
+struct Atmosphere_Lut {
+	static constexpr u32 Transmittance_Mu = 256;
+	static constexpr u32 Transmittance_R = 64;
+	static constexpr u32 Scattering_Nu = 16;
+	static constexpr u32 Scattering_Mu_S = 64;
+	static constexpr u32 Scattering_Mu = 128;
+	static constexpr u32 Scattering_R = 32;
+
+	Atmosphere_Lut_Key key;
+	bool valid = false;
+
+	std::vector<Vector4f> transmittance;
+	std::vector<Vector4f> rayleigh;
+	std::vector<Vector4f> mie;
+
+	void bake(const Atmosphere_Lut_Key& key);
+
+	Vector3f lookup_transmittance(f32 r, f32 mu) const;
+	// The u_use_lut path of atmosphere.frag, start is relative to the planet center. The rays
+	// end on the ground, where the shader's max_dist ends them.
+	Vector3f scattering(
+		Vector3f start, Vector3f dir, Vector3f light_dir, Vector3f ambient_beta, f32 intensity
+	) const;
+};
@@ -0,0 +1,299 @@
+#include "AtmosphereReference.hpp"
+
+#include "FastMath.hpp"
+#include "Packet.hpp"
+#include "Parallel.hpp"
+
+#include "SDL3/SDL.h"
+
+#include <algorithm>
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+f32 ray_sphere_intersect(Vector3f r0, Vector3f rd, Vector3f s0, f32 sr) {
+	f32 a = dot(rd, rd);
+	Vector3f s0_r0 = r0 - s0;
+	f32 b = 2.f * dot(rd, s0_r0);
+	f32 c = dot(s0_r0, s0_r0) - sr * sr;
+	if (b * b - 4.f * a * c < 0.f)
+		return -1.f;
+	return (-b - sqrtf(b * b - 4.f * a * c)) / (2.f * a);
+}
+
+// Rayleigh, mie then absorption density at height h, absorption follows the rayleigh one.
+static Vector3f atmosphere_density(const Atmosphere::Uniform& u, f32 h) {
+	f32 ray = expf(-h / u.height_ray);
+	f32 mie = expf(-h / u.height_mie);
+	f32 denom = (u.height_absorption - h) / u.absorption_falloff;
+	return { ray, mie, ray / (denom * denom + 1.f) };
+}
+
+static Vector3f exp3(Vector3f v) {
+	return { expf(v.x), expf(v.y), expf(v.z) };
+}
+
+Vector3f atmosphere_scattering(
+	const Atmosphere::Uniform& u,
+	Vector3f start,
+	Vector3f dir,
+	f32 max_dist,
+	Vector3f light_dir,
+	int steps_i,
+	int steps_l
+) {
+	constexpr f32 g = 0.7f;
+	f32 planet_radius = u.planet_radius;
+	f32 atmo_radius = u.planet_radius + u.thickness;
+
+	f32 a = dot(dir, dir);
+	f32 b = 2.f * dot(dir, start);
+	f32 c = dot(start, start) - atmo_radius * atmo_radius;
+	f32 d = b * b - 4.f * a * c;
+	if (d < 0.f)
+		return {};
+
+	f32 ray_start = std::max((-b - sqrtf(d)) / (2.f * a), 0.f);
+	f32 ray_end = std::min((-b + sqrtf(d)) / (2.f * a), max_dist);
+	if (ray_start > ray_end)
+		return {};
+
+	bool allow_mie = max_dist > ray_end;
+	f32 step_size_i = (ray_end - ray_start) / (f32)steps_i;
+	f32 ray_pos_i = ray_start + step_size_i * 0.5f;
+
+	Vector3f total_ray = {};
+	Vector3f total_mie = {};
+	Vector3f opt_i = {};
+
+	f32 mu = dot(dir, light_dir);
+	f32 mumu = mu * mu;
+	f32 gg = g * g;
+	f32 phase_ray = 3.f / (16.f * PIf) * (1.f + mumu);
+	f32 phase_mie = allow_mie
+		? 3.f / (8.f * PIf) * ((1.f - gg) * (mumu + 1.f))
+			/ (powf(1.f + gg - 2.f * mu * g, 1.5f) * (2.f + gg))
+		: 0.f;
+
+	for (int i = 0; i < steps_i; i += 1) {
+		Vector3f pos_i = start + dir * ray_pos_i;
+		f32 height_i = length(pos_i) - planet_radius;
+		Vector3f density = atmosphere_density(u, height_i) * step_size_i;
+		opt_i = opt_i + density;
+
+		// The light ray always leaves through the top of the atmosphere, the planet does not
+		// shadow it, only its density does.
+		a = dot(light_dir, light_dir);
+		b = 2.f * dot(light_dir, pos_i);
+		c = dot(pos_i, pos_i) - atmo_radius * atmo_radius;
+		d = b * b - 4.f * a * c;
+		f32 step_size_l = (-b + sqrtf(d)) / (2.f * a * (f32)steps_l);
+		f32 ray_pos_l = step_size_l * 0.5f;
+
+		Vector3f opt_l = {};
+		for (int l = 0; l < steps_l; l += 1) {
+			Vector3f pos_l = pos_i + light_dir * ray_pos_l;
+			f32 height_l = length(pos_l) - planet_radius;
+			opt_l = opt_l + atmosphere_density(u, height_l) * step_size_l;
+			ray_pos_l += step_size_l;
+		}
+
+		Vector3f attn = exp3(
+			u.ray_beta * -(opt_i.x + opt_l.x) -
+			u.mie_beta * (opt_i.y + opt_l.y) -
+			u.absorption_beta * (opt_i.z + opt_l.z)
+		);
+		total_ray = total_ray + attn * density.x;
+		total_mie = total_mie + attn * density.y;
+		ray_pos_i += step_size_i;
+	}
+
+	return (
+		u.ray_beta * total_ray * phase_ray +
+		u.mie_beta * total_mie * phase_mie +
+		u.ambient_beta * opt_i.x
+	) * u.intensity;
+}
+
+Vector3f atmosphere_pixel(
+	const Atmosphere::Uniform& u, Vector3f dir, int primary_steps, int light_steps
+) {
+	f32 t = ray_sphere_intersect(u.eye, dir, {}, u.planet_radius);
+	if (t < 0)
+		t = u.planet_radius * 1000;
+
+	Vector3f light_dir = normalize(u.planet_world_position) * -1.f;
+	return atmosphere_scattering(u, u.eye, dir, t, light_dir, primary_steps, light_steps);
+}
+
+// atmosphere_scattering for F::Width rays at once, the lanes whose ray misses the atmosphere
+// march an empty segment and come back black.
+template <typename F>
+static Vector3fx<F> atmosphere_scattering_lanes(
+	const Atmosphere::Uniform& u,
+	Vector3fx<F> start,
+	Vector3fx<F> dir,
+	F max_dist,
+	Vector3f light_dir,
+	int steps_i,
+	int steps_l
+) {
+	constexpr f32 g = 0.7f;
+	f32 planet_radius = u.planet_radius;
+	f32 atmo_radius = u.planet_radius + u.thickness;
+
+	F a = dot(dir, dir);
+	F b = dot(dir, start) * 2.f;
+	F c = dot(start, start) - atmo_radius * atmo_radius;
+	F d = b * b - a * c * 4.f;
+	F root = sqrt(max(d, F(0.f)));
+
+	F ray_start = max((-b - root) / (a * 2.f), F(0.f));
+	F ray_exit = (-b + root) / (a * 2.f);
+	F ray_end = min(ray_exit, max_dist);
+	F hit = (d >= 0.f) & (ray_start <= ray_end);
+
+	F allow_mie = max_dist > ray_end;
+	F step_size_i = select(hit, (ray_end - ray_start) / (f32)steps_i, F(0.f));
+	F ray_pos_i = ray_start + step_size_i * 0.5f;
+
+	F mu = dot(dir, Vector3fx<F>::splat(light_dir));
+	F mumu = mu * mu;
+	f32 gg = g * g;
+	F phase_ray = (mumu + 1.f) * (3.f / (16.f * PIf));
+	F phase_base = F(1.f + gg) - mu * (2.f * g);
+	F phase_mie = (mumu + 1.f) * (3.f / (8.f * PIf) * (1.f - gg))
+		/ (phase_base * sqrt(phase_base) * (2.f + gg));
+	phase_mie = select(allow_mie, phase_mie, F(0.f));
+
+	Vector3fx<F> total_ray = { F(0.f), F(0.f), F(0.f) };
+	Vector3fx<F> total_mie = { F(0.f), F(0.f), F(0.f) };
+	Vector3fx<F> opt_i = { F(0.f), F(0.f), F(0.f) };
+	Vector3fx<F> light = Vector3fx<F>::splat(light_dir);
+	f32 light_a = dot(light_dir, light_dir);
+
+	// Same densities as atmosphere_density, on every lane.
+	auto density_at = [&] (F height) -> Vector3fx<F> {
+		F ray = fast_exp(-height / u.height_ray);
+		F mie = fast_exp(-height / u.height_mie);
+		F denom = (F(u.height_absorption) - height) / u.absorption_falloff;
+		return { ray, mie, ray / (denom * denom + 1.f) };
+	};
+
+	for (int i = 0; i < steps_i; i += 1) {
+		Vector3fx<F> pos_i = start + dir * ray_pos_i;
+		Vector3fx<F> density = density_at(length(pos_i) - planet_radius) * step_size_i;
+		opt_i = opt_i + density;
+
+		F light_b = dot(light, pos_i) * 2.f;
+		F light_c = dot(pos_i, pos_i) - atmo_radius * atmo_radius;
+		F light_d = max(light_b * light_b - light_c * (4.f * light_a), F(0.f));
+		F step_size_l = (-light_b + sqrt(light_d)) / (2.f * light_a * (f32)steps_l);
+		F ray_pos_l = step_size_l * 0.5f;
+
+		Vector3fx<F> opt_l = { F(0.f), F(0.f), F(0.f) };
+		for (int l = 0; l < steps_l; l += 1) {
+			Vector3fx<F> pos_l = pos_i + light * ray_pos_l;
+			opt_l = opt_l + density_at(length(pos_l) - planet_radius) * step_size_l;
+			ray_pos_l = ray_pos_l + step_size_l;
+		}
+
+		Vector3fx<F> opt = opt_i + opt_l;
+		Vector3fx<F> attn = {
+			fast_exp(-(opt.x * u.ray_beta.x + opt.y * u.mie_beta.x + opt.z * u.absorption_beta.x)),
+			fast_exp(-(opt.x * u.ray_beta.y + opt.y * u.mie_beta.y + opt.z * u.absorption_beta.y)),
+			fast_exp(-(opt.x * u.ray_beta.z + opt.y * u.mie_beta.z + opt.z * u.absorption_beta.z)),
+		};
+		total_ray = total_ray + attn * density.x;
+		total_mie = total_mie + attn * density.y;
+		ray_pos_i = ray_pos_i + step_size_i;
+	}
+
+	F ray = phase_ray * u.intensity;
+	F mie = phase_mie * u.intensity;
+	F ambient = opt_i.x * u.intensity;
+	return {
+		select(hit, total_ray.x * ray * u.ray_beta.x + total_mie.x * mie * u.mie_beta.x
+			+ ambient * u.ambient_beta.x, F(0.f)),
+		select(hit, total_ray.y * ray * u.ray_beta.y + total_mie.y * mie * u.mie_beta.y
+			+ ambient * u.ambient_beta.y, F(0.f)),
+		select(hit, total_ray.z * ray * u.ray_beta.z + total_mie.z * mie * u.mie_beta.z
+			+ ambient * u.ambient_beta.z, F(0.f)),
+	};
+}
+
+void render_atmosphere(
+	const Atmosphere::Uniform& uniform,
+	const Camera& camera,
+	int primary_steps,
+	int light_steps,
+	Atmosphere_Image& image
+) {
+	constexpr usz W = f32x8::Width;
+	image.pixels.resize((usz)image.width * image.height);
+
+	// Camera::unproject_ray with the matrices inverted once.
+	Matrix4f inverse_projection =
+		inverse(perspective(camera.fov, camera.aspect, camera.near, camera.far));
+	Matrix4f view = lookAt(camera.position, camera.target, camera.up);
+	Vector3f eye = camera.position;
+	Vector3f light_dir = normalize(uniform.planet_world_position) * -1.f;
+
+	usz workers = worker_count(image.height, 1);
+	parallel_workers(workers, [&] (usz w) {
+		Vector3f dirs[W];
+		alignas(32) f32 max_dists[W];
+		Vector3f colors[W];
+
+		for (usz y = w; y < image.height; y += workers)
+		for (usz x0 = 0; x0 < image.width; x0 += W) {
+			// The last block of a row repeats its last pixel.
+			for (usz k = 0; k < W; k += 1) {
+				usz x = std::min<usz>(x0 + k, image.width - 1);
+				f32 ndc_x = ((f32)x + 0.5f) / (f32)image.width * 2.f - 1.f;
+				f32 ndc_y = 1.f - ((f32)y + 0.5f) / (f32)image.height * 2.f;
+
+				Vector4f ray_eye = inverse_projection * Vector4f(ndc_x, ndc_y, -1.f, 1.f);
+				ray_eye.z = -1.f;
+				ray_eye.w = 0.f;
+				dirs[k] = normalize((Vector3f)(view * ray_eye));
+
+				f32 t = ray_sphere_intersect(eye, dirs[k], {}, uniform.planet_radius);
+				max_dists[k] = t < 0 ? uniform.planet_radius * 1000 : t;
+			}
+
+			Vector3fx8 color = atmosphere_scattering_lanes(
+				uniform,
+				Vector3fx8::splat(eye),
+				Vector3fx8::load(dirs),
+				f32x8::load(max_dists),
+				light_dir,
+				primary_steps,
+				light_steps
+			);
+			color.store(colors);
+
+			usz n = std::min<usz>(W, image.width - x0);
+			memcpy(&image.pixels[y * image.width + x0], colors, n * sizeof(Vector3f));
+		}
+	});
+}
+
+bool save_pfm(const Atmosphere_Image& image, const char* path) {
+	char header[64];
+	int header_size =
+		snprintf(header, sizeof(header), "PF\n%u %u\n-1.0\n", image.width, image.height);
+
+	// Little endian floats, rows from the bottom up.
+	usz row_size = (usz)image.width * sizeof(Vector3f);
+	std::vector<u8> data(header_size + row_size * image.height);
+	memcpy(data.data(), header, header_size);
+	for (usz y = 0; y < image.height; y += 1) {
+		memcpy(
+			data.data() + header_size + y * row_size,
+			&image.pixels[(image.height - 1 - y) * image.width],
+			row_size
+		);
+	}
+	return SDL_SaveFile(path, data.data(), data.size());
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include "Atmosphere.hpp"
+#include "Camera.hpp"
+
+#include <vector>
+
+// C++ port of atmosphere.frag, the golden reference the LUTs and shader changes are checked
+// against. Positions are relative to the planet center, like Atmosphere::Uniform::eye.
+
+// Distance along rd to the first intersection with the sphere, -1 when the ray misses it.
+extern f32 ray_sphere_intersect(Vector3f r0, Vector3f rd, Vector3f s0, f32 sr);
+
+// calculate_scattering with a black scene color, the planet at the origin and g = 0.7.
+extern Vector3f atmosphere_scattering(
+	const Atmosphere::Uniform& uniform,
+	Vector3f start,
+	Vector3f dir,
+	f32 max_dist,
+	Vector3f light_dir,
+	int primary_steps,
+	int light_steps
+);
+
+// What main() of atmosphere.frag computes for the view ray dir.
+extern Vector3f atmosphere_pixel(
+	const Atmosphere::Uniform& uniform, Vector3f dir, int primary_steps, int light_steps
+);
+
+// Rows of linear RGB from the top of the view, what the atmosphere pass adds to the color target.
+struct Atmosphere_Image {
+	u32 width = 0;
+	u32 height = 0;
+	std::vector<Vector3f> pixels;
+};
+
+// atmosphere.frag over the whole view of camera, in the planet frame like Main's camera. Pixels
+// are marched 8 at once and rows are interleaved over the workers, the horizon rows cost the
+// most. image.width and image.height are the size to render at.
+extern void render_atmosphere(
+	const Atmosphere::Uniform& uniform,
+	const Camera& camera,
+	int primary_steps,
+	int light_steps,
+	Atmosphere_Image& image
+);
+
+// Portable float map, the simplest HDR format most image tools open.
+extern bool save_pfm(const Atmosphere_Image& image, const char* path);
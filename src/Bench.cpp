@@ -0,0 +1,1209 @@
+#include "Bench.hpp"
+
+#include "AtmosphereLut.hpp"
+#include "AtmosphereReference.hpp"
+#include "Chunk.hpp"
+#include "Cosmos.hpp"
+#include "FastMath.hpp"
+#include "HeightCache.hpp"
+#include "Maths.hpp"
+#include "Noise.hpp"
+#include "Packet.hpp"
+#include "PackedVertex.hpp"
+#include "Planet.hpp"
+#include "RenderScale.hpp"
+#include "RenderSettings.hpp"
+#include "Stars.hpp"
+
+#include "SDL3/SDL.h"
+#include "imgui/imgui.h"
+
+#include <algorithm>
+#include <math.h>
+#include <random>
+#include <stdio.h>
+#include <string>
+#include <vector>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <x86intrin.h>
+#endif
+
+#if defined(_MSC_VER) && !defined(__clang__)
+#define BENCH_NOINLINE __declspec(noinline)
+#else
+#define BENCH_NOINLINE __attribute__((noinline))
+#endif
+
+struct Bench_Result {
+	std::string name;
+	f64 ns_per_item = 0;
+	f64 max_error = 0;
+	// The row fails when max_error is above it, or nan. Negative for the rows that only time.
+	f64 tolerance = -1;
+	f64 cycles_per_item = 0;
+
+	bool checked() const { return tolerance >= 0; }
+	bool failed() const { return checked() && !(max_error <= tolerance); }
+};
+
+struct Bench_Suite {
+	const char* name;
+	void (*run)(std::vector<Bench_Result>& results);
+};
+
+template <typename F>
+static f64 time_ns_per_item(usz items, usz repeat, F&& f) {
+	u64 best = UINT64_MAX;
+	for (usz r = 0; r < repeat; r += 1) {
+		u64 t0 = SDL_GetPerformanceCounter();
+		f();
+		u64 t1 = SDL_GetPerformanceCounter();
+		best = std::min<u64>(best, t1 - t0);
+	}
+	return (f64)best * 1e9 / (f64)SDL_GetPerformanceFrequency() / (f64)items;
+}
+
+static f64 max_abs_error(const std::vector<f32>& a, const std::vector<f32>& b) {
+	f64 err = 0;
+	for (usz i = 0; i < a.size(); i += 1)
+		err = std::max(err, (f64)fabsf(a[i] - b[i]));
+	return err;
+}
+
+// What every Vector3f call cost before the header became inlinable.
+BENCH_NOINLINE static Vector3f outline_normalize(Vector3f v) { return normalize(v); }
+BENCH_NOINLINE static f32 outline_dot(Vector3f a, Vector3f b) { return dot(a, b); }
+BENCH_NOINLINE static Vector3f outline_cross(Vector3f a, Vector3f b) { return cross(a, b); }
+
+// out[i] = dot(cross(normalize(v[i]), axis), zero), the shape of the geo field pass.
+template <typename F>
+static void vector_packet_kernel(
+	const std::vector<Vector3f>& in, std::vector<f32>& out, Vector3f axis, Vector3f zero
+) {
+	using V = Vector3fx<F>;
+	V axis_x = V::splat(axis);
+	V zero_x = V::splat(zero);
+
+	usz i = 0;
+	for (; i + F::Width <= in.size(); i += F::Width) {
+		V v = normalize(V::load(in.data() + i));
+		dot(cross(v, axis_x), zero_x).store(out.data() + i);
+	}
+	for (; i < in.size(); i += 1)
+		out[i] = dot(cross(normalize(in[i]), axis), zero);
+}
+
+static void bench_vector_math(std::vector<Bench_Result>& results) {
+	constexpr usz N = 1 << 20;
+
+	std::mt19937 rng(0);
+	std::uniform_real_distribution<f32> dist(-1.f, 1.f);
+	std::vector<Vector3f> in(N);
+	for (auto& v : in)
+		v = { dist(rng), dist(rng), dist(rng) + 2.f };
+
+	Vector3f axis = normalize(Vector3f{ 0.2f, 1.f, 0.1f });
+	Vector3f zero = normalize(Vector3f{ 1.f, 0.f, -0.2f });
+
+	std::vector<f32> reference(N);
+	std::vector<f32> out(N);
+
+	f64 ns = time_ns_per_item(N, 5, [&] {
+		for (usz i = 0; i < N; i += 1)
+			reference[i] = outline_dot(outline_cross(outline_normalize(in[i]), axis), zero);
+	});
+	results.push_back({ "Vector3f out of line", ns, 0 });
+
+	ns = time_ns_per_item(N, 5, [&] {
+		for (usz i = 0; i < N; i += 1)
+			out[i] = dot(cross(normalize(in[i]), axis), zero);
+	});
+	results.push_back({ "Vector3f inline", ns, max_abs_error(reference, out) });
+
+	ns = time_ns_per_item(N, 5, [&] { vector_packet_kernel<f32x4>(in, out, axis, zero); });
+	results.push_back({ "Vector3fx4", ns, max_abs_error(reference, out) });
+
+	ns = time_ns_per_item(N, 5, [&] { vector_packet_kernel<f32x8>(in, out, axis, zero); });
+	results.push_back({ "Vector3fx8", ns, max_abs_error(reference, out) });
+}
+
+// The 4x4 product before it was vectorized.
+BENCH_NOINLINE static Matrix4f reference_multiply(const Matrix4f& A, const Matrix4f& B) {
+	Matrix4f C;
+	for (size_t i = 0; i < 4; i += 1)
+	for (size_t j = 0; j < 4; j += 1)
+	for (size_t k = 0; k < 4; k += 1) {
+		C.m[i * 4 + j] += A.m[k * 4 + j] * B.m[i * 4 + k];
+	}
+	return C;
+}
+
+static f64 max_abs_error(const Matrix4f& a, const Matrix4f& b) {
+	f64 err = 0;
+	for (usz i = 0; i < 16; i += 1)
+		err = std::max(err, (f64)fabsf(a.m[i] - b.m[i]));
+	return err;
+}
+
+// Relative past a length of 1, projected points close to the camera plane get arbitrarily large.
+static f64 max_error(const std::vector<Vector3f>& a, const std::vector<Vector3f>& b) {
+	f64 err = 0;
+	for (usz i = 0; i < a.size(); i += 1)
+		err = std::max(err, (f64)(length(a[i] - b[i]) / std::max(length(a[i]), 1.f)));
+	return err;
+}
+
+static void bench_transforms(std::vector<Bench_Result>& results) {
+	constexpr usz M = 1 << 14;
+	constexpr usz N = 1 << 20;
+
+	std::mt19937 rng(0);
+	std::uniform_real_distribution<f32> dist(-1.f, 1.f);
+	auto random_vector = [&] { return Vector3f{ dist(rng), dist(rng), dist(rng) }; };
+	auto random_quaternion = [&] {
+		return Quaternionf::axis_angle(normalize(random_vector() + Vector3f{ 0, 0, 2 }), dist(rng) * 3);
+	};
+
+	// Rotation, non uniform scale and translation, the shape of the model matrices.
+	std::vector<Matrix4f> affine(M);
+	for (auto& m : affine) {
+		Matrix4f scale = identity();
+		scale.m[0] = 1.5f + dist(rng);
+		scale.m[5] = 1.5f + dist(rng);
+		scale.m[10] = 1.5f + dist(rng);
+		m = translation(random_vector() * 10) * to_rotation_matrix(random_quaternion()) * scale;
+	}
+
+	std::vector<Matrix4f> reference(M);
+	std::vector<Matrix4f> out(M);
+	f64 err = 0;
+
+	f64 ref_ns = time_ns_per_item(M, 5, [&] {
+		for (usz i = 0; i < M; i += 1)
+			reference[i] = reference_multiply(affine[i], affine[M - 1 - i]);
+	});
+	results.push_back({ "Matrix4f * scalar", ref_ns, 0 });
+	f64 ns = time_ns_per_item(M, 5, [&] {
+		for (usz i = 0; i < M; i += 1)
+			out[i] = affine[i] * affine[M - 1 - i];
+	});
+	for (usz i = 0; i < M; i += 1)
+		err = std::max(err, max_abs_error(reference[i], out[i]));
+	results.push_back({ "Matrix4f * SSE", ns, err, 1e-4 });
+
+	ref_ns = time_ns_per_item(M, 5, [&] {
+		for (usz i = 0; i < M; i += 1)
+			reference[i] = inverse(affine[i]);
+	});
+	results.push_back({ "inverse", ref_ns, 0 });
+	ns = time_ns_per_item(M, 5, [&] {
+		for (usz i = 0; i < M; i += 1)
+			out[i] = affine_inverse(affine[i]);
+	});
+	err = 0;
+	for (usz i = 0; i < M; i += 1)
+		err = std::max(err, max_abs_error(reference[i], out[i]));
+	results.push_back({ "affine_inverse", ns, err, 1e-4 });
+
+	std::vector<Vector3f> in(N);
+	for (auto& v : in)
+		v = random_vector();
+	std::vector<Vector3f> expected(N);
+	std::vector<Vector3f> points(N);
+
+	// Reference goes through the existing Matrix4f * Vector4f, which multiplies by the transpose.
+	Matrix4f view = lookAt({ 30, 20, 10 }, { 0, 0, 0 });
+	Matrix4f mvp = perspective(60, 16.f / 9.f, 0.1f, 100.f) * view * affine[0];
+	Matrix4f mvp_t = transpose(mvp);
+	ref_ns = time_ns_per_item(N, 3, [&] {
+		for (usz i = 0; i < N; i += 1) {
+			Vector4f p = mvp_t * Vector4f(in[i], 1);
+			expected[i] = (Vector3f)p / p.w;
+		}
+	});
+	results.push_back({ "Matrix4f * Vector4f", ref_ns, 0 });
+	ns = time_ns_per_item(N, 3, [&] { transform_points(mvp, in.data(), points.data(), N); });
+	results.push_back({ "transform_points", ns, max_error(expected, points), 1e-6 });
+
+	Quaternionf q = random_quaternion();
+	ref_ns = time_ns_per_item(N, 3, [&] {
+		for (usz i = 0; i < N; i += 1)
+			expected[i] = q * in[i];
+	});
+	results.push_back({ "Quaternionf * Vector3f", ref_ns, 0 });
+	ns = time_ns_per_item(N, 3, [&] { rotate_vectors(q, in.data(), points.data(), N); });
+	results.push_back({ "rotate_vectors", ns, max_error(expected, points), 1e-6 });
+}
+
+// Times libm, the scalar fast version and the 8 wide one over N inputs in [lo, hi], sampled
+// uniformly in the exponent when the range spans many orders of magnitude.
+template <typename Exact, typename Fast, typename Fast_X8>
+static void bench_fast_math_case(
+	std::vector<Bench_Result>& results,
+	const char* name,
+	f32 lo,
+	f32 hi,
+	bool relative,
+	Exact exact,
+	Fast fast,
+	Fast_X8 fast_x8
+) {
+	constexpr usz N = 1 << 20;
+
+	std::mt19937 rng(0);
+	bool log_scale = lo > 0 && hi / lo > 1e6f;
+	std::uniform_real_distribution<f32> dist(log_scale ? logf(lo) : lo, log_scale ? logf(hi) : hi);
+	std::vector<f32> in(N);
+	for (auto& x : in)
+		x = log_scale ? expf(dist(rng)) : dist(rng);
+
+	std::vector<f32> reference(N);
+	std::vector<f32> out(N);
+	auto error = [&] {
+		f64 err = 0;
+		for (usz i = 0; i < N; i += 1) {
+			f64 e = fabs((f64)reference[i] - (f64)out[i]);
+			if (relative)
+				e /= std::max(fabs((f64)reference[i]), 1e-30);
+			err = std::max(err, e);
+		}
+		return err;
+	};
+
+	std::string n = name;
+	f64 ns = time_ns_per_item(N, 3, [&] {
+		for (usz i = 0; i < N; i += 1)
+			reference[i] = exact(in[i]);
+	});
+	results.push_back({ n + " libm", ns, 0 });
+
+	ns = time_ns_per_item(N, 3, [&] {
+		for (usz i = 0; i < N; i += 1)
+			out[i] = fast(in[i]);
+	});
+	results.push_back({ n + " fast", ns, error() });
+
+	ns = time_ns_per_item(N, 3, [&] {
+		for (usz i = 0; i < N; i += f32x8::Width)
+			fast_x8(f32x8::load(in.data() + i)).store(out.data() + i);
+	});
+	results.push_back({ n + " fast x8", ns, error() });
+}
+
+static void bench_fast_math(std::vector<Bench_Result>& results) {
+	bench_fast_math_case(
+		results, "sin", -100.f, 100.f, false,
+		[] (f32 x) { return sinf(x); },
+		[] (f32 x) { return fast_sin(x); },
+		[] (f32x8 x) { return fast_sin(x); }
+	);
+	bench_fast_math_case(
+		results, "cos", -100.f, 100.f, false,
+		[] (f32 x) { return cosf(x); },
+		[] (f32 x) { return fast_cos(x); },
+		[] (f32x8 x) { return fast_cos(x); }
+	);
+	bench_fast_math_case(
+		results, "atan2(y, 0.7)", -10.f, 10.f, false,
+		[] (f32 y) { return atan2f(y, 0.7f); },
+		[] (f32 y) { return fast_atan2(y, 0.7f); },
+		[] (f32x8 y) { return fast_atan2(y, f32x8(0.7f)); }
+	);
+	bench_fast_math_case(
+		results, "exp", -80.f, 80.f, true,
+		[] (f32 x) { return expf(x); },
+		[] (f32 x) { return fast_exp(x); },
+		[] (f32x8 x) { return fast_exp(x); }
+	);
+	bench_fast_math_case(
+		results, "log", 1e-30f, 1e30f, false,
+		[] (f32 x) { return logf(x); },
+		[] (f32 x) { return fast_log(x); },
+		[] (f32x8 x) { return fast_log(x); }
+	);
+	// The base pressure altitude factor.
+	bench_fast_math_case(
+		results, "pow(x, 5.2561)", 0.f, 1.f, true,
+		[] (f32 x) { return powf(x, 5.2561f); },
+		[] (f32 x) { return fast_pow(x, 5.2561f); },
+		[] (f32x8 x) { return fast_pow(x, f32x8(5.2561f)); }
+	);
+}
+
+// Same as time_ns_per_item but in TSC cycles.
+template <typename F>
+static f64 time_cycles_per_item(usz items, usz repeat, F&& f) {
+	u64 best = UINT64_MAX;
+	for (usz r = 0; r < repeat; r += 1) {
+		u64 t0 = __rdtsc();
+		f();
+		u64 t1 = __rdtsc();
+		best = std::min<u64>(best, t1 - t0);
+	}
+	return (f64)best / (f64)items;
+}
+
+static void bench_noise_octaves(std::vector<Bench_Result>& results) {
+	constexpr usz N = 1 << 16;
+	constexpr f32 roughness = 0.3f;
+	constexpr f32 lacunarity = 10.f;
+
+	std::mt19937 rng(0);
+	std::uniform_real_distribution<f32> dist(0.f, 1.f);
+	std::vector<Vector3f> in(N);
+	for (auto& v : in)
+		v = { dist(rng), dist(rng), dist(rng) };
+
+	std::vector<f32> reference(N);
+	std::vector<f32> out(N);
+	Fractal_Weights weights = make_fractal_weights(roughness, lacunarity);
+
+	for (size_t octaves = 1; octaves <= Max_Fractal_Octaves; octaves += 1) {
+		Bench_Result loop;
+		loop.name = "loop, " + std::to_string(octaves) + " octaves";
+		loop.cycles_per_item = time_cycles_per_item(N, 3, [&] {
+			for (usz i = 0; i < N; i += 1)
+				reference[i] = fractal_perlin(in[i].x, in[i].y, in[i].z, octaves, roughness, lacunarity);
+		});
+		results.push_back(loop);
+
+		Fractal_Perlin_Fn noise = get_fractal_perlin(octaves);
+		Bench_Result specialized;
+		specialized.name = "fractal_perlin<" + std::to_string(octaves) + ">";
+		specialized.cycles_per_item = time_cycles_per_item(N, 3, [&] {
+			for (usz i = 0; i < N; i += 1)
+				out[i] = noise(in[i].x, in[i].y, in[i].z, weights);
+		});
+		specialized.max_error = max_abs_error(reference, out);
+		results.push_back(specialized);
+	}
+}
+
+// Every basis alone, then as the default 5 octave height field next to the scalar fractal_perlin
+// it replaces. Errors are against the scalar sample of the same basis.
+static void bench_noise_bases(std::vector<Bench_Result>& results) {
+	constexpr usz N = 1 << 16;
+	constexpr size_t octaves = 5;
+	constexpr f32 roughness = 0.3f;
+	constexpr f32 lacunarity = 10.f;
+
+	std::mt19937 rng(0);
+	std::uniform_real_distribution<f32> dist(0.f, 1.f);
+	std::vector<f32> xs(N);
+	std::vector<f32> ys(N);
+	std::vector<f32> zs(N);
+	for (usz i = 0; i < N; i += 1) {
+		xs[i] = dist(rng);
+		ys[i] = dist(rng);
+		zs[i] = dist(rng);
+	}
+
+	std::vector<f32> reference(N);
+	std::vector<f32> out(N);
+
+	f64 ns = time_ns_per_item(N, 3, [&] {
+		for (usz i = 0; i < N; i += 1)
+			reference[i] = fractal_perlin(xs[i], ys[i], zs[i], octaves, roughness, lacunarity);
+	});
+	results.push_back({ "fractal_perlin, 5 octaves", ns, 0 });
+
+	for (u8 b = 0; b < (u8)Noise_Basis::COUNT; b += 1) {
+		const Noise_Basis_Kernel& kernel = get_noise_basis((Noise_Basis)b);
+		std::string name = kernel.name;
+
+		// Sampled at the second octave frequency so neighbouring samples land in different cells.
+		ns = time_ns_per_item(N, 3, [&] {
+			for (usz i = 0; i < N; i += 1)
+				reference[i] = kernel.sample(xs[i] * lacunarity, ys[i] * lacunarity, zs[i] * lacunarity);
+		});
+		results.push_back({ name, ns, 0 });
+
+		ns = time_ns_per_item(N, 3, [&] {
+			for (usz i = 0; i < N; i += f32x8::Width) {
+				kernel.sample_x8(
+					f32x8::load(xs.data() + i) * lacunarity,
+					f32x8::load(ys.data() + i) * lacunarity,
+					f32x8::load(zs.data() + i) * lacunarity
+				).store(out.data() + i);
+			}
+		});
+		results.push_back({ name + " x8", ns, max_abs_error(reference, out) });
+
+		for (usz i = 0; i < N; i += 1) {
+			f32 scale = 1.f;
+			f32 amp = 1.f;
+			reference[i] = 0.f;
+			for (size_t o = 0; o < octaves; o += 1) {
+				reference[i] += kernel.sample(xs[i] * scale, ys[i] * scale, zs[i] * scale) * amp;
+				amp *= roughness;
+				scale *= lacunarity;
+			}
+		}
+		ns = time_ns_per_item(N, 3, [&] {
+			fractal_noise(
+				(Noise_Basis)b,
+				xs.data(),
+				ys.data(),
+				zs.data(),
+				out.data(),
+				N,
+				octaves,
+				roughness,
+				lacunarity
+			);
+		});
+		results.push_back({ name + " fractal_noise", ns, max_abs_error(reference, out) });
+	}
+}
+
+// Baking is paid once per parameter set, sampling once per tile of every regeneration.
+static void bench_height_cache(std::vector<Bench_Result>& results) {
+	constexpr usz N = 1 << 16;
+	constexpr u32 resolution = 256;
+	Height_Cache_Key key = { (u32)Noise_Basis::Perlin, 5, 0.3f, 10.f, resolution };
+
+	Height_Cube cube;
+	f64 ns = time_ns_per_item(6 * resolution * resolution, 1, [&] { cube.bake(key); });
+	results.push_back({ "bake, per texel", ns, 0 });
+
+	std::mt19937 rng(0);
+	std::normal_distribution<f32> dist;
+	std::vector<Vector3f> dirs(N);
+	std::vector<f32> xs(N);
+	std::vector<f32> ys(N);
+	std::vector<f32> zs(N);
+	for (usz i = 0; i < N; i += 1) {
+		dirs[i] = normalize(Vector3f(dist(rng), dist(rng), dist(rng)));
+		Vector3f p = dirs[i] * 0.5f + Vector3f(0.5f, 0.5f, 0.5f);
+		xs[i] = p.x;
+		ys[i] = p.y;
+		zs[i] = p.z;
+	}
+
+	std::vector<f32> reference(N);
+	std::vector<f32> out(N);
+	ns = time_ns_per_item(N, 3, [&] {
+		fractal_noise(
+			Noise_Basis::Perlin,
+			xs.data(),
+			ys.data(),
+			zs.data(),
+			reference.data(),
+			N,
+			key.octave,
+			key.roughness,
+			key.lacunarity
+		);
+	});
+	results.push_back({ "fractal_noise", ns, 0 });
+
+	for (size_t level = 0; level < 3; level += 1) {
+		ns = time_ns_per_item(N, 3, [&] {
+			for (usz i = 0; i < N; i += 1)
+				out[i] = cube.sample(dirs[i], level);
+		});
+		results.push_back({
+			"sample, " + std::to_string(resolution >> level) + " texels",
+			ns,
+			max_abs_error(reference, out)
+		});
+	}
+}
+
+// fill_climate against fill_year_temperature, fill_base_pressure then fill_macro_wind on the tiles
+// of an order 5 planet, with and without fast math. The error counts the tiles whose climate
+// fields do not have the same bits, any of them fails.
+static void bench_fused_climate(std::vector<Bench_Result>& results) {
+	constexpr usz Order = 5;
+	Planet planet;
+	planet.order = Order;
+	planet.generate_icosphere(nullptr, Order);
+	const Planet::Generation_Param& param = planet.generation_param;
+	planet.fill_height(param.noise_basis, param.octave, param.roughness, param.lacunarity, 0);
+	planet.find_water(param.water_level, param.peak_level);
+	planet.categorize_tiles();
+
+	for (bool fast_math : { false, true }) {
+		planet.generation_param.fast_math = fast_math;
+		usz mismatches = 0;
+		f64 ns = time_ns_per_item(planet.tiles.size(), 1, [&] {
+			mismatches = planet.check_climate();
+		});
+
+		char name[128];
+		snprintf(
+			name,
+			sizeof(name),
+			"%s, %zu tiles, both",
+			fast_math ? "fast math" : "libm",
+			planet.tiles.size()
+		);
+		results.push_back({ name, ns, (f64)mismatches, 0 });
+	}
+}
+
+// Same planet generated with libm and with fast math. Errors are relative past 1, the terrain
+// does not go through fast math and has to match exactly, the climate only moves by fast_pow.
+static void bench_fast_math_planet(std::vector<Bench_Result>& results) {
+	constexpr usz Order = 5;
+	Planet exact;
+	exact.order = Order;
+	exact.generate_icosphere(nullptr, Order);
+	Planet fast = exact;
+
+	Planet::Generation_Param param = exact.generation_param;
+	param.height_cache_resolution = 0;
+	param.fast_math = false;
+	f64 exact_ns = time_ns_per_item(exact.tiles.size(), 1, [&] {
+		exact.generate_from_mesh(param);
+	});
+	param.fast_math = true;
+	f64 fast_ns = time_ns_per_item(fast.tiles.size(), 1, [&] {
+		fast.generate_from_mesh(param);
+	});
+	results.push_back({ "libm, generate", exact_ns, 0 });
+
+	auto compare = [&] (const char* name, f64 tolerance, auto get) {
+		f64 max_error = 0;
+		for (usz i = 0; i < exact.tiles.size(); i++) {
+			f64 a = get(fast.tiles[i]);
+			f64 b = get(exact.tiles[i]);
+			max_error = std::max(max_error, std::abs(a - b) / std::max(std::abs(b), 1.0));
+		}
+		results.push_back({ name, fast_ns, max_error, tolerance });
+	};
+	compare("fast math, height", 0, [] (const Tile& t) { return t.height; });
+	compare("fast math, kind", 0, [] (const Tile& t) { return (f64)t.kind; });
+	compare("fast math, year temperature", 0, [] (const Tile& t) { return t.year_temperature; });
+	compare("fast math, heat quantity", 0, [] (const Tile& t) { return t.heat_quantity; });
+	compare("fast math, base pressure", 1e-5, [] (const Tile& t) { return t.base_pressure; });
+	compare("fast math, macro wind x", 1e-5, [] (const Tile& t) { return t.macro_wind.x; });
+	compare("fast math, macro wind y", 1e-5, [] (const Tile& t) { return t.macro_wind.y; });
+	compare("fast math, macro wind z", 1e-5, [] (const Tile& t) { return t.macro_wind.z; });
+	compare("fast math, humidity", 1e-5, [] (const Tile& t) { return t.humidity; });
+}
+
+// Synthetic camera above the planet, going down. The name holds what the selection picked, the
+// error counts its broken invariants: the chunks have to cover the sphere exactly once, each
+// under max_screen_error unless at max_depth, and each parent over it since it was split.
+static void bench_chunk_lod(std::vector<Bench_Result>& results) {
+	Chunk_Lod_Param param;
+	std::vector<Vector3f> no_tile_corners;
+
+	for (f32 distance : { 10.f, 2.75f, 1.1f, 1.01f, 1.001f }) {
+		Chunk_View view = { { 0, 0, -distance }, 45.5f, 768.f };
+		std::vector<Chunk_Key> keys;
+		f64 ns = time_ns_per_item(1, 5, [&] { select_chunks(view, param, keys); });
+
+		u32 max_depth = 0;
+		for (Chunk_Key key : keys)
+			max_depth = std::max(max_depth, key.depth);
+
+		// In texels of the deepest level, the 20 faces hold 20 * 4^max_depth of them.
+		u64 covered = 0;
+		f64 violations = 0;
+		for (Chunk_Key key : keys) {
+			covered += (u64)1 << (2 * (param.max_depth - key.depth));
+			bool fine_enough =
+				key.depth >= param.max_depth ||
+				chunk_screen_error(key, view, param) <= param.max_screen_error;
+			violations += !fine_enough;
+			if (key.depth > 0) {
+				Chunk_Key parent = { key.face, key.depth - 1, key.path >> 2 };
+				violations += chunk_screen_error(parent, view, param) <= param.max_screen_error;
+			}
+		}
+		violations += covered != (u64)20 << (2 * param.max_depth);
+
+		Chunk_Cache cache;
+		usz triangles = 0;
+		for (Chunk_Key key : keys)
+			triangles += cache.get(key, param, no_tile_corners).vertices.size() / 3;
+
+		char name[128];
+		snprintf(
+			name,
+			sizeof(name),
+			"d %.3f: %zu chunks, depth %u, %zu tris, select",
+			distance,
+			keys.size(),
+			max_depth,
+			triangles
+		);
+		results.push_back({ name, ns, violations, 0 });
+	}
+
+	// 4^subdivision surface triangles and 3 * 2^(subdivision + 1) of skirts.
+	Chunk_Geometry geometry;
+	usz triangles = 0;
+	f64 ns = time_ns_per_item(20, 3, [&] {
+		for (u32 face = 0; face < 20; face += 1)
+			generate_chunk({ face, 3, 0 }, param, no_tile_corners, geometry);
+		triangles = geometry.vertices.size() / 3;
+	});
+	usz expected = ((usz)1 << (2 * param.subdivision)) + 3 * ((usz)2 << param.subdivision);
+	results.push_back({
+		"generate, per chunk of " + std::to_string(triangles) + " tris",
+		ns,
+		fabs((f64)triangles - (f64)expected),
+		0
+	});
+}
+
+// Culling of the chunks selected for a few camera poses, max err counts the chunks culled while
+// one of their surface vertices is both inside the clip volume and above the horizon. Culling is
+// meant to be conservative, any such chunk fails.
+static void bench_chunk_culling(std::vector<Bench_Result>& results) {
+	struct Pose {
+		const char* name;
+		Vector3f eye;
+		Vector3f target;
+	};
+	Pose poses[] = {
+		{ "orbit", { 0, 0, -2.75f }, { 0, 0, 0 } },
+		{ "looking away", { 0, 0, -2.75f }, { 0, 0, -5.f } },
+		{ "near the surface", { 0, 0.3f, -1.01f }, { 0, 1.f, -1.f } },
+	};
+
+	Chunk_Lod_Param param;
+	std::vector<Vector3f> no_tile_corners;
+	Chunk_Cache cache;
+	f32 fov = 45.5f;
+
+	for (const Pose& pose : poses) {
+		Matrix4f projection = perspective(fov, 16.f / 9.f, 0.001f, 100.f);
+		Matrix4f clip = projection * lookAt(pose.eye, pose.target, { 0, 1, 0 });
+		Frustum frustum = frustum_from_clip(clip);
+		Matrix4f clip_t = transpose(clip);
+
+		std::vector<Chunk_Key> keys;
+		select_chunks({ pose.eye, fov, 768.f }, param, keys);
+		std::vector<const Chunk_Geometry*> chunks;
+		f32 occluder = 1.f;
+		for (Chunk_Key key : keys) {
+			chunks.push_back(&cache.get(key, param, no_tile_corners));
+			occluder = std::min(occluder, chunks.back()->bounds.surface_radius);
+		}
+
+		std::vector<Chunk_Cull> culls(chunks.size());
+		f64 ns = time_ns_per_item(chunks.size(), 10, [&] {
+			for (usz i = 0; i < chunks.size(); i += 1)
+				culls[i] = cull_chunk(chunks[i]->bounds, frustum, pose.eye, occluder);
+		});
+
+		usz frustum_culled = 0;
+		usz horizon_culled = 0;
+		f64 false_culls = 0;
+		for (usz i = 0; i < chunks.size(); i += 1) {
+			if (culls[i] == Chunk_Cull::Visible)
+				continue;
+			frustum_culled += culls[i] == Chunk_Cull::Frustum;
+			horizon_culled += culls[i] == Chunk_Cull::Horizon;
+
+			for (const Chunk_Vertex& v : chunks[i]->vertices) {
+				Vector4f c = clip_t * Vector4f(v.position.x, v.position.y, v.position.z, 1.f);
+				bool in_clip =
+					c.w > 0 &&
+					fabsf(c.x) <= c.w && fabsf(c.y) <= c.w && fabsf(c.z) <= c.w;
+				if (in_clip && dot(normalize(v.position), pose.eye) >= 1.f) {
+					false_culls += 1;
+					break;
+				}
+			}
+		}
+
+		char name[128];
+		snprintf(
+			name,
+			sizeof(name),
+			"%s: %zu chunks, %zu frustum, %zu horizon",
+			pose.name,
+			chunks.size(),
+			frustum_culled,
+			horizon_culled
+		);
+		results.push_back({ name, ns, false_culls, 0 });
+	}
+}
+
+// Round trip of the planet vertices through Packed_Vertex, on the vertices of a deep chunk
+// quantized in its bounds. Position error is in units of the planet radius, normal error in
+// degrees, the palette and barycenter have to come back exactly. The tolerances are a step of
+// each encoding: a snorm16 step along the diagonal of the quantization cube, a unorm16 step and
+// 1.5 degrees for the 2 octahedral bytes, which measure under 1.
+static void bench_vertex_packing(std::vector<Bench_Result>& results) {
+	Chunk_Lod_Param param;
+	std::vector<Vector3f> no_tile_corners;
+	Chunk_Geometry chunk;
+	generate_chunk({ 7, 8, 0x1234 }, param, no_tile_corners, chunk);
+	Vertex_Quantization q = { chunk.bounds.center, chunk.bounds.radius };
+
+	std::mt19937 rng(0);
+	std::uniform_real_distribution<f32> dist(0.f, 1.f);
+	std::vector<Vertex_Attributes> in(chunk.vertices.size());
+	for (usz i = 0; i < in.size(); i += 1) {
+		const Chunk_Vertex& v = chunk.vertices[i];
+		in[i] = { v.position, v.normal, dist(rng), (u32)(i % 64), v.barycenter };
+	}
+
+	std::vector<Packed_Vertex> packed(in.size());
+	f64 ns = time_ns_per_item(in.size(), 10, [&] {
+		for (usz i = 0; i < in.size(); i += 1)
+			packed[i] = pack_vertex(in[i], q, 1);
+	});
+
+	f64 position_error = 0;
+	f64 normal_error = 0;
+	f64 scalar_error = 0;
+	f64 exact_error = 0;
+	for (usz i = 0; i < in.size(); i += 1) {
+		Vertex_Attributes out = unpack_vertex(packed[i], q);
+		position_error = std::max(position_error, (f64)length(out.position - in[i].position));
+		f32 c = std::clamp(dot(out.normal, normalize(in[i].normal)), -1.f, 1.f);
+		normal_error = std::max(normal_error, (f64)(acosf(c) * RAD_DEGf));
+		scalar_error = std::max(scalar_error, (f64)fabsf(out.scalar - in[i].scalar));
+		exact_error += out.palette_index != in[i].palette_index;
+		exact_error += out.barycenter != in[i].barycenter;
+	}
+
+	char name[128];
+	snprintf(
+		name,
+		sizeof(name),
+		"pack, %zu -> %zu bytes, pos",
+		sizeof(Vertex_Attributes),
+		sizeof(Packed_Vertex)
+	);
+	results.push_back({ name, ns, position_error, q.scale * sqrtf(3.f) / 32767.f });
+	results.push_back({ "normal, degrees", 0, normal_error, 1.5 });
+	results.push_back({ "scalar", 0, scalar_error, 1.0 / 65535.0 });
+	results.push_back({ "palette and barycenter", 0, exact_error, 0 });
+
+	// The whole sphere of directions, folded hemisphere included.
+	normal_error = 0;
+	for (usz i = 0; i < 1 << 16; i += 1) {
+		Vector3f n = { dist(rng) * 2 - 1, dist(rng) * 2 - 1, dist(rng) * 2 - 1 };
+		if (length(n) < 1e-3f)
+			continue;
+		n = normalize(n);
+		f32 c = std::clamp(dot(decode_octahedral(encode_octahedral(n)), n), -1.f, 1.f);
+		normal_error = std::max(normal_error, (f64)(acosf(c) * RAD_DEGf));
+	}
+	results.push_back({ "octahedral, degrees", 0, normal_error, 1.5 });
+}
+
+// Pixels of random views around the planet from a few distances, half of them toward the planet.
+// Errors are max_error of the colors against the raymarch with 512 x 128 steps, for the tables
+// and for the 32 x 8 steps of atmosphere.frag. The tables fail past the error of the raymarch
+// they replace.
+static void bench_atmosphere_lut(std::vector<Bench_Result>& results) {
+	constexpr usz N = 256;
+	Atmosphere atmosphere;
+	atmosphere.uniform.planet_world_position = { 3.f, 1.f, 0.5f };
+	Atmosphere::Uniform& uniform = atmosphere.uniform;
+
+	Atmosphere_Lut lut;
+	constexpr usz Texels =
+		Atmosphere_Lut::Scattering_Nu * Atmosphere_Lut::Scattering_Mu_S *
+		Atmosphere_Lut::Scattering_Mu * Atmosphere_Lut::Scattering_R;
+	f64 ns = time_ns_per_item(Texels, 1, [&] { lut.bake(atmosphere.lut_key()); });
+	results.push_back({ "bake, per scattering texel", ns, 0 });
+
+	std::mt19937 rng(0);
+	std::uniform_real_distribution<f32> dist(-1.f, 1.f);
+	Vector3f light_dir = normalize(uniform.planet_world_position) * -1.f;
+	for (f32 distance : { 2.75f, 1.5f, 1.01f }) {
+		std::vector<Vector3f> eyes(N);
+		std::vector<Vector3f> dirs(N);
+		for (usz i = 0; i < N; i += 1) {
+			eyes[i] = normalize(Vector3f(dist(rng), dist(rng), dist(rng))) * distance;
+			dirs[i] = normalize(Vector3f(dist(rng), dist(rng), dist(rng)));
+			if (i % 2 == 0)
+				dirs[i] = normalize(normalize(eyes[i] * -1.f) + dirs[i] * 0.5f);
+		}
+
+		std::vector<Vector3f> reference(N);
+		std::vector<Vector3f> shader(N);
+		std::vector<Vector3f> table(N);
+		for (usz i = 0; i < N; i += 1) {
+			uniform.eye = eyes[i];
+			reference[i] = atmosphere_pixel(uniform, dirs[i], 512, 128);
+		}
+		f64 shader_ns = time_ns_per_item(N, 3, [&] {
+			for (usz i = 0; i < N; i += 1) {
+				uniform.eye = eyes[i];
+				shader[i] = atmosphere_pixel(uniform, dirs[i], 32, 8);
+			}
+		});
+		f64 table_ns = time_ns_per_item(N, 3, [&] {
+			for (usz i = 0; i < N; i += 1) {
+				table[i] = lut.scattering(
+					eyes[i], dirs[i], light_dir, uniform.ambient_beta, uniform.intensity
+				);
+			}
+		});
+
+		std::string name = "at " + std::to_string(distance).substr(0, 4);
+		f64 shader_error = max_error(reference, shader);
+		results.push_back({ name + ", raymarch 32 x 8", shader_ns, shader_error });
+		results.push_back({
+			name + ", tables", table_ns, max_error(reference, table), shader_error
+		});
+	}
+}
+
+// A 256 x 144 view from low orbit, the shader steps. Error of the 8 wide render against the
+// scalar port, the name holds the throughput.
+static void bench_atmosphere_reference(std::vector<Bench_Result>& results) {
+	Atmosphere::Uniform uniform;
+	uniform.planet_world_position = { 3.f, 1.f, 0.5f };
+	Camera camera;
+	camera.position = { 0.f, 0.f, -1.3f };
+	camera.target = { 0.f, 0.f, 0.f };
+	camera.up = { 1.f, 0.f, 0.f };
+	uniform.eye = camera.position;
+
+	Atmosphere_Image image;
+	image.width = 256;
+	image.height = 144;
+	usz n = (usz)image.width * image.height;
+
+	std::vector<Vector3f> scalar(n);
+	f64 scalar_ns = time_ns_per_item(n, 1, [&] {
+		for (u32 y = 0; y < image.height; y += 1)
+		for (u32 x = 0; x < image.width; x += 1) {
+			Vector3f dir = camera.unproject_ray(
+				(x + 0.5f) / image.width, (y + 0.5f) / image.height
+			);
+			scalar[y * image.width + x] = atmosphere_pixel(uniform, dir, 32, 8);
+		}
+	});
+	f64 simd_ns = time_ns_per_item(n, 3, [&] {
+		render_atmosphere(uniform, camera, 32, 8, image);
+	});
+
+	char name[128];
+	snprintf(name, sizeof(name), "scalar, %.2f Mpixel/s", 1e3 / scalar_ns);
+	results.push_back({ name, scalar_ns, 0 });
+	snprintf(name, sizeof(name), "8 wide, threaded, %.2f Mpixel/s", 1e3 / simd_ns);
+	results.push_back({ name, simd_ns, max_error(scalar, image.pixels) });
+}
+
+// Inverse of cube_texel_direction, the texel of the face d points at.
+static void cube_texel_of(Vector3f d, u32 size, u32& f, u32& i, u32& j) {
+	f32 ax = fabsf(d.x), ay = fabsf(d.y), az = fabsf(d.z);
+	f32 s, t;
+	if (ax >= ay && ax >= az) {
+		f = d.x > 0 ? 0 : 1;
+		s = (d.x > 0 ? -d.z : d.z) / ax;
+		t = -d.y / ax;
+	} else if (ay >= az) {
+		f = d.y > 0 ? 2 : 3;
+		s = d.x / ay;
+		t = (d.y > 0 ? d.z : -d.z) / ay;
+	} else {
+		f = d.z > 0 ? 4 : 5;
+		s = (d.z > 0 ? d.x : -d.x) / az;
+		t = -d.y / az;
+	}
+	i = std::min<u32>((u32)((s * 0.5f + 0.5f) * size), size - 1);
+	j = std::min<u32>((u32)((t * 0.5f + 0.5f) * size), size - 1);
+}
+
+// Generation and bake of the sky, error of the baked texels against the sum over every star at a
+// sample of texel centers, the stars the old shader found there. The texels are f16, whose
+// rounding is 4.9e-4 relative, the bake fails past 1e-3.
+static void bench_star_catalog(std::vector<Bench_Result>& results) {
+	constexpr u32 Size = 512;
+
+	std::vector<Star> stars;
+	f64 generate_ns = time_ns_per_item(1, 1, [&] { generate_star_catalog(0, stars); });
+
+	std::vector<u16> texels;
+	f64 bake_ns = time_ns_per_item(6 * Size * Size, 1, [&] {
+		bake_star_cube(stars, Size, texels);
+	});
+
+	std::mt19937 rng(0);
+	std::uniform_int_distribution<u32> texel(0, Size - 1);
+	std::uniform_int_distribution<u32> face(0, 5);
+	std::vector<Vector3f> reference;
+	std::vector<Vector3f> baked;
+	// Half of the samples right on a star, most random texels are empty sky.
+	for (usz k = 0; k < 2048; k += 1) {
+		u32 f = face(rng);
+		u32 i = texel(rng);
+		u32 j = texel(rng);
+		if (k % 2 == 0)
+			cube_texel_of(stars[rng() % stars.size()].direction, Size, f, i, j);
+
+		Vector3f dir = normalize(cube_texel_direction(f, i, j, Size));
+		Vector3f sum = {};
+		for (const Star& star : stars)
+			sum = sum + star_radiance(star, dir);
+		reference.push_back(sum);
+
+		const u16* t = texels.data() + (((usz)f * Size + j) * Size + i) * 4;
+		baked.push_back({ f16_to_f32(t[0]), f16_to_f32(t[1]), f16_to_f32(t[2]) });
+	}
+
+	Vector3f sun = blackbody_color(5800.f);
+	char name[128];
+	snprintf(name, sizeof(name), "generate, %zu stars", stars.size());
+	results.push_back({ name, generate_ns, 0 });
+	snprintf(name, sizeof(name), "bake %u cube, per texel", Size);
+	results.push_back({ name, bake_ns, max_error(reference, baked), 1e-3 });
+	snprintf(name, sizeof(name), "blackbody 5800 K, %.2f %.2f %.2f", sun.x, sun.y, sun.z);
+	results.push_back({ name, 0, 0 });
+}
+
+// The sky cube against the old shader evaluated at texel centers, away from the grid lines where
+// the bake averages several samples, empty_color aside since cosmos.frag adds it. The stars go
+// through f16 once alone and once with the grid, the bake fails past twice the 1e-3 of the star
+// catalog. Then a round trip through the disk cache, which has to be exact.
+static void bench_cosmos_sky(std::vector<Bench_Result>& results) {
+	constexpr u32 Size = 256;
+
+	Cosmos cosmos;
+	f64 ns = time_ns_per_item(6 * Size * Size, 1, [&] { cosmos.bake_cubemap(Size); });
+
+	std::vector<Vector3f> reference;
+	std::vector<Vector3f> baked;
+	for (u32 f = 0; f < 6; f += 1)
+	for (u32 j = 0; j < Size; j += 3)
+	for (u32 i = 0; i < Size; i += 3) {
+		Vector3f dir = normalize(cube_texel_direction(f, i, j, Size));
+		Vector3f grid = cosmos_grid(dir);
+		if (grid.z > 1e-4f)
+			continue;
+
+		Vector3f sum = grid * 0.1f;
+		for (const Star& star : cosmos.stars)
+			sum = sum + star_radiance(star, dir);
+		reference.push_back(sum);
+
+		const u16* t = cosmos.sky_texels.data() + (((usz)f * Size + j) * Size + i) * 4;
+		baked.push_back({ f16_to_f32(t[0]), f16_to_f32(t[1]), f16_to_f32(t[2]) });
+	}
+	results.push_back({
+		"bake " + std::to_string(Size) + " cube, per texel", ns, max_error(reference, baked), 2e-3
+	});
+
+	std::vector<u16> texels = cosmos.sky_texels;
+	bool saved = cosmos.save_cubemap();
+	Cosmos loaded;
+	bool ok = false;
+	ns = time_ns_per_item(6 * Size * Size, 1, [&] { ok = loaded.load_cubemap(cosmos.sky_key); });
+	// 1 when any texel came back different.
+	f64 error = ok && loaded.sky_texels == texels ? 0 : 1;
+	results.push_back({
+		saved && ok ? "load from cache, per texel" : "cache failed", ns, error, 0
+	});
+}
+
+// Render_Scale against a simulated gpu: a frame costs fixed_ms plus scaled_ms * scale^2, with
+// some noise. The error is how far the last frames are from the band around the target, or from
+// the clamped scale when the target is out of reach, and any of it fails. The name holds the
+// frames it took to settle.
+static void bench_render_scale(std::vector<Bench_Result>& results) {
+	struct Scenario {
+		const char* name;
+		f32 fixed_ms;
+		f32 scaled_ms;
+		f32 start_scale;
+	};
+	Scenario scenarios[] = {
+		{ "heavy atmosphere", 4.f, 40.f, 1.f },
+		{ "light atmosphere", 4.f, 8.f, 0.25f },
+		{ "fixed cost over the target", 20.f, 10.f, 1.f },
+	};
+
+	for (const Scenario& scenario : scenarios) {
+		Render_Scale scale;
+		scale.dynamic = true;
+		scale.scale = scenario.start_scale;
+
+		std::mt19937 rng(0);
+		std::uniform_real_distribution<f32> noise(0.95f, 1.05f);
+		auto frame_ms = [&] (f32 s) {
+			return (scenario.fixed_ms + scenario.scaled_ms * s * s) * noise(rng);
+		};
+
+		constexpr usz Frames = 2000;
+		usz last_change = 0;
+		f64 ns = time_ns_per_item(Frames, 1, [&] {
+			for (usz i = 0; i < Frames; i += 1) {
+				if (scale.update(frame_ms(scale.scale)))
+					last_change = i;
+			}
+		});
+
+		f32 ms = scenario.fixed_ms + scenario.scaled_ms * scale.scale * scale.scale;
+		f32 low = scale.target_ms * (1.f - scale.band);
+		f32 high = scale.target_ms * (1.f + scale.band);
+		f64 error = 0;
+		if (ms > high && scale.scale > scale.min_scale)
+			error = (ms - high) / scale.target_ms;
+		if (ms < low && scale.scale < scale.max_scale)
+			error = (low - ms) / scale.target_ms;
+
+		char name[128];
+		snprintf(
+			name,
+			sizeof(name),
+			"%s, scale %.3f after %zu frames",
+			scenario.name,
+			scale.scale,
+			last_change
+		);
+		results.push_back({ name, ns, error, 0 });
+	}
+}
+
+// render_target_memory at 1920 x 1080 with the atmosphere at half scale, against the sizes SDL
+// computes for the same textures, to the byte. The name holds the total.
+static void bench_render_target_memory(std::vector<Bench_Result>& results) {
+	constexpr u32 Width = 1920;
+	constexpr u32 Height = 1080;
+	constexpr u32 Scaled_Width = Width / 2;
+	constexpr u32 Scaled_Height = Height / 2;
+
+	struct Configuration {
+		const char* name;
+		Render_Settings settings;
+	};
+	Configuration configurations[] = {
+		{ "RGBA32F 8x", {} },
+		{
+			"RGBA16F 4x",
+			{
+				.color_format = SDL_GPU_TEXTUREFORMAT_R16G16B16A16_FLOAT,
+				.sample_count = SDL_GPU_SAMPLECOUNT_4,
+			}
+		},
+		{
+			"R11G11B10F 1x, D16",
+			{
+				.color_format = SDL_GPU_TEXTUREFORMAT_R11G11B10_UFLOAT,
+				.depth_format = SDL_GPU_TEXTUREFORMAT_D16_UNORM,
+				.sample_count = SDL_GPU_SAMPLECOUNT_1,
+			}
+		},
+	};
+
+	for (const Configuration& configuration : configurations) {
+		const Render_Settings& settings = configuration.settings;
+		Render_Target_Memory memory;
+		f64 ns = time_ns_per_item(1, 3, [&] {
+			memory = render_target_memory(settings, Width, Height, Scaled_Width, Scaled_Height);
+		});
+
+		u64 samples = sample_count_value(settings.sample_count);
+		u64 color = SDL_CalculateGPUTextureFormatSize(settings.color_format, Width, Height, 1);
+		u64 depth = SDL_CalculateGPUTextureFormatSize(settings.depth_format, Width, Height, 1);
+		u64 scaled = SDL_CalculateGPUTextureFormatSize(
+			settings.scaled_format, Scaled_Width, Scaled_Height, 1
+		);
+		u64 expected = (samples > 1 ? color * samples : 0) + depth * samples + color + scaled;
+
+		char name[128];
+		snprintf(
+			name,
+			sizeof(name),
+			"%s, %.1f MiB",
+			configuration.name,
+			memory.total() / (1024.0 * 1024.0)
+		);
+		results.push_back({ name, ns, fabs((f64)memory.total() - (f64)expected), 0 });
+	}
+}
+
+static Bench_Suite suites[] = {
+	{ "Vector math", bench_vector_math },
+	{ "Transforms", bench_transforms },
+	{ "Fast math", bench_fast_math },
+	{ "Noise octaves", bench_noise_octaves },
+	{ "Noise bases", bench_noise_bases },
+	{ "Height cache", bench_height_cache },
+	{ "Fused climate", bench_fused_climate },
+	{ "Fast math planet", bench_fast_math_planet },
+	{ "Chunk LOD", bench_chunk_lod },
+	{ "Chunk culling", bench_chunk_culling },
+	{ "Vertex packing", bench_vertex_packing },
+	{ "Atmosphere LUT", bench_atmosphere_lut },
+	{ "Atmosphere reference", bench_atmosphere_reference },
+	{ "Star catalog", bench_star_catalog },
+	{ "Cosmos sky", bench_cosmos_sky },
+	{ "Render scale", bench_render_scale },
+	{ "Render target memory", bench_render_target_memory },
+};
+
+void bench_imgui() {
+	constexpr usz Suite_Count = sizeof(suites) / sizeof(suites[0]);
+	static std::vector<Bench_Result> results[Suite_Count];
+
+	auto count_checks = [] (const std::vector<Bench_Result>& rows, usz& checks, usz& failed) {
+		for (const Bench_Result& r : rows) {
+			checks += r.checked();
+			failed += r.failed();
+		}
+	};
+
+	if (ImGui::Button("Run all")) {
+		for (usz s = 0; s < Suite_Count; s += 1) {
+			results[s].clear();
+			suites[s].run(results[s]);
+		}
+	}
+	usz checks = 0;
+	usz failed = 0;
+	for (usz s = 0; s < Suite_Count; s += 1)
+		count_checks(results[s], checks, failed);
+	if (checks > 0) {
+		ImGui::SameLine();
+		ImGui::Text("%zu checks, %zu failed", checks, failed);
+	}
+
+	for (usz s = 0; s < Suite_Count; s += 1) {
+		ImGui::PushID((int)s);
+		defer { ImGui::PopID(); };
+
+		ImGui::SeparatorText(suites[s].name);
+		if (ImGui::Button("Run")) {
+			results[s].clear();
+			suites[s].run(results[s]);
+		}
+		usz suite_checks = 0;
+		usz suite_failed = 0;
+		count_checks(results[s], suite_checks, suite_failed);
+		if (suite_checks > 0) {
+			ImGui::SameLine();
+			ImGui::Text("%zu checks, %zu failed", suite_checks, suite_failed);
+		}
+
+		for (auto& r : results[s]) {
+			if (r.cycles_per_item > 0) {
+				ImGui::Text(
+					"%-24s % 8.1f cycles/item  max err %.3g",
+					r.name.c_str(),
+					r.cycles_per_item,
+					r.max_error
+				);
+			} else {
+				ImGui::Text(
+					"%-24s % 8.3f ns/item  max err %.3g", r.name.c_str(), r.ns_per_item, r.max_error
+				);
+			}
+			if (r.checked()) {
+				ImGui::SameLine();
+				if (r.failed())
+					ImGui::Text("FAIL, over %.3g", r.tolerance);
+				else
+					ImGui::Text("ok");
+			}
+		}
+	}
+}
@@ -0,0 +1,8 @@
+#pragma once
+
+#include "Common.hpp"
+
+// In app micro benchmarks, every suite runs on demand from the Debug window and reports its
+// timing next to the error against its reference implementation. Rows with a tolerance are
+// checks, they fail past it and Run all counts the failures of every suite.
+extern void bench_imgui();
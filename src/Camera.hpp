@@ -0,0 +1,40 @@
+#pragma once
+
+#include "Common.hpp"
+#include "Maths.hpp"
+
+struct Camera {
+	Vector3f position;
+	Vector3f target;
+	Vector3f up;
+
+	f32 speed = 100.f;
+
+	f32 fov = 45.5f;
+	f32 aspect = 16.0f / 9.0f;
+	f32 near = 0.1f;
+	f32 far = 100.0f;
+
+	Vector3f unproject_ray_ndc(f32 x, f32 y) const {
+		Vector3f ndc = { x, y, -1.0f };
+
+		Matrix4f proj = perspective(fov, aspect, near, far);
+		Matrix4f view = lookAt(position, target, up);
+
+		Vector4f ray_eye = inverse(proj) * Vector4f(ndc, 1.0f);
+		ray_eye.z = -1.0f;
+		ray_eye.w = 0.0f;
+
+		Vector3f ray_world = (Vector3f)(view * ray_eye);
+		return normalize(ray_world);
+	}
+	Vector3f unproject_ray(f32 x, f32 y) const {
+		Vector3f ndc = {
+			2.0f * x - 1.0f,
+			1.0f - 2.0f * y,
+			-1.0f
+		};
+		return unproject_ray_ndc(ndc.x, ndc.y);
+
+	}
+};
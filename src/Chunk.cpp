@@ -0,0 +1,314 @@
+#include "Chunk.hpp"
+
+#include <algorithm>
+#include <math.h>
+
+static constexpr f32 Chunk_Skirt_Factor = 0.1f;
+
+const u8 Icosahedron_Faces[20][3] = {
+	{ 0, 11, 5 }, { 0, 5, 1 }, { 0, 1, 7 }, { 0, 7, 10 }, { 0, 10, 11 },
+	{ 11, 10, 2 }, { 5, 11, 4 }, { 1, 5, 9 }, { 7, 1, 8 }, { 10, 7, 6 },
+	{ 3, 9, 4 }, { 3, 4, 2 }, { 3, 2, 6 }, { 3, 6, 8 }, { 3, 8, 9 },
+	{ 9, 8, 1 }, { 4, 9, 5 }, { 2, 4, 11 }, { 6, 2, 10 }, { 8, 6, 7 },
+};
+
+Vector3f icosahedron_vertex(size_t i) {
+	f32 f = (1 + sqrtf(5)) / 2;
+	static const Vector3f vertices[12] = {
+		{ -1, +f, +0 }, { +1, +f, +0 }, { -1, -f, +0 }, { +1, -f, +0 },
+		{ +0, -1, +f }, { +0, +1, +f }, { +0, -1, -f }, { +0, +1, -f },
+		{ +f, +0, -1 }, { +f, +0, +1 }, { -f, +0, -1 }, { -f, +0, +1 },
+	};
+	return normalize(vertices[i]);
+}
+
+// Corners of the child k among the corners and edge midpoints (v1, v2, v3, ab, bc, ca).
+static constexpr u8 Child_Corners[4][3] = { { 0, 3, 5 }, { 1, 4, 3 }, { 2, 5, 4 }, { 3, 4, 5 } };
+
+// A triangle while descending the quadtree. Above the tile order it only has its sphere corners,
+// from the tile order down it also has its corners in the barycentric frame of its tile.
+struct Chunk_Triangle {
+	Vector3f p[3];
+	Vector3f bary[3];
+	u64 index = 0; // face then 2 bits per level
+	u32 level = 0;
+	u32 edges = 0; // bit i set when the edge (i, i + 1) lies on the chunk border
+};
+
+static void enter_tile(Chunk_Triangle& t, u32 tile_order) {
+	if (t.level != tile_order)
+		return;
+	t.bary[0] = { 1, 0, 0 };
+	t.bary[1] = { 0, 1, 0 };
+	t.bary[2] = { 0, 0, 1 };
+}
+
+static Chunk_Triangle root_triangle(u32 face, u32 tile_order) {
+	Chunk_Triangle t;
+	for (size_t i = 0; i < 3; i += 1)
+		t.p[i] = icosahedron_vertex(Icosahedron_Faces[face][i]);
+	t.index = face;
+	t.edges = 0b111;
+	enter_tile(t, tile_order);
+	return t;
+}
+
+static Chunk_Triangle child_triangle(const Chunk_Triangle& t, u32 k, u32 tile_order) {
+	Vector3f p[6] = {
+		t.p[0],
+		t.p[1],
+		t.p[2],
+		normalize((t.p[0] + t.p[1]) * 0.5f),
+		normalize((t.p[1] + t.p[2]) * 0.5f),
+		normalize((t.p[2] + t.p[0]) * 0.5f),
+	};
+	Vector3f bary[6] = {
+		t.bary[0],
+		t.bary[1],
+		t.bary[2],
+		(t.bary[0] + t.bary[1]) * 0.5f,
+		(t.bary[1] + t.bary[2]) * 0.5f,
+		(t.bary[2] + t.bary[0]) * 0.5f,
+	};
+
+	Chunk_Triangle c;
+	for (size_t i = 0; i < 3; i += 1) {
+		c.p[i] = p[Child_Corners[k][i]];
+		c.bary[i] = bary[Child_Corners[k][i]];
+	}
+	c.index = t.index << 2 | k;
+	c.level = t.level + 1;
+
+	// The first and last edges of the corner children run along two edges of the parent.
+	u32 e = t.edges;
+	switch (k) {
+	case 0: c.edges = (e & 1) | (e & 4); break;
+	case 1: c.edges = ((e >> 1) & 1) | ((e & 1) << 2); break;
+	case 2: c.edges = ((e >> 2) & 1) | (((e >> 1) & 1) << 2); break;
+	default: c.edges = 0; break;
+	}
+
+	enter_tile(c, tile_order);
+	return c;
+}
+
+static Chunk_Triangle chunk_triangle(Chunk_Key key, u32 tile_order) {
+	Chunk_Triangle t = root_triangle(key.face, tile_order);
+	for (u32 d = 0; d < key.depth; d += 1) {
+		u32 k = (u32)(key.path >> (2 * (key.depth - 1 - d))) & 3;
+		t = child_triangle(t, k, tile_order);
+	}
+	t.edges = 0b111;
+	return t;
+}
+
+static u32 pack_barycenter(Vector3f b) {
+	u32 x = (u32)(std::clamp(b.x, 0.f, 1.f) * 255.f + 0.5f);
+	u32 y = (u32)(std::clamp(b.y, 0.f, 1.f) * 255.f + 0.5f);
+	u32 z = (u32)(std::clamp(b.z, 0.f, 1.f) * 255.f + 0.5f);
+	return x | y << 8 | z << 16;
+}
+
+f32 chunk_screen_error(Chunk_Key key, const Chunk_View& view, const Chunk_Lod_Param& param) {
+	Chunk_Triangle t = chunk_triangle(key, UINT32_MAX);
+	Vector3f center = normalize(t.p[0] + t.p[1] + t.p[2]);
+	f32 bound = 0;
+	for (size_t i = 0; i < 3; i += 1)
+		bound = std::max(bound, length(t.p[i] - center));
+
+	// Coarser than the tiles a triangle shows a single tile for several, the error is its size.
+	// Finer it is only off by how far its edges cut under the sphere.
+	f32 edge = length(t.p[1] - t.p[0]) / (f32)(1u << param.subdivision);
+	u32 leaf_level = key.depth + param.subdivision;
+	f32 error = leaf_level < param.tile_order ? edge : edge * edge / 8;
+
+	f32 distance = std::max(length(view.eye - center) - bound, 1e-4f);
+	f32 pixels_per_unit = view.viewport_height / (2 * tanf(view.fov * DEG_RADf / 2));
+	return error / distance * pixels_per_unit;
+}
+
+void select_chunks(
+	const Chunk_View& view, const Chunk_Lod_Param& param, std::vector<Chunk_Key>& out
+) {
+	out.clear();
+	u32 max_depth = std::min(param.max_depth, Max_Chunk_Depth);
+
+	std::vector<Chunk_Key> stack;
+	for (u32 face = 20; face > 0; face -= 1)
+		stack.push_back({ face - 1, 0, 0 });
+
+	while (!stack.empty()) {
+		Chunk_Key key = stack.back();
+		stack.pop_back();
+
+		bool fine_enough =
+			key.depth >= max_depth ||
+			chunk_screen_error(key, view, param) <= param.max_screen_error;
+		if (fine_enough) {
+			out.push_back(key);
+			continue;
+		}
+		for (u32 k = 4; k > 0; k -= 1)
+			stack.push_back(key.child(k - 1));
+	}
+}
+
+// Bounding sphere and cone, surface_radius is left to generate_chunk.
+static Chunk_Bounds chunk_bounds(const std::vector<Chunk_Vertex>& vertices) {
+	Chunk_Bounds bounds;
+	if (vertices.empty())
+		return bounds;
+
+	Vector3f sum = { 0, 0, 0 };
+	for (const Chunk_Vertex& v : vertices)
+		sum = sum + v.position;
+	bounds.center = sum / (f32)vertices.size();
+	bounds.axis = normalize(bounds.center);
+
+	f32 min_cos = 1.f;
+	for (const Chunk_Vertex& v : vertices) {
+		bounds.radius = std::max(bounds.radius, length(v.position - bounds.center));
+		min_cos = std::min(min_cos, dot(v.position, bounds.axis) / length(v.position));
+	}
+	bounds.cone_angle = acosf(std::clamp(min_cos, -1.f, 1.f));
+	return bounds;
+}
+
+void generate_chunk(
+	Chunk_Key key,
+	const Chunk_Lod_Param& param,
+	const std::vector<Vector3f>& tile_corners,
+	Chunk_Geometry& out
+) {
+	u32 tile_order = param.tile_order;
+	u32 leaf_level = key.depth + param.subdivision;
+	Chunk_Triangle root = chunk_triangle(key, tile_order);
+	f32 skirt = 1.f - length(root.p[1] - root.p[0]) * Chunk_Skirt_Factor;
+
+	out.key = key;
+	out.vertices.clear();
+	size_t leaves = (size_t)1 << (2 * param.subdivision);
+	size_t border_edges = param.skirts ? (size_t)3 << param.subdivision : 0;
+	out.vertices.reserve(leaves * 3 + border_edges * 6);
+
+	f32 surface_radius = 1.f;
+	auto emit = [&] (const Chunk_Triangle& t) {
+		u32 tile;
+		Vector3f p[3];
+		u32 barycenter[3];
+		if (t.level >= tile_order) {
+			tile = (u32)(t.index >> (2 * (t.level - tile_order)));
+			for (size_t i = 0; i < 3; i += 1) {
+				p[i] = t.p[i];
+				if (!tile_corners.empty()) {
+					const Vector3f* c = tile_corners.data() + (size_t)tile * 3;
+					Vector3f b = t.bary[i];
+					p[i] = normalize(c[0] * b.x + c[1] * b.y + c[2] * b.z);
+				}
+				barycenter[i] = pack_barycenter(t.bary[i]);
+			}
+		} else {
+			// The tile under the center, reached by always taking the middle child.
+			u32 levels = tile_order - t.level;
+			tile = (u32)((t.index << (2 * levels)) | ((1ull << (2 * levels)) - 1));
+			for (size_t i = 0; i < 3; i += 1) {
+				p[i] = t.p[i];
+				barycenter[i] = 0xFFu << (8 * i);
+			}
+		}
+
+		// Same winding and unnormalized normal as the tile mesh.
+		Vector3f normal = cross(p[2] - p[0], p[1] - p[0]);
+		surface_radius = std::min(surface_radius, fabsf(dot(normalize(normal), p[0])));
+		for (size_t i = 0; i < 3; i += 1)
+			out.vertices.push_back({ p[i], normal, tile, barycenter[i] });
+
+		for (size_t i = 0; i < 3 && param.skirts; i += 1) {
+			if (!(t.edges & (1u << i)))
+				continue;
+			size_t j = (i + 1) % 3;
+			Chunk_Vertex a = { p[i], normal, tile, barycenter[i] };
+			Chunk_Vertex b = { p[j], normal, tile, barycenter[j] };
+			Chunk_Vertex a_low = { p[i] * skirt, normal, tile, barycenter[i] };
+			Chunk_Vertex b_low = { p[j] * skirt, normal, tile, barycenter[j] };
+			out.vertices.push_back(a);
+			out.vertices.push_back(b);
+			out.vertices.push_back(b_low);
+			out.vertices.push_back(a);
+			out.vertices.push_back(b_low);
+			out.vertices.push_back(a_low);
+		}
+	};
+
+	// Depth first in child order so the leaves come out in the tile mesh order.
+	std::vector<Chunk_Triangle> stack;
+	stack.push_back(root);
+	while (!stack.empty()) {
+		Chunk_Triangle t = stack.back();
+		stack.pop_back();
+
+		if (t.level >= leaf_level) {
+			emit(t);
+			continue;
+		}
+		for (u32 k = 4; k > 0; k -= 1)
+			stack.push_back(child_triangle(t, k - 1, tile_order));
+	}
+
+	out.bounds = chunk_bounds(out.vertices);
+	out.bounds.surface_radius = surface_radius;
+}
+
+Chunk_Cull cull_chunk(
+	const Chunk_Bounds& bounds, const Frustum& frustum, Vector3f eye, f32 occluder_radius
+) {
+	if (!sphere_in_frustum(frustum, bounds.center, bounds.radius))
+		return Chunk_Cull::Frustum;
+
+	// Seen from eye, the occluder ball hides every direction more than acos(r / |eye|) away from
+	// eye, a point at radius 1 above it pokes out by another acos(r). The cone direction closest
+	// to the eye is angle(axis, eye) - cone_angle away.
+	f32 distance = length(eye);
+	if (distance <= occluder_radius)
+		return Chunk_Cull::Visible;
+
+	f32 to_eye = acosf(std::clamp(dot(bounds.axis, eye) / distance, -1.f, 1.f));
+	f32 horizon = acosf(occluder_radius / distance) + acosf(std::min(occluder_radius, 1.f));
+	if (to_eye - bounds.cone_angle > horizon)
+		return Chunk_Cull::Horizon;
+	return Chunk_Cull::Visible;
+}
+
+const Chunk_Geometry& Chunk_Cache::get(
+	Chunk_Key key, const Chunk_Lod_Param& param, const std::vector<Vector3f>& tile_corners
+) {
+	Entry& entry = entries[key.packed()];
+	if (entry.last_used == 0) {
+		generate_chunk(key, param, tile_corners, entry.geometry);
+		generated += 1;
+	}
+	entry.last_used = frame + 1;
+	return entry.geometry;
+}
+
+void Chunk_Cache::evict() {
+	if (entries.size() <= capacity)
+		return;
+
+	std::vector<std::pair<u64, u64>> by_age;
+	by_age.reserve(entries.size());
+	for (auto& [key, entry] : entries) {
+		if (entry.last_used <= frame)
+			by_age.push_back({ entry.last_used, key });
+	}
+
+	usz excess = std::min(entries.size() - capacity, by_age.size());
+	std::nth_element(by_age.begin(), by_age.begin() + excess, by_age.end());
+	for (usz i = 0; i < excess; i += 1)
+		entries.erase(by_age[i].second);
+}
+
+void Chunk_Cache::clear() {
+	entries.clear();
+	generated = 0;
+}
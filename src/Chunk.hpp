@@ -0,0 +1,120 @@
+#pragma once
+
+#include "Common.hpp"
+#include "Maths.hpp"
+
+#include <unordered_map>
+#include <vector>
+
+// The 20 faces of the icosahedron generate_icosphere starts from, every chunk descends from one.
+extern const u8 Icosahedron_Faces[20][3];
+extern Vector3f icosahedron_vertex(size_t i);
+
+constexpr u32 Max_Chunk_Depth = 24;
+
+// A triangle of the icosphere quadtree. Children are numbered like generate_icosphere emits them,
+// (v1, ab, ca), (v2, bc, ab), (v3, ca, bc) then (ab, bc, ca), and path holds 2 bits per level with
+// the first level in the highest bits. So the tile of the order n mesh containing a triangle of
+// depth d >= n is (face << 2n) | (path >> 2(d - n)).
+struct Chunk_Key {
+	u32 face = 0;
+	u32 depth = 0;
+	u64 path = 0;
+
+	Chunk_Key child(u32 k) const { return { face, depth + 1, path << 2 | k }; }
+	u64 packed() const { return path << 10 | (u64)depth << 5 | face; }
+};
+
+// Camera in the planet frame, the planet being the unit sphere at the origin.
+struct Chunk_View {
+	Vector3f eye;
+	f32 fov = 45.f; // vertical, in degrees
+	f32 viewport_height = 768.f; // in pixels
+};
+
+struct Chunk_Lod_Param {
+	// A chunk is split while its triangles are off by more than this many pixels on screen.
+	f32 max_screen_error = 2.f;
+	// Quadtree levels inside a chunk, a chunk holds 4^subdivision triangles.
+	u32 subdivision = 5;
+	u32 max_depth = 10;
+	// Order of the tile mesh the chunk triangles take their tile from.
+	u32 tile_order = 6;
+	// Strips along the chunk borders, down toward the center, hiding the cracks against
+	// neighbours of another depth. They cost 3 * 2^(subdivision + 1) triangles per chunk.
+	bool skirts = true;
+};
+
+struct Chunk_Vertex {
+	Vector3f position;
+	Vector3f normal;
+	u32 tile;
+	// Position inside the tile triangle, 3 unorm bytes, for the tile edges of planet.frag.
+	u32 barycenter;
+};
+
+// Bounding sphere and cone of directions of every vertex of a chunk, skirts included.
+struct Chunk_Bounds {
+	Vector3f center;
+	f32 radius = 0.f;
+	Vector3f axis;
+	f32 cone_angle = 0.f; // max angle between axis and a vertex direction, in radians
+	// Lowest point of the surface triangles, skirts excluded. The surface of all the chunks
+	// encloses the ball of the smallest one, which is what hides the far side.
+	f32 surface_radius = 1.f;
+};
+
+// Triangle list of a chunk, every triangle followed by its skirts when it is on the border.
+struct Chunk_Geometry {
+	Chunk_Key key;
+	Chunk_Bounds bounds;
+	std::vector<Chunk_Vertex> vertices;
+};
+
+// Screen space error in pixels of drawing the chunk instead of its children.
+extern f32 chunk_screen_error(Chunk_Key key, const Chunk_View& view, const Chunk_Lod_Param& param);
+// The chunks to draw, a cut of the quadtree where every chunk is under max_screen_error.
+extern void select_chunks(
+	const Chunk_View& view, const Chunk_Lod_Param& param, std::vector<Chunk_Key>& out
+);
+// tile_corners are the 3 corners of every tile of the order param.tile_order mesh, triangles at or
+// below the tile order are placed inside their tile so the chunks follow the jittered mesh. Empty
+// places everything on the plain subdivided sphere.
+extern void generate_chunk(
+	Chunk_Key key,
+	const Chunk_Lod_Param& param,
+	const std::vector<Vector3f>& tile_corners,
+	Chunk_Geometry& out
+);
+
+enum class Chunk_Cull : u8 {
+	Visible = 0,
+	Frustum,
+	Horizon,
+};
+
+// Conservative, only culls a chunk whose bounding sphere is out of the frustum or which is
+// entirely behind the ball of occluder_radius. frustum and eye are in the planet frame.
+extern Chunk_Cull cull_chunk(
+	const Chunk_Bounds& bounds, const Frustum& frustum, Vector3f eye, f32 occluder_radius
+);
+
+// Chunks generated on first use and kept until they are the least recently used past capacity.
+struct Chunk_Cache {
+	struct Entry {
+		Chunk_Geometry geometry;
+		u64 last_used = 0;
+	};
+
+	std::unordered_map<u64, Entry> entries;
+	usz capacity = 2048;
+	u64 frame = 0;
+	usz generated = 0;
+
+	const Chunk_Geometry& get(
+		Chunk_Key key, const Chunk_Lod_Param& param, const std::vector<Vector3f>& tile_corners
+	);
+	// Drops the least recently used chunks down to capacity, never the ones used this frame.
+	void evict();
+	void clear();
+};
@@ -1,134 +1,308 @@
 #include "Cosmos.hpp"
+#include "AssetLoader.hpp"
+#include "DiskCache.hpp"
 #include "Maths.hpp"
+#include "Parallel.hpp"
+#include <algorithm>
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include <string>
 #include <vector>
 #include "imgui/imgui.h"
 
 
-bool Cosmos::create_pipeline(SDL_GPUDevice* gpu) {
-	SDL_GPUShader* vertex_shader = nullptr;
-	SDL_GPUShader* fragment_shader = nullptr;
-	{
-		size_t vertex_size = 0;
-		void* plain_vertex = SDL_LoadFile("assets/shaders/vert_cosmos.spv", &vertex_size);
-		defer {
-			SDL_free(plain_vertex);
-		};
-
-		size_t fragment_size = 0;
-		void* plain_fragment = SDL_LoadFile("assets/shaders/frag_cosmos.spv", &fragment_size);
-		defer {
-			SDL_free(plain_fragment);
-		};
-
-		if (!plain_vertex || !plain_fragment) {
-			printf("Failed to load shader files: %s\n", SDL_GetError());
-			return false;
-		}
+bool Cosmos::create_pipeline(SDL_GPUDevice* gpu, const Render_Settings& settings) {
+	Pipeline_Desc desc = FullscreenQuad::pipeline_desc();
+	desc.vertex = { .path = "assets/shaders/vert_cosmos.spv", .num_uniform_buffers = 2 };
+	desc.fragment = {
+		.path = "assets/shaders/frag_cosmos.spv", .num_samplers = 1, .num_uniform_buffers = 2
+	};
+	desc.sample_count = settings.sample_count;
+	desc.depth_stencil_state = {
+		.compare_op = SDL_GPU_COMPAREOP_LESS_OR_EQUAL,
+		.write_mask = 0xFF,
+		.enable_depth_test = true,
+		.enable_depth_write = true,
+		.enable_stencil_test = false,
+	};
+	desc.color_targets = { { .format = settings.color_format } };
+	desc.depth_stencil_format = settings.depth_format;
+	desc.has_depth_stencil_target = true;
+	pipeline = Pipeline_Factory::factory.create(gpu, desc);
+	return pipeline != nullptr;
+}
+void Cosmos::release(SDL_GPUDevice* gpu){
+	// The pipeline belongs to Pipeline_Factory::factory.
+	pipeline = nullptr;
 
-		SDL_GPUShaderCreateInfo vertex_info = {};
-		vertex_info.code_size = vertex_size;
-		vertex_info.code = (u8*)plain_vertex;
-		vertex_info.entrypoint = "main";
-		vertex_info.format = SDL_GPU_SHADERFORMAT_SPIRV;
-		vertex_info.stage = SDL_GPU_SHADERSTAGE_VERTEX;
-		vertex_info.num_samplers = 0;
-		vertex_info.num_storage_textures = 0;
-		vertex_info.num_storage_buffers = 0;
-		vertex_info.num_uniform_buffers = 2;
-		vertex_shader = SDL_CreateGPUShader(gpu, &vertex_info);
-
-		SDL_GPUShaderCreateInfo fragment_info = {};
-		fragment_info.code_size = fragment_size;
-		fragment_info.code = (u8*)plain_fragment;
-		fragment_info.entrypoint = "main";
-		fragment_info.format = SDL_GPU_SHADERFORMAT_SPIRV;
-		fragment_info.stage = SDL_GPU_SHADERSTAGE_FRAGMENT;
-		fragment_info.num_samplers = 0;
-		fragment_info.num_storage_textures = 0;
-		fragment_info.num_storage_buffers = 0;
-		fragment_info.num_uniform_buffers = 2;
-		fragment_shader = SDL_CreateGPUShader(gpu, &fragment_info);
-	}
+	if (sky_cube)
+		SDL_ReleaseGPUTexture(gpu, sky_cube);
+	if (sky_sampler)
+		SDL_ReleaseGPUSampler(gpu, sky_sampler);
+	sky_cube = nullptr;
+	sky_sampler = nullptr;
+	uploaded = false;
+}
 
-	if (!vertex_shader || !fragment_shader) {
-		printf("Failed to create shaders: %s\n", SDL_GetError());
-		return false;
+static constexpr u32 Sky_Cache_Magic = 0x594B5343; // "CSKY"
+static constexpr u32 Sky_Cache_Version = 2;
+static constexpr const char* Sky_Cache_Directory = Disk_Cache_Directory;
+// About 48 MB each at 1024.
+static constexpr usz Sky_Cache_Max_Files = 4;
+
+struct Sky_Cache_Header {
+	u32 magic;
+	u32 version;
+	Cosmos::Sky_Key key;
+};
+
+void sky_cache_path(const Cosmos::Sky_Key& key, char* path, size_t size) {
+	// FNV-1a of the key, every field is 4 bytes so there is no padding to hash.
+	u32 hash = 2166136261u;
+	const u8* bytes = (const u8*)&key;
+	for (size_t i = 0; i < sizeof(key); i += 1) {
+		hash ^= bytes[i];
+		hash *= 16777619u;
 	}
+	snprintf(path, size, "%s/sky_%u_%08x.bin", Sky_Cache_Directory, key.size, hash);
+}
 
-	SDL_GPUColorTargetDescription color_target_desc[] = {
-		{
-			.format = SDL_GPU_TEXTUREFORMAT_R32G32B32A32_FLOAT,
-		}
-	};
-	SDL_GPUVertexBufferDescription vertex_buffer_desc[] = {
-		{
-			.slot = 0,
-			.pitch = sizeof(Vector2f),
-			.input_rate = SDL_GPU_VERTEXINPUTRATE_VERTEX
-		}
-	};
-	SDL_GPUVertexAttribute vertex_attributes[] = {
-		{
-			.location = 0,
-			.buffer_slot = 0,
-			.format = SDL_GPU_VERTEXELEMENTFORMAT_FLOAT2,
-			.offset = 0,
+// Angle to the nearest line of the grid, 32 meridians and 16 parallels like cosmos.frag.
+static f32 grid_distance(Vector3f dir) {
+	constexpr f32 Dim = 1.f / 16.f * 3.1415926f;
+
+	f32 theta = acosf(std::clamp(dir.z / length(dir), -1.f, 1.f));
+	f32 phi = atan2f(dir.y, dir.x);
+	f32 x = theta + Dim * 0.5f;
+	f32 y = phi + Dim * 0.5f;
+	x = x - Dim * floorf(x / Dim) - Dim * 0.5f;
+	y = y - Dim * floorf(y / Dim) - Dim * 0.5f;
+	return std::min(fabsf(x), fabsf(y * sinf(theta)));
+}
+
+static Vector3f grid_color(f32 d) {
+	f32 line = 2.f * expf(-2000.f * std::max(d - 0.00025f, 0.f));
+	return Vector3f(tanhf(0.5f * line), tanhf(0.5f * line), tanhf(line)) * 0.25f;
+}
+
+Vector3f cosmos_grid(Vector3f dir) {
+	return grid_color(grid_distance(dir));
+}
+
+Cosmos::Sky_Key Cosmos::current_key(u32 size) const {
+	return { seed, size };
+}
+
+void Cosmos::prepare_cubemap(u32 size, bool always_save) {
+	Sky_Key key = current_key(size);
+	if (sky_valid && sky_key == key)
+		return;
+	if (load_cubemap(key))
+		return;
+
+	bake_cubemap(size);
+
+	// Every seed typed in is a new key, only the ones asked for again are worth a file.
+	char path[256];
+	sky_cache_path(key, path, sizeof(path));
+	if ((disk_cache_seen_before(path) || always_save) && !save_cubemap())
+		printf("Failed to save the sky cache: %s\n", SDL_GetError());
+}
+
+void Cosmos::bake_cubemap(u32 size) {
+	generate_star_catalog(seed, stars);
+	bake_star_cube(stars, size, sky_texels);
+
+	// The lines are thinner than a texel, the texels near one average 4 x 4 samples of it.
+	constexpr u32 Grid_Samples = 4;
+	f32 texel_angle = 2.f / (f32)size;
+	parallel_for((usz)6 * size, std::max<usz>(1, 4096 / size), [&] (usz begin, usz end) {
+		for (usz row = begin; row < end; row += 1) {
+			u32 f = (u32)(row / size);
+			u32 j = (u32)(row % size);
+			for (u32 i = 0; i < size; i += 1) {
+				Vector3f dir = cube_texel_direction(f, i, j, size);
+				Vector3f grid;
+				if (grid_distance(dir) > 2.f * texel_angle) {
+					grid = cosmos_grid(dir);
+				} else {
+					Vector3f fine;
+					for (u32 y = 0; y < Grid_Samples; y += 1)
+					for (u32 x = 0; x < Grid_Samples; x += 1) {
+						fine = fine + cosmos_grid(cube_texel_direction(
+							f, i * Grid_Samples + x, j * Grid_Samples + y, size * Grid_Samples
+						));
+					}
+					grid = fine * (1.f / (Grid_Samples * Grid_Samples));
+				}
+
+				u16* texel = &sky_texels[(row * size + i) * 4];
+				Vector3f color = grid * 0.1f + Vector3f(
+					f16_to_f32(texel[0]), f16_to_f32(texel[1]), f16_to_f32(texel[2])
+				);
+				texel[0] = f32_to_f16(color.x);
+				texel[1] = f32_to_f16(color.y);
+				texel[2] = f32_to_f16(color.z);
+				texel[3] = f32_to_f16(1.f);
+			}
 		}
+	});
+
+	sky_key = current_key(size);
+	sky_valid = true;
+}
+
+bool Cosmos::load_cubemap(const Sky_Key& key) {
+	char path[256];
+	sky_cache_path(key, path, sizeof(path));
+
+	usz size = 0;
+	void* data = Asset_Loader::loader.load(path, &size);
+	if (!data)
+		return false;
+	defer {
+		SDL_free(data);
 	};
-	SDL_GPUGraphicsPipelineCreateInfo info = {
-		.vertex_shader = vertex_shader,
-		.fragment_shader = fragment_shader,
-		.vertex_input_state = {
-			.vertex_buffer_descriptions = vertex_buffer_desc,
-			.num_vertex_buffers = sizeof(vertex_buffer_desc) / sizeof(*vertex_buffer_desc),
-			.vertex_attributes = vertex_attributes,
-			.num_vertex_attributes = sizeof(vertex_attributes) / sizeof(*vertex_attributes),
-		},
-		.primitive_type = SDL_GPU_PRIMITIVETYPE_TRIANGLELIST,
-		.rasterizer_state = {
-			.fill_mode = SDL_GPU_FILLMODE_FILL,
-			.cull_mode = SDL_GPU_CULLMODE_NONE,
-			.front_face = SDL_GPU_FRONTFACE_COUNTER_CLOCKWISE,
-		},
-		.multisample_state = {
-			.sample_count = SDL_GPU_SAMPLECOUNT_8,
-		},
-		.depth_stencil_state = {
-			.compare_op = SDL_GPU_COMPAREOP_LESS_OR_EQUAL,
-			.write_mask = 0xFF,
-			.enable_depth_test = true,
-			.enable_depth_write = true,
-			.enable_stencil_test = false,
-		},
-		.target_info = {
-			.color_target_descriptions = color_target_desc,
-			.num_color_targets = sizeof(color_target_desc) / sizeof(*color_target_desc),
-			.depth_stencil_format = SDL_GPU_TEXTUREFORMAT_D32_FLOAT,
-			.has_depth_stencil_target = true,
-		},
-	};
-	if (pipeline) {
-		SDL_ReleaseGPUGraphicsPipeline(gpu, pipeline);
-	}
-	pipeline = SDL_CreateGPUGraphicsPipeline(gpu, &info);
-	if (!pipeline) {
-		printf("Failed to create graphics pipeline: %s\n", SDL_GetError());
+
+	usz texels = (usz)6 * key.size * key.size * 4;
+	Sky_Cache_Header header;
+	if (size != sizeof(header) + texels * sizeof(u16))
+		return false;
+	memcpy(&header, data, sizeof(header));
+	if (
+		header.magic != Sky_Cache_Magic ||
+		header.version != Sky_Cache_Version ||
+		!(header.key == key)
+	)
 		return false;
-	}
 
-	SDL_ReleaseGPUShader(gpu, vertex_shader);
-	SDL_ReleaseGPUShader(gpu, fragment_shader);
+	// The catalog is cheap next to the file, the panel shows its size.
+	generate_star_catalog(key.seed, stars);
+	sky_texels.resize(texels);
+	memcpy(sky_texels.data(), (u8*)data + sizeof(header), texels * sizeof(u16));
+	sky_key = key;
+	sky_valid = true;
+	disk_cache_touch(path);
 	return true;
 }
-void Cosmos::release(SDL_GPUDevice* gpu){
-	if (pipeline) {
-		SDL_ReleaseGPUGraphicsPipeline(gpu, pipeline);
+
+bool Cosmos::save_cubemap() const {
+	if (!sky_valid)
+		return false;
+
+	char path[256];
+	sky_cache_path(sky_key, path, sizeof(path));
+	SDL_CreateDirectory(Sky_Cache_Directory);
+
+	Sky_Cache_Header header = { Sky_Cache_Magic, Sky_Cache_Version, sky_key };
+	std::vector<u8> data(sizeof(header) + sky_texels.size() * sizeof(u16));
+	memcpy(data.data(), &header, sizeof(header));
+	memcpy(data.data() + sizeof(header), sky_texels.data(), sky_texels.size() * sizeof(u16));
+	if (!SDL_SaveFile(path, data.data(), data.size()))
+		return false;
+	disk_cache_trim("sky_", Sky_Cache_Max_Files);
+	return true;
+}
+
+void Cosmos::update(SDL_GPUDevice* gpu, std::vector<SDL_GPUFence*>& fences) {
+	Sky_Key key = current_key(cube_size);
+	if (uploaded && (sky_key == key || editing))
+		return;
+
+	if (!sky_sampler) {
+		sky_sampler = SDL_CreateGPUSampler(gpu, &(SDL_GPUSamplerCreateInfo) {
+			.min_filter = SDL_GPU_FILTER_LINEAR,
+			.mag_filter = SDL_GPU_FILTER_LINEAR,
+			.mipmap_mode = SDL_GPU_SAMPLERMIPMAPMODE_NEAREST,
+			.address_mode_u = SDL_GPU_SAMPLERADDRESSMODE_CLAMP_TO_EDGE,
+			.address_mode_v = SDL_GPU_SAMPLERADDRESSMODE_CLAMP_TO_EDGE,
+			.address_mode_w = SDL_GPU_SAMPLERADDRESSMODE_CLAMP_TO_EDGE,
+		});
 	}
-	pipeline = nullptr;
+	if (sky_cube && sky_key.size != key.size) {
+		SDL_ReleaseGPUTexture(gpu, sky_cube);
+		sky_cube = nullptr;
+	}
+	if (!sky_cube) {
+		sky_cube = SDL_CreateGPUTexture(gpu, &(SDL_GPUTextureCreateInfo) {
+			.type = SDL_GPU_TEXTURETYPE_CUBE,
+			.format = SDL_GPU_TEXTUREFORMAT_R16G16B16A16_FLOAT,
+			.usage = SDL_GPU_TEXTUREUSAGE_SAMPLER,
+			.width = cube_size,
+			.height = cube_size,
+			.layer_count_or_depth = 6,
+			.num_levels = 1,
+			.sample_count = SDL_GPU_SAMPLECOUNT_1,
+		});
+	}
+	if (!sky_cube || !sky_sampler) {
+		printf("Failed to create the sky cube: %s\n", SDL_GetError());
+		return;
+	}
+
+	prepare_cubemap(cube_size);
+
+	u32 face_size = cube_size * cube_size * 4 * sizeof(u16);
+	SDL_GPUTransferBuffer* transfer = SDL_CreateGPUTransferBuffer(
+		gpu, &(SDL_GPUTransferBufferCreateInfo) {
+			.usage = SDL_GPU_TRANSFERBUFFERUSAGE_UPLOAD,
+			.size = 6 * face_size
+		}
+	);
+	void* pointer = SDL_MapGPUTransferBuffer(gpu, transfer, false);
+	memcpy(pointer, sky_texels.data(), 6 * face_size);
+	SDL_UnmapGPUTransferBuffer(gpu, transfer);
+
+	SDL_GPUCommandBuffer* buffer = SDL_AcquireGPUCommandBuffer(gpu);
+	SDL_GPUCopyPass* copy = SDL_BeginGPUCopyPass(buffer);
+	for (u32 f = 0; f < 6; f += 1) {
+		SDL_UploadToGPUTexture(
+			copy,
+			&(SDL_GPUTextureTransferInfo) {
+				.transfer_buffer = transfer,
+				.offset = f * face_size,
+			},
+			&(SDL_GPUTextureRegion) {
+				.texture = sky_cube,
+				.layer = f,
+				.w = cube_size,
+				.h = cube_size,
+				.d = 1,
+			},
+			false
+		);
+	}
+	SDL_EndGPUCopyPass(copy);
+	fences.push_back(SDL_SubmitGPUCommandBufferAndAcquireFence(buffer));
+	uploaded = true;
+
+	// Released now, the gpu holds on to it until the copy is done.
+	SDL_ReleaseGPUTransferBuffer(gpu, transfer);
 }
 
 void Cosmos::imgui() {
 	ImGui::ColorEdit3("Empty Color", &uniform.empty_color.x);
+
+	ImGui::InputScalar("Star seed", ImGuiDataType_U32, &seed);
+	static const u32 sizes[] = { 256, 512, 1024, 2048 };
+	if (ImGui::BeginCombo("Sky cube size", std::to_string(cube_size).c_str())) {
+		for (u32 size : sizes) {
+			if (ImGui::Selectable(std::to_string(size).c_str(), size == cube_size))
+				cube_size = size;
+		}
+		ImGui::EndCombo();
+	}
+	ImGui::Text("%zu stars", stars.size());
+
+	// prepare_cubemap only saves the keys it is asked for twice, this one is wanted now.
+	if (sky_valid) {
+		ImGui::SameLine();
+		if (ImGui::Button("Save##sky_cache") && !save_cubemap())
+			printf("Failed to save the sky cache: %s\n", SDL_GetError());
+	}
+
+	editing = ImGui::IsAnyItemActive();
 }
 
 void Cosmos::render(SDL_GPURenderPass* pass, SDL_GPUCommandBuffer* command) {
@@ -138,6 +312,11 @@ void Cosmos::render(SDL_GPURenderPass* pass, SDL_GPUCommandBuffer* command) {
 		.offset = 0
 	}, 1);
 
+	SDL_BindGPUFragmentSamplers(pass, 0, &(SDL_GPUTextureSamplerBinding) {
+		.texture = sky_cube,
+		.sampler = sky_sampler
+	}, 1);
+
 	SDL_PushGPUVertexUniformData(command, 0, &common_uniform, sizeof(common_uniform));
 	SDL_PushGPUFragmentUniformData(command, 0, &common_uniform, sizeof(common_uniform));
 
@@ -2,24 +2,69 @@
 
 #include "SDL3/SDL.h"
 #include "Graphics.hpp"
+#include "Stars.hpp"
 
+#include <vector>
 
 struct Cosmos {
 	struct Uniform {
 		Vector3f empty_color = Vector3f(0.025f, 0.025f, 0.05f);
 	};
 
-	size_t n_stars = 1000;
+	// Everything the baked sky depends on, two caches with equal keys hold the same texels.
+	// empty_color is added by cosmos.frag, editing it does not rebake.
+	struct Sky_Key {
+		u32 seed = 0;
+		u32 size = 0;
+
+		bool operator==(const Sky_Key& other) const = default;
+	};
+
+	// The sky is rebaked by update when these change.
+	u32 seed = 0;
+	u32 cube_size = 1024;
 
 	Uniform uniform;
 	Common_Uniform common_uniform;
 
+	// The grid and the stars of cosmos.frag baked in a cube of RGBA16F texels, face by face and
+	// row by row like the layers of sky_cube.
+	std::vector<Star> stars;
+	std::vector<u16> sky_texels;
+	Sky_Key sky_key;
+	bool sky_valid = false;
+	bool uploaded = false;
+	bool editing = false;
+
+	SDL_GPUTexture* sky_cube = nullptr;
+	SDL_GPUSampler* sky_sampler = nullptr;
+
 	SDL_GPUBuffer* shader_buffer = nullptr;
 	SDL_GPUGraphicsPipeline* pipeline = nullptr;
 
-	bool create_pipeline(SDL_GPUDevice* gpu);
+	bool create_pipeline(SDL_GPUDevice* gpu, const Render_Settings& settings);
 	void release(SDL_GPUDevice* gpu);
 
+	Sky_Key current_key(u32 size) const;
+	// In memory if the key matches, then from the disk cache, else bakes it. The bake is saved
+	// when the key was asked for before or always_save is set, save_cubemap only keeps the most
+	// recently used files.
+	void prepare_cubemap(u32 size, bool always_save = false);
+	// Evaluates the sky of cosmos.frag at every texel, rows are spread over the workers.
+	void bake_cubemap(u32 size);
+	bool load_cubemap(const Sky_Key& key);
+	bool save_cubemap() const;
+
+	// Bakes and uploads the sky when its key changed, must run before the first render. Waits
+	// for the sliders to be released.
+	void update(SDL_GPUDevice* gpu, std::vector<SDL_GPUFence*>& fences);
+
 	void imgui();
 	void render(SDL_GPURenderPass* pass, SDL_GPUCommandBuffer* command);
 };
+
+// The grid of cosmos.frag in direction dir, before its 0.1 weight.
+extern Vector3f cosmos_grid(Vector3f dir);
+
+// Where the sky of key is cached on disk.
+extern void sky_cache_path(const Cosmos::Sky_Key& key, char* path, size_t size);
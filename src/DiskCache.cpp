@@ -0,0 +1,82 @@
+#include "DiskCache.hpp"
+
+#include "SDL3/SDL.h"
+
+#include <algorithm>
+#include <filesystem>
+#include <stdio.h>
+#include <string>
+#include <vector>
+
+bool disk_cache_seen_before(const char* path) {
+	std::filesystem::path seen_path = std::filesystem::path(Disk_Cache_Directory) / "seen.txt";
+
+	// One path per line, oldest first.
+	std::vector<std::string> lines;
+	size_t size = 0;
+	char* text = (char*)SDL_LoadFile(seen_path.generic_string().c_str(), &size);
+	if (text) {
+		defer {
+			SDL_free(text);
+		};
+		for (size_t begin = 0; begin < size;) {
+			size_t end = begin;
+			while (end < size && text[end] != '\n')
+				end += 1;
+			if (end > begin)
+				lines.emplace_back(text + begin, end - begin);
+			begin = end + 1;
+		}
+	}
+
+	if (std::find(lines.begin(), lines.end(), path) != lines.end())
+		return true;
+
+	lines.push_back(path);
+	if (lines.size() > Disk_Cache_Seen_Count)
+		lines.erase(lines.begin(), lines.end() - Disk_Cache_Seen_Count);
+
+	std::string out;
+	for (const std::string& line : lines)
+		out += line + "\n";
+	SDL_CreateDirectory(Disk_Cache_Directory);
+	if (!SDL_SaveFile(seen_path.generic_string().c_str(), out.data(), out.size()))
+		printf("Failed to write %s: %s\n", seen_path.generic_string().c_str(), SDL_GetError());
+	return false;
+}
+
+void disk_cache_touch(const char* path) {
+	std::error_code error;
+	std::filesystem::last_write_time(
+		path, std::filesystem::file_time_type::clock::now(), error
+	);
+}
+
+void disk_cache_trim(const char* prefix, usz max_files) {
+	struct Entry {
+		std::filesystem::path path;
+		std::filesystem::file_time_type time;
+	};
+	std::vector<Entry> entries;
+
+	std::error_code error;
+	for (const auto& entry : std::filesystem::directory_iterator(Disk_Cache_Directory, error)) {
+		if (!entry.is_regular_file(error))
+			continue;
+		if (!entry.path().filename().generic_string().starts_with(prefix))
+			continue;
+		std::filesystem::file_time_type time = entry.last_write_time(error);
+		if (error)
+			continue;
+		entries.push_back({ entry.path(), time });
+	}
+	if (entries.size() <= max_files)
+		return;
+
+	// Most recently used first, the tail goes.
+	std::sort(entries.begin(), entries.end(), [] (const Entry& a, const Entry& b) {
+		return a.time > b.time;
+	});
+	for (usz i = max_files; i < entries.size(); i += 1)
+		std::filesystem::remove(entries[i].path, error);
+}
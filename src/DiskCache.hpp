@@ -0,0 +1,21 @@
+#pragma once
+
+#include "Common.hpp"
+
+// Shared by the bake caches of cache/ to keep them bounded. A file is only written once its key
+// is asked for again, so slider steps do not each leave one behind, and every kind of file only
+// keeps its most recently used ones.
+
+inline constexpr const char* Disk_Cache_Directory = "cache";
+
+// Whether path was asked for before, in this run or a previous one, remembering it if not. Only
+// the last Disk_Cache_Seen_Count paths are remembered, in cache/seen.txt.
+inline constexpr usz Disk_Cache_Seen_Count = 64;
+extern bool disk_cache_seen_before(const char* path);
+
+// Marks path as used now, load calls it so the write times order the files by last use.
+extern void disk_cache_touch(const char* path);
+
+// Deletes the files of Disk_Cache_Directory whose name starts with prefix, least recently used
+// first, until max_files are left.
+extern void disk_cache_trim(const char* prefix, usz max_files);
@@ -0,0 +1,137 @@
+#pragma once
+
+#include "Common.hpp"
+#include "Packet.hpp"
+
+// Polynomial approximations of the libm functions used by the generation passes. Every function
+// is written once for f32, f32x4 and f32x8, they are branch free so the scalar versions vectorize
+// too. Max errors below are against the double precision functions over the stated domain, the
+// Fast math suite of the bench panel measures them against libm.
+
+constexpr f32 LOG2Ef = 1.44269504088896f;
+constexpr f32 LN2f = 0.693147180559945f;
+
+template <typename F>
+inline F fast_floor(F x) {
+	F r = round_nearest(x);
+	return r - select(r > x, F(1.f), F(0.f));
+}
+
+// sin(x + quadrant * pi / 2), the argument is reduced to [-pi/4, pi/4] with a two step pi/2.
+template <typename F>
+inline F fast_sin_quadrant(F x, f32 quadrant) {
+	F q = round_nearest(x * (2 / PIf));
+	F r = (x - q * 1.57079637050628662f) - q * -4.37113900018624e-8f;
+	q = q + quadrant;
+
+	F z = r * r;
+	F s = ((-1.9515295891e-4f * z + 8.3321608736e-3f) * z - 1.6666654611e-1f) * z * r + r;
+	F c = ((2.443315711809948e-5f * z - 1.388731625493765e-3f) * z + 4.166664568298827e-2f)
+		* z * z - 0.5f * z + 1.f;
+
+	F half = fast_floor(q * 0.5f);
+	F odd = q - half * 2.f;
+	F negative = half - fast_floor(half * 0.5f) * 2.f;
+	F v = select(odd > 0.5f, c, s);
+	return select(negative > 0.5f, -v, v);
+}
+
+// ln(m) for m in [sqrt(1/2), sqrt(2)], atanh series in t = (m - 1) / (m + 1).
+template <typename F>
+inline F fast_log_reduced(F x, F& exponent) {
+	F m;
+	exponent = split_exponent(x, m);
+	auto high = m > 1.41421356f;
+	m = select(high, m * 0.5f, m);
+	exponent = select(high, exponent + 1.f, exponent);
+
+	F t = (m - 1.f) / (m + 1.f);
+	F z = t * t;
+	return t * (2.f + z * (2 / 3.f + z * (2 / 5.f + z * (2 / 7.f + z * (2 / 9.f)))));
+}
+
+// |x| < 8192, max abs error 8e-8.
+template <typename F>
+inline F fast_sin(F x) {
+	return fast_sin_quadrant(x, 0.f);
+}
+
+// |x| < 8192, max abs error 8e-8.
+template <typename F>
+inline F fast_cos(F x) {
+	return fast_sin_quadrant(x, 1.f);
+}
+
+// Max abs error 2.8e-7 rad, atan2(-0, x < 0) returns +pi.
+template <typename F>
+inline F fast_atan2(F y, F x) {
+	F ax = absolute(x);
+	F ay = absolute(y);
+	auto steep = ay > ax;
+	F mx = select(steep, ay, ax);
+	F mn = select(steep, ax, ay);
+	F a = mn / select(mx > 0.f, mx, F(1.f));
+
+	// atan on [0, 1], reduced to |t| <= tan(pi/8) around pi/4.
+	auto big = a > 0.414213562f;
+	F t = select(big, (a - 1.f) / (a + 1.f), a);
+	F z = t * t;
+	F r = (((8.05374449538e-2f * z - 1.38776856032e-1f) * z + 1.99777106478e-1f) * z
+		- 3.33329491539e-1f) * z * t + t;
+
+	r = select(big, r + PIf / 4, r);
+	r = select(steep, PIf / 2 - r, r);
+	r = select(x < 0.f, PIf - r, r);
+	return select(y < 0.f, -r, r);
+}
+
+// Input clamped to [-126, 127], max rel error 1.2e-7.
+template <typename F>
+inline F fast_exp2(F x) {
+	x = select(x < -126.f, F(-126.f), x);
+	x = select(x > 127.f, F(127.f), x);
+
+	F n = round_nearest(x);
+	F f = x - n;
+	F p = ((((1.535336188319500e-4f * f + 1.339887440266574e-3f) * f + 9.618437357674640e-3f) * f
+		+ 5.550332471162809e-2f) * f + 2.402264791363012e-1f) * f + 6.931472028550421e-1f;
+	return (p * f + 1.f) * exp2_int(n);
+}
+
+// x in [-87, 88], max rel error 1.2e-7. Reduced with a two step ln(2) so large x keep their
+// accuracy, exp2(x * log2(e)) would lose the rounding of the product.
+template <typename F>
+inline F fast_exp(F x) {
+	x = select(x < -87.f, F(-87.f), x);
+	x = select(x > 88.f, F(88.f), x);
+
+	F n = round_nearest(x * LOG2Ef);
+	F r = (x - n * 0.693359375f) - n * -2.12194440e-4f;
+	F z = r * r;
+	F p = ((((1.9875691500e-4f * r + 1.3981999507e-3f) * r + 8.3334519073e-3f) * r
+		+ 4.1665795894e-2f) * r + 1.6666665459e-1f) * r + 5.0000001201e-1f;
+	return (p * z + r + 1.f) * exp2_int(n);
+}
+
+// x positive and normal, max rel error 2.3e-7 (2.9 ulp).
+template <typename F>
+inline F fast_log(F x) {
+	F exponent;
+	F l = fast_log_reduced(x, exponent);
+	return exponent * 0.693359375f + (l + exponent * -2.12194440e-4f);
+}
+
+// x positive and normal, max rel error 2.7e-7 (3.9 ulp).
+template <typename F>
+inline F fast_log2(F x) {
+	F exponent;
+	F l = fast_log_reduced(x, exponent);
+	return exponent + l * LOG2Ef;
+}
+
+// x >= 0, pow(0, y) is 0. Max rel error 7.7e-6 for y = 5.2561 on [0, 1], it grows with
+// |y * log2(x)| since the product is rounded before exp2.
+template <typename F>
+inline F fast_pow(F x, F y) {
+	return select(x > 0.f, fast_exp2(y * fast_log2(x)), F(0.f));
+}
@@ -1,8 +1,252 @@
 #include "Graphics.hpp"
+#include "AssetLoader.hpp"
 #include "SDL3/SDL_gpu.h"
+#include <string.h>
+#include <type_traits>
 #include <vector>
 
 FullscreenQuad FullscreenQuad::quad;
+Pipeline_Factory Pipeline_Factory::factory;
+
+// FNV-1a.
+static void hash_bytes(u64& hash, const void* data, usz size) {
+	const u8* bytes = (const u8*)data;
+	for (usz i = 0; i < size; i += 1) {
+		hash ^= bytes[i];
+		hash *= 1099511628211ull;
+	}
+}
+
+// Scalars and enums only, the SDL structs below are hashed field by field: a compound literal
+// does not have to zero their implicit padding, like the 3 bytes ending the blend state.
+template <typename T>
+static void hash_value(u64& hash, const T& value) {
+	static_assert(std::is_scalar_v<T>);
+	hash_bytes(hash, &value, sizeof(value));
+}
+
+static void hash_value(u64& hash, const SDL_GPUVertexBufferDescription& value) {
+	hash_value(hash, value.slot);
+	hash_value(hash, value.pitch);
+	hash_value(hash, value.input_rate);
+	hash_value(hash, value.instance_step_rate);
+}
+
+static void hash_value(u64& hash, const SDL_GPUVertexAttribute& value) {
+	hash_value(hash, value.location);
+	hash_value(hash, value.buffer_slot);
+	hash_value(hash, value.format);
+	hash_value(hash, value.offset);
+}
+
+static void hash_value(u64& hash, const SDL_GPURasterizerState& value) {
+	hash_value(hash, value.fill_mode);
+	hash_value(hash, value.cull_mode);
+	hash_value(hash, value.front_face);
+	hash_value(hash, value.depth_bias_constant_factor);
+	hash_value(hash, value.depth_bias_clamp);
+	hash_value(hash, value.depth_bias_slope_factor);
+	hash_value(hash, value.enable_depth_bias);
+	hash_value(hash, value.enable_depth_clip);
+}
+
+static void hash_value(u64& hash, const SDL_GPUStencilOpState& value) {
+	hash_value(hash, value.fail_op);
+	hash_value(hash, value.pass_op);
+	hash_value(hash, value.depth_fail_op);
+	hash_value(hash, value.compare_op);
+}
+
+static void hash_value(u64& hash, const SDL_GPUDepthStencilState& value) {
+	hash_value(hash, value.compare_op);
+	hash_value(hash, value.back_stencil_state);
+	hash_value(hash, value.front_stencil_state);
+	hash_value(hash, value.compare_mask);
+	hash_value(hash, value.write_mask);
+	hash_value(hash, value.enable_depth_test);
+	hash_value(hash, value.enable_depth_write);
+	hash_value(hash, value.enable_stencil_test);
+}
+
+static void hash_value(u64& hash, const SDL_GPUColorTargetDescription& value) {
+	const SDL_GPUColorTargetBlendState& blend = value.blend_state;
+	hash_value(hash, value.format);
+	hash_value(hash, blend.src_color_blendfactor);
+	hash_value(hash, blend.dst_color_blendfactor);
+	hash_value(hash, blend.color_blend_op);
+	hash_value(hash, blend.src_alpha_blendfactor);
+	hash_value(hash, blend.dst_alpha_blendfactor);
+	hash_value(hash, blend.alpha_blend_op);
+	hash_value(hash, blend.color_write_mask);
+	hash_value(hash, blend.enable_blend);
+	hash_value(hash, blend.enable_color_write_mask);
+}
+
+template <typename T>
+static void hash_vector(u64& hash, const std::vector<T>& values) {
+	hash_value(hash, values.size());
+	for (const T& value : values)
+		hash_value(hash, value);
+}
+
+const Pipeline_Factory::Shader_Module* Pipeline_Factory::shader(
+	SDL_GPUDevice* gpu, const Shader_Desc& desc, SDL_GPUShaderStage stage
+) {
+	u64 key = 14695981039346656037ull;
+	hash_bytes(key, desc.path, strlen(desc.path));
+	hash_value(key, stage);
+	hash_value(key, desc.num_samplers);
+	hash_value(key, desc.num_uniform_buffers);
+
+	auto it = shaders.find(key);
+	if (it != shaders.end())
+		return &it->second;
+
+	usz size = 0;
+	void* code = Asset_Loader::loader.load(desc.path, &size);
+	defer {
+		SDL_free(code);
+	};
+	if (!code) {
+		printf("Failed to load shader file %s: %s\n", desc.path, SDL_GetError());
+		return nullptr;
+	}
+	files_read += 1;
+
+	SDL_GPUShaderCreateInfo info = {
+		.code_size = size,
+		.code = (const u8*)code,
+		.entrypoint = "main",
+		.format = SDL_GPU_SHADERFORMAT_SPIRV,
+		.stage = stage,
+		.num_samplers = desc.num_samplers,
+		.num_storage_textures = 0,
+		.num_storage_buffers = 0,
+		.num_uniform_buffers = desc.num_uniform_buffers,
+	};
+	SDL_GPUShader* shader = SDL_CreateGPUShader(gpu, &info);
+	if (!shader) {
+		printf("Failed to create shader %s: %s\n", desc.path, SDL_GetError());
+		return nullptr;
+	}
+	shaders_created += 1;
+
+	u64 hash = key;
+	hash_bytes(hash, code, size);
+	return &(shaders[key] = { desc.path, hash, shader });
+}
+
+SDL_GPUGraphicsPipeline* Pipeline_Factory::create(SDL_GPUDevice* gpu, const Pipeline_Desc& desc) {
+	const Shader_Module* vertex = shader(gpu, desc.vertex, SDL_GPU_SHADERSTAGE_VERTEX);
+	const Shader_Module* fragment = shader(gpu, desc.fragment, SDL_GPU_SHADERSTAGE_FRAGMENT);
+	if (!vertex || !fragment)
+		return nullptr;
+
+	u64 key = 14695981039346656037ull;
+	hash_value(key, vertex->hash);
+	hash_value(key, fragment->hash);
+	hash_vector(key, desc.vertex_buffers);
+	hash_vector(key, desc.vertex_attributes);
+	hash_value(key, desc.primitive_type);
+	hash_value(key, desc.rasterizer_state);
+	hash_value(key, desc.sample_count);
+	hash_value(key, desc.depth_stencil_state);
+	hash_vector(key, desc.color_targets);
+	hash_value(key, desc.depth_stencil_format);
+	hash_value(key, desc.has_depth_stencil_target);
+
+	auto it = pipelines.find(key);
+	if (it != pipelines.end()) {
+		pipelines_reused += 1;
+		return it->second.pipeline;
+	}
+
+	SDL_GPUGraphicsPipelineCreateInfo info = {
+		.vertex_shader = vertex->shader,
+		.fragment_shader = fragment->shader,
+		.vertex_input_state = {
+			.vertex_buffer_descriptions = desc.vertex_buffers.data(),
+			.num_vertex_buffers = (u32)desc.vertex_buffers.size(),
+			.vertex_attributes = desc.vertex_attributes.data(),
+			.num_vertex_attributes = (u32)desc.vertex_attributes.size(),
+		},
+		.primitive_type = desc.primitive_type,
+		.rasterizer_state = desc.rasterizer_state,
+		.multisample_state = {
+			.sample_count = desc.sample_count,
+		},
+		.depth_stencil_state = desc.depth_stencil_state,
+		.target_info = {
+			.color_target_descriptions = desc.color_targets.data(),
+			.num_color_targets = (u32)desc.color_targets.size(),
+			.depth_stencil_format = desc.depth_stencil_format,
+			.has_depth_stencil_target = desc.has_depth_stencil_target,
+		},
+	};
+	SDL_GPUGraphicsPipeline* pipeline = SDL_CreateGPUGraphicsPipeline(gpu, &info);
+	if (!pipeline) {
+		printf("Failed to create graphics pipeline: %s\n", SDL_GetError());
+		return nullptr;
+	}
+	pipelines_created += 1;
+	pipelines[key] = { vertex->hash, fragment->hash, pipeline };
+	return pipeline;
+}
+
+void Pipeline_Factory::forget_shader(SDL_GPUDevice* gpu, const char* path) {
+	std::vector<u64> forgotten;
+	for (auto it = shaders.begin(); it != shaders.end();) {
+		if (it->second.path == path) {
+			forgotten.push_back(it->second.hash);
+			SDL_ReleaseGPUShader(gpu, it->second.shader);
+			it = shaders.erase(it);
+		} else {
+			++it;
+		}
+	}
+
+	for (auto it = pipelines.begin(); it != pipelines.end();) {
+		const Pipeline& pipeline = it->second;
+		bool stale = false;
+		for (u64 hash : forgotten)
+			stale |= pipeline.vertex == hash || pipeline.fragment == hash;
+		if (stale) {
+			SDL_ReleaseGPUGraphicsPipeline(gpu, pipeline.pipeline);
+			it = pipelines.erase(it);
+		} else {
+			++it;
+		}
+	}
+}
+
+void Pipeline_Factory::release(SDL_GPUDevice* gpu) {
+	for (auto& [key, pipeline] : pipelines)
+		SDL_ReleaseGPUGraphicsPipeline(gpu, pipeline.pipeline);
+	pipelines.clear();
+	for (auto& [key, module] : shaders)
+		SDL_ReleaseGPUShader(gpu, module.shader);
+	shaders.clear();
+}
+
+Pipeline_Desc FullscreenQuad::pipeline_desc() {
+	return {
+		.vertex_buffers = {
+			{
+				.slot = 0,
+				.pitch = sizeof(Vector2f),
+				.input_rate = SDL_GPU_VERTEXINPUTRATE_VERTEX
+			}
+		},
+		.vertex_attributes = {
+			{
+				.location = 0,
+				.buffer_slot = 0,
+				.format = SDL_GPU_VERTEXELEMENTFORMAT_FLOAT2,
+				.offset = 0,
+			}
+		},
+	};
+}
 SDL_GPUFence* FullscreenQuad::upload(SDL_GPUDevice* gpu) {
 	if (!vertex_buffer) {
 		vertex_buffer = SDL_CreateGPUBuffer(
@@ -147,6 +391,8 @@ void WorldArrow::release(SDL_GPUDevice* gpu) {
 		SDL_ReleaseGPUBuffer(gpu, instance_buffer);
 		instance_buffer = nullptr;
 	}
+	// The pipeline belongs to Pipeline_Factory::factory.
+	pipeline = nullptr;
 }
 
 void WorldArrow::set_instances(
@@ -199,136 +445,67 @@ void WorldArrow::set_instances(
 	);
 	SDL_EndGPUCopyPass(copy);
 	n_instances = instance_size;
+	ranges = { { 0, (u32)instance_size } };
 	fences.push_back(SDL_SubmitGPUCommandBufferAndAcquireFence(buffer));
 }
 
-bool WorldArrow::create_pipeline(SDL_GPUDevice* gpu, SDL_GPUTextureFormat format)
+bool WorldArrow::create_pipeline(SDL_GPUDevice* gpu, const Render_Settings& settings)
 {
-	SDL_GPUShader* vertex_shader = nullptr;
-	SDL_GPUShader* fragment_shader = nullptr;
-	{
-		size_t vertex_size = 0;
-		void* plain_vertex = SDL_LoadFile("assets/shaders/vert_arrow.spv", &vertex_size);
-		defer {
-			SDL_free(plain_vertex);
-		};
-
-		size_t fragment_size = 0;
-		void* plain_fragment = SDL_LoadFile("assets/shaders/frag_arrow.spv", &fragment_size);
-		defer {
-			SDL_free(plain_fragment);
-		};
-
-		if (!plain_vertex || !plain_fragment) {
-			printf("Failed to load shader files: %s\n", SDL_GetError());
-			return false;
-		}
-
-		SDL_GPUShaderCreateInfo vertex_info = {};
-		vertex_info.code_size = vertex_size;
-		vertex_info.code = (u8*)plain_vertex;
-		vertex_info.entrypoint = "main";
-		vertex_info.format = SDL_GPU_SHADERFORMAT_SPIRV;
-		vertex_info.stage = SDL_GPU_SHADERSTAGE_VERTEX;
-		vertex_info.num_samplers = 0;
-		vertex_info.num_storage_textures = 0;
-		vertex_info.num_storage_buffers = 0;
-		vertex_info.num_uniform_buffers = 2;
-		vertex_shader = SDL_CreateGPUShader(gpu, &vertex_info);
-
-		SDL_GPUShaderCreateInfo fragment_info = {};
-		fragment_info.code_size = fragment_size;
-		fragment_info.code = (u8*)plain_fragment;
-		fragment_info.entrypoint = "main";
-		fragment_info.format = SDL_GPU_SHADERFORMAT_SPIRV;
-		fragment_info.stage = SDL_GPU_SHADERSTAGE_FRAGMENT;
-		fragment_info.num_samplers = 0;
-		fragment_info.num_storage_textures = 0;
-		fragment_info.num_storage_buffers = 0;
-		fragment_info.num_uniform_buffers = 2;
-		fragment_shader = SDL_CreateGPUShader(gpu, &fragment_info);
-	}
-
-	if (!vertex_shader || !fragment_shader) {
-		printf("Failed to create shaders: %s\n", SDL_GetError());
-		return false;
-	}
-
-	SDL_GPUColorTargetDescription color_target_desc[] = {
-		{
-			.format = format,
-		}
-	};
-	SDL_GPUVertexBufferDescription vertex_buffer_desc[] = {
-		{
-			.slot = 0,
-			.pitch = sizeof(Vector3f),
-			.input_rate = SDL_GPU_VERTEXINPUTRATE_VERTEX
-		},
-		SDL_GPUVertexBufferDescription{
-			.slot = 1,
-			.pitch = sizeof(Instance),
-			.input_rate = SDL_GPU_VERTEXINPUTRATE_INSTANCE,
-			.instance_step_rate = 1
-		}
-	};
-	SDL_GPUVertexAttribute vertex_attributes[] = {
-		{
-			.location = 0,
-			.buffer_slot = 0,
-			.format = SDL_GPU_VERTEXELEMENTFORMAT_FLOAT3,
-			.offset = 0,
-		},
-		{
-			.location = 1,
-			.buffer_slot = 1,
-			.format = SDL_GPU_VERTEXELEMENTFORMAT_FLOAT3,
-			.offset = offsetof(Instance, pos),
-		},
-		{
-			.location = 2,
-			.buffer_slot = 1,
-			.format = SDL_GPU_VERTEXELEMENTFORMAT_FLOAT3,
-			.offset = offsetof(Instance, dir),
-		},
-		{
-			.location = 3,
-			.buffer_slot = 1,
-			.format = SDL_GPU_VERTEXELEMENTFORMAT_FLOAT3,
-			.offset = offsetof(Instance, up),
-		},
-		{
-			.location = 4,
-			.buffer_slot = 1,
-			.format = SDL_GPU_VERTEXELEMENTFORMAT_FLOAT3,
-			.offset = offsetof(Instance, color),
-		},
-		{
-			.location = 5,
-			.buffer_slot = 1,
-			.format = SDL_GPU_VERTEXELEMENTFORMAT_FLOAT,
-			.offset = offsetof(Instance, scale),
-		}
-
-	};
-	SDL_GPUGraphicsPipelineCreateInfo info = {
-		.vertex_shader = vertex_shader,
-		.fragment_shader = fragment_shader,
-		.vertex_input_state = {
-			.vertex_buffer_descriptions = vertex_buffer_desc,
-			.num_vertex_buffers = sizeof(vertex_buffer_desc) / sizeof(*vertex_buffer_desc),
-			.vertex_attributes = vertex_attributes,
-			.num_vertex_attributes = sizeof(vertex_attributes) / sizeof(*vertex_attributes),
-	},
-		.primitive_type = SDL_GPU_PRIMITIVETYPE_TRIANGLELIST,
-		.rasterizer_state = {
-			.fill_mode = SDL_GPU_FILLMODE_FILL,
-			.cull_mode = SDL_GPU_CULLMODE_NONE,
-			.front_face = SDL_GPU_FRONTFACE_COUNTER_CLOCKWISE,
+	Pipeline_Desc desc = {
+		.vertex = { .path = "assets/shaders/vert_arrow.spv", .num_uniform_buffers = 2 },
+		.fragment = { .path = "assets/shaders/frag_arrow.spv", .num_uniform_buffers = 2 },
+		.vertex_buffers = {
+			{
+				.slot = 0,
+				.pitch = sizeof(Vector3f),
+				.input_rate = SDL_GPU_VERTEXINPUTRATE_VERTEX
+			},
+			{
+				.slot = 1,
+				.pitch = sizeof(Instance),
+				.input_rate = SDL_GPU_VERTEXINPUTRATE_INSTANCE,
+				.instance_step_rate = 1
+			}
 		},
-		.multisample_state = {
-			.sample_count = SDL_GPU_SAMPLECOUNT_8,
+		.vertex_attributes = {
+			{
+				.location = 0,
+				.buffer_slot = 0,
+				.format = SDL_GPU_VERTEXELEMENTFORMAT_FLOAT3,
+				.offset = 0,
+			},
+			{
+				.location = 1,
+				.buffer_slot = 1,
+				.format = SDL_GPU_VERTEXELEMENTFORMAT_FLOAT3,
+				.offset = offsetof(Instance, pos),
+			},
+			{
+				.location = 2,
+				.buffer_slot = 1,
+				.format = SDL_GPU_VERTEXELEMENTFORMAT_FLOAT3,
+				.offset = offsetof(Instance, dir),
+			},
+			{
+				.location = 3,
+				.buffer_slot = 1,
+				.format = SDL_GPU_VERTEXELEMENTFORMAT_FLOAT3,
+				.offset = offsetof(Instance, up),
+			},
+			{
+				.location = 4,
+				.buffer_slot = 1,
+				.format = SDL_GPU_VERTEXELEMENTFORMAT_FLOAT3,
+				.offset = offsetof(Instance, color),
+			},
+			{
+				.location = 5,
+				.buffer_slot = 1,
+				.format = SDL_GPU_VERTEXELEMENTFORMAT_FLOAT,
+				.offset = offsetof(Instance, scale),
+			}
 		},
+		.sample_count = settings.sample_count,
 		.depth_stencil_state = {
 			.compare_op = SDL_GPU_COMPAREOP_LESS,
 			.write_mask = 0xFF,
@@ -336,24 +513,12 @@ bool WorldArrow::create_pipeline(SDL_GPUDevice* gpu, SDL_GPUTextureFormat format
 			.enable_depth_write = true,
 			.enable_stencil_test = false,
 		},
-		.target_info = {
-			.color_target_descriptions = color_target_desc,
-			.num_color_targets = sizeof(color_target_desc) / sizeof(*color_target_desc),
-			.depth_stencil_format = SDL_GPU_TEXTUREFORMAT_D32_FLOAT,
-			.has_depth_stencil_target = true,
-		},
+		.color_targets = { { .format = settings.color_format } },
+		.depth_stencil_format = settings.depth_format,
+		.has_depth_stencil_target = true,
 	};
-	if (pipeline)
-		SDL_ReleaseGPUGraphicsPipeline(gpu, pipeline);
-	pipeline = SDL_CreateGPUGraphicsPipeline(gpu, &info);
-	if (!pipeline) {
-		printf("Failed to create graphics pipeline: %s\n", SDL_GetError());
-		return false;
-	}
-
-	SDL_ReleaseGPUShader(gpu, vertex_shader);
-	SDL_ReleaseGPUShader(gpu, fragment_shader);
-	return true;
+	pipeline = Pipeline_Factory::factory.create(gpu, desc);
+	return pipeline != nullptr;
 }
 
 void WorldArrow::render(SDL_GPURenderPass* pass, SDL_GPUCommandBuffer* buffer)
@@ -377,127 +542,23 @@ void WorldArrow::render(SDL_GPURenderPass* pass, SDL_GPUCommandBuffer* buffer)
 
 	SDL_PushGPUVertexUniformData(buffer, 0, &common_uniform, sizeof(common_uniform));
 	SDL_PushGPUFragmentUniformData(buffer, 0, &common_uniform, sizeof(common_uniform));
-	SDL_DrawGPUPrimitives(pass, 9, n_instances, 0, 0);
+	for (const Range& range : ranges)
+		SDL_DrawGPUPrimitives(pass, 9, range.count, 0, range.first);
 }
 
 bool Postprocess::create_pipeline(SDL_GPUDevice* gpu, SDL_GPUTextureFormat format)
 {
-	SDL_GPUShader* vertex_shader = nullptr;
-	SDL_GPUShader* fragment_shader = nullptr;
-	{
-		size_t vertex_size = 0;
-		void* plain_vertex = SDL_LoadFile("assets/shaders/vert_post.spv", &vertex_size);
-		defer {
-			SDL_free(plain_vertex);
-		};
-
-		size_t fragment_size = 0;
-		void* plain_fragment = SDL_LoadFile("assets/shaders/frag_post.spv", &fragment_size);
-		defer {
-			SDL_free(plain_fragment);
-		};
-
-		if (!plain_vertex || !plain_fragment) {
-			printf("Failed to load shader files: %s\n", SDL_GetError());
-			return false;
-		}
-
-		SDL_GPUShaderCreateInfo vertex_info = {};
-		vertex_info.code_size = vertex_size;
-		vertex_info.code = (u8*)plain_vertex;
-		vertex_info.entrypoint = "main";
-		vertex_info.format = SDL_GPU_SHADERFORMAT_SPIRV;
-		vertex_info.stage = SDL_GPU_SHADERSTAGE_VERTEX;
-		vertex_info.num_samplers = 0;
-		vertex_info.num_storage_textures = 0;
-		vertex_info.num_storage_buffers = 0;
-		vertex_info.num_uniform_buffers = 2;
-		vertex_shader = SDL_CreateGPUShader(gpu, &vertex_info);
-
-		SDL_GPUShaderCreateInfo fragment_info = {};
-		fragment_info.code_size = fragment_size;
-		fragment_info.code = (u8*)plain_fragment;
-		fragment_info.entrypoint = "main";
-		fragment_info.format = SDL_GPU_SHADERFORMAT_SPIRV;
-		fragment_info.stage = SDL_GPU_SHADERSTAGE_FRAGMENT;
-		fragment_info.num_samplers = 0;
-		fragment_info.num_storage_textures = 0;
-		fragment_info.num_storage_buffers = 0;
-		fragment_info.num_uniform_buffers = 2;
-		fragment_shader = SDL_CreateGPUShader(gpu, &fragment_info);
-	}
-
-	if (!vertex_shader || !fragment_shader) {
-		printf("Failed to create shaders: %s\n", SDL_GetError());
-		return false;
-	}
-
-	SDL_GPUColorTargetDescription color_target_desc[] = {
-		{
-			.format = format,
-		}
-	};
-	SDL_GPUVertexBufferDescription vertex_buffer_desc[] = {
-		{
-			.slot = 0,
-			.pitch = sizeof(Vector2f),
-			.input_rate = SDL_GPU_VERTEXINPUTRATE_VERTEX
-		}
-	};
-	SDL_GPUVertexAttribute vertex_attributes[] = {
-		{
-			.location = 0,
-			.buffer_slot = 0,
-			.format = SDL_GPU_VERTEXELEMENTFORMAT_FLOAT2,
-			.offset = 0,
-		}
-	};
-	SDL_GPUGraphicsPipelineCreateInfo info = {
-		.vertex_shader = vertex_shader,
-		.fragment_shader = fragment_shader,
-		.vertex_input_state = {
-			.vertex_buffer_descriptions = vertex_buffer_desc,
-			.num_vertex_buffers = sizeof(vertex_buffer_desc) / sizeof(*vertex_buffer_desc),
-			.vertex_attributes = vertex_attributes,
-	},
-		.primitive_type = SDL_GPU_PRIMITIVETYPE_TRIANGLELIST,
-		.rasterizer_state = {
-			.fill_mode = SDL_GPU_FILLMODE_FILL,
-			.cull_mode = SDL_GPU_CULLMODE_NONE,
-			.front_face = SDL_GPU_FRONTFACE_COUNTER_CLOCKWISE,
-		},
-		.multisample_state = {
-			.sample_count = SDL_GPU_SAMPLECOUNT_1,
-		},
-		.depth_stencil_state = {
-			.enable_depth_test = false,
-			.enable_depth_write = false,
-			.enable_stencil_test = false,
-		},
-		.target_info = {
-			.color_target_descriptions = color_target_desc,
-			.num_color_targets = sizeof(color_target_desc) / sizeof(*color_target_desc),
-			.has_depth_stencil_target = false,
-		},
-	};
-	if (pipeline)
-		SDL_ReleaseGPUGraphicsPipeline(gpu, pipeline);
-	pipeline = SDL_CreateGPUGraphicsPipeline(gpu, &info);
-	if (!pipeline) {
-		printf("Failed to create graphics pipeline: %s\n", SDL_GetError());
-		return false;
-	}
-
-	SDL_ReleaseGPUShader(gpu, vertex_shader);
-	SDL_ReleaseGPUShader(gpu, fragment_shader);
-	return true;
+	Pipeline_Desc desc = FullscreenQuad::pipeline_desc();
+	desc.vertex = { .path = "assets/shaders/vert_post.spv", .num_uniform_buffers = 2 };
+	desc.fragment = { .path = "assets/shaders/frag_post.spv", .num_uniform_buffers = 2 };
+	desc.color_targets = { { .format = format } };
+	pipeline = Pipeline_Factory::factory.create(gpu, desc);
+	return pipeline != nullptr;
 }
 
 void Postprocess::release(SDL_GPUDevice* gpu)
 {
-	if (pipeline) {
-		SDL_ReleaseGPUGraphicsPipeline(gpu, pipeline);
-	}
+	// The pipeline belongs to Pipeline_Factory::factory.
 	pipeline = nullptr;
 }
 
@@ -2,7 +2,10 @@
 
 #include "Common.hpp"
 #include "Maths.hpp"
+#include "RenderSettings.hpp"
 #include "SDL3/SDL_gpu.h"
+#include <string>
+#include <unordered_map>
 #include <vector>
 
 struct Common_Uniform {
@@ -11,6 +14,74 @@ struct Common_Uniform {
 	Matrix4f projection;
 };
 
+// One stage of a Pipeline_Desc, path is a compiled SPIR-V file.
+struct Shader_Desc {
+	const char* path = nullptr;
+	u32 num_samplers = 0;
+	u32 num_uniform_buffers = 0;
+};
+
+// Everything a graphics pipeline is made of, as plain data.
+struct Pipeline_Desc {
+	Shader_Desc vertex;
+	Shader_Desc fragment;
+	std::vector<SDL_GPUVertexBufferDescription> vertex_buffers;
+	std::vector<SDL_GPUVertexAttribute> vertex_attributes;
+	SDL_GPUPrimitiveType primitive_type = SDL_GPU_PRIMITIVETYPE_TRIANGLELIST;
+	SDL_GPURasterizerState rasterizer_state = {
+		.fill_mode = SDL_GPU_FILLMODE_FILL,
+		.cull_mode = SDL_GPU_CULLMODE_NONE,
+		.front_face = SDL_GPU_FRONTFACE_COUNTER_CLOCKWISE,
+	};
+	SDL_GPUSampleCount sample_count = SDL_GPU_SAMPLECOUNT_1;
+	SDL_GPUDepthStencilState depth_stencil_state = {};
+	std::vector<SDL_GPUColorTargetDescription> color_targets;
+	SDL_GPUTextureFormat depth_stencil_format = SDL_GPU_TEXTUREFORMAT_INVALID;
+	bool has_depth_stencil_target = false;
+};
+
+// Creates the graphics pipelines and owns them with the shaders they are made of.
+//
+// A shader file is read and created once per Shader_Desc, then kept by path until forget_shader
+// says it was compiled again. Pipelines are keyed by the hash of their desc, with the paths
+// replaced by the hash of the shaders' code, asking for one the factory already holds returns it
+// instead of creating a duplicate. The unchanged pipelines of an owner, or going back to previous
+// render settings create nothing. A pipeline lives until forget_shader drops one of its shaders,
+// or until release.
+struct Pipeline_Factory {
+	struct Shader_Module {
+		std::string path;
+		u64 hash = 0; // of the code and the Shader_Desc
+		SDL_GPUShader* shader = nullptr;
+	};
+	// By hash of the path, the stage and the Shader_Desc.
+	std::unordered_map<u64, Shader_Module> shaders;
+	struct Pipeline {
+		u64 vertex = 0; // Shader_Module::hash of its stages
+		u64 fragment = 0;
+		SDL_GPUGraphicsPipeline* pipeline = nullptr;
+	};
+	// By hash of the Pipeline_Desc.
+	std::unordered_map<u64, Pipeline> pipelines;
+
+	usz files_read = 0;
+	usz shaders_created = 0;
+	usz pipelines_created = 0;
+	usz pipelines_reused = 0;
+
+	SDL_GPUGraphicsPipeline* create(SDL_GPUDevice* gpu, const Pipeline_Desc& desc);
+	// The next pipeline using path reads it again. The pipelines made from it are released, their
+	// owners have to create them again.
+	void forget_shader(SDL_GPUDevice* gpu, const char* path);
+	void release(SDL_GPUDevice* gpu);
+
+	const Shader_Module* shader(
+		SDL_GPUDevice* gpu, const Shader_Desc& desc, SDL_GPUShaderStage stage
+	);
+
+	static Pipeline_Factory factory;
+};
+
 struct FullscreenQuad {
 	SDL_GPUBuffer* vertex_buffer = nullptr;
 	SDL_GPUTransferBuffer* transfer_buffer = nullptr;
@@ -18,6 +89,9 @@ struct FullscreenQuad {
 	SDL_GPUFence* upload(SDL_GPUDevice* gpu);
 	void release(SDL_GPUDevice* gpu);
 
+	// A desc drawing the quad: its vertex layout, the rest as Pipeline_Desc defaults it.
+	static Pipeline_Desc pipeline_desc();
+
 	static FullscreenQuad quad;
 };
 
@@ -29,6 +103,13 @@ struct WorldArrow {
 	usz instance_buffer_size = 0;
 	usz n_instances = 0;
 
+	struct Range {
+		u32 first;
+		u32 count;
+	};
+	// Instances render draws, set_instances resets it to all of them.
+	std::vector<Range> ranges;
+
 	struct Uniform {
 	};
 
@@ -48,7 +129,7 @@ struct WorldArrow {
 		f32 scale;
 	};
 
-	bool create_pipeline(SDL_GPUDevice* gpu, SDL_GPUTextureFormat format);
+	bool create_pipeline(SDL_GPUDevice* gpu, const Render_Settings& settings);
 	void set_instances(
 		SDL_GPUDevice* gpu,
 		Instance* instance_data,
@@ -0,0 +1,232 @@
+#include "HeightCache.hpp"
+
+#include "AssetLoader.hpp"
+#include "DiskCache.hpp"
+#include "Parallel.hpp"
+
+#include "SDL3/SDL.h"
+
+#include <algorithm>
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+static constexpr u32 Height_Cache_Magic = 0x42554348; // "HCUB"
+static constexpr u32 Height_Cache_Version = 1;
+static constexpr const char* Height_Cache_Directory = Disk_Cache_Directory;
+// About 25 MB each at 1024.
+static constexpr usz Height_Cache_Max_Files = 8;
+
+struct Height_Cache_Header {
+	u32 magic;
+	u32 version;
+	Height_Cache_Key key;
+};
+
+void height_cache_path(const Height_Cache_Key& key, char* path, size_t size) {
+	// FNV-1a of the key, every field is 4 bytes so there is no padding to hash.
+	u32 hash = 2166136261u;
+	const u8* bytes = (const u8*)&key;
+	for (size_t i = 0; i < sizeof(key); i += 1) {
+		hash ^= bytes[i];
+		hash *= 16777619u;
+	}
+	snprintf(path, size, "%s/height_%u_%08x.bin", Height_Cache_Directory, key.resolution, hash);
+}
+
+// Direction through the center of texel (i, j) of face f.
+static Vector3f cube_direction(size_t f, size_t i, size_t j, size_t resolution) {
+	f32 s = ((f32)i + 0.5f) / (f32)resolution * 2.f - 1.f;
+	f32 t = ((f32)j + 0.5f) / (f32)resolution * 2.f - 1.f;
+	f32 sign = (f & 1) ? -1.f : 1.f;
+	switch (f / 2) {
+	case 0: return { sign, t, s };
+	case 1: return { s, sign, t };
+	default: return { s, t, sign };
+	}
+}
+
+// Appends the box filtered levels below levels[0], down to 1 texel per face.
+static void build_levels(std::vector<std::vector<f32>>& levels, size_t resolution) {
+	for (size_t half = resolution / 2; half >= 1; half /= 2) {
+		const f32* src = levels.back().data();
+		std::vector<f32> dst(6 * half * half);
+
+		parallel_for(6 * half, std::max<size_t>(1, 16 * 1024 / half), [&] (usz begin, usz end) {
+			for (usz row = begin; row < end; row += 1) {
+				const f32* a = src + row * 2 * (half * 2);
+				const f32* b = a + half * 2;
+				for (size_t i = 0; i < half; i += 1) {
+					dst[row * half + i] =
+						(a[i * 2] + a[i * 2 + 1] + b[i * 2] + b[i * 2 + 1]) * 0.25f;
+				}
+			}
+		});
+
+		levels.push_back(std::move(dst));
+	}
+}
+
+void Height_Cube::prepare(const Height_Cache_Key& k) {
+	if (valid && key == k)
+		return;
+	if (load(k))
+		return;
+
+	bake(k);
+
+	// Every slider step is a new key, only the ones asked for again are worth a file.
+	char path[256];
+	height_cache_path(k, path, sizeof(path));
+	if (disk_cache_seen_before(path) && !save())
+		printf("Failed to save the height cache: %s\n", SDL_GetError());
+}
+
+void Height_Cube::bake(const Height_Cache_Key& k) {
+	key = k;
+	size_t r = key.resolution;
+
+	levels.clear();
+	levels.emplace_back(6 * r * r);
+	f32* texels = levels[0].data();
+
+	// One row of a face per fractal_noise call, rows are spread over the workers.
+	parallel_for(6 * r, std::max<size_t>(1, 16 * 1024 / r), [&] (usz begin, usz end) {
+		std::vector<f32> xs(r);
+		std::vector<f32> ys(r);
+		std::vector<f32> zs(r);
+
+		for (usz row = begin; row < end; row += 1) {
+			for (size_t i = 0; i < r; i += 1) {
+				Vector3f p = normalize(cube_direction(row / r, i, row % r, r));
+				p = p * 0.5f + Vector3f(0.5f, 0.5f, 0.5f);
+				xs[i] = p.x;
+				ys[i] = p.y;
+				zs[i] = p.z;
+			}
+			fractal_noise(
+				(Noise_Basis)key.basis,
+				xs.data(),
+				ys.data(),
+				zs.data(),
+				texels + row * r,
+				r,
+				key.octave,
+				key.roughness,
+				key.lacunarity
+			);
+		}
+	});
+
+	build_levels(levels, r);
+	valid = true;
+}
+
+bool Height_Cube::load(const Height_Cache_Key& k) {
+	char path[256];
+	height_cache_path(k, path, sizeof(path));
+
+	usz size = 0;
+	void* data = Asset_Loader::loader.load(path, &size);
+	if (!data)
+		return false;
+	defer {
+		SDL_free(data);
+	};
+
+	size_t r = k.resolution;
+	size_t expected = sizeof(Height_Cache_Header) + 6 * r * r * sizeof(f32);
+	Height_Cache_Header header;
+	if (size != expected)
+		return false;
+	memcpy(&header, data, sizeof(header));
+	if (
+		header.magic != Height_Cache_Magic ||
+		header.version != Height_Cache_Version ||
+		!(header.key == k)
+	)
+		return false;
+
+	// Only level 0 is on disk, the smaller levels are cheaper to rebuild than to read.
+	key = k;
+	levels.clear();
+	levels.emplace_back(6 * r * r);
+	memcpy(levels[0].data(), (u8*)data + sizeof(header), levels[0].size() * sizeof(f32));
+
+	build_levels(levels, r);
+	valid = true;
+	disk_cache_touch(path);
+	return true;
+}
+
+bool Height_Cube::save() const {
+	if (!valid)
+		return false;
+
+	char path[256];
+	height_cache_path(key, path, sizeof(path));
+	SDL_CreateDirectory(Height_Cache_Directory);
+
+	Height_Cache_Header header = { Height_Cache_Magic, Height_Cache_Version, key };
+	std::vector<u8> data(sizeof(header) + levels[0].size() * sizeof(f32));
+	memcpy(data.data(), &header, sizeof(header));
+	memcpy(data.data() + sizeof(header), levels[0].data(), levels[0].size() * sizeof(f32));
+	if (!SDL_SaveFile(path, data.data(), data.size()))
+		return false;
+	disk_cache_trim("height_", Height_Cache_Max_Files);
+	return true;
+}
+
+size_t Height_Cube::level_for(size_t tile_count) const {
+	f32 tiles_per_edge = sqrtf((f32)tile_count / 6.f);
+	size_t level = 0;
+	size_t r = key.resolution;
+	while (level + 1 < levels.size() && (f32)(r / 2) >= 2.f * tiles_per_edge) {
+		level += 1;
+		r /= 2;
+	}
+	return level;
+}
+
+f32 Height_Cube::sample(Vector3f dir, size_t level) const {
+	size_t r = key.resolution >> level;
+	const f32* texels = levels[level].data();
+
+	f32 ax = fabsf(dir.x);
+	f32 ay = fabsf(dir.y);
+	f32 az = fabsf(dir.z);
+	size_t f;
+	f32 s;
+	f32 t;
+	if (ax >= ay && ax >= az) {
+		f = dir.x < 0 ? 1 : 0;
+		s = dir.z / ax;
+		t = dir.y / ax;
+	} else if (ay >= az) {
+		f = dir.y < 0 ? 3 : 2;
+		s = dir.x / ay;
+		t = dir.z / ay;
+	} else {
+		f = dir.z < 0 ? 5 : 4;
+		s = dir.x / az;
+		t = dir.y / az;
+	}
+
+	// Texel centers sit at (i + 0.5) / r, the lookup clamps to the face instead of crossing
+	// over to its neighbour so the face edges are half a texel of constant height.
+	f32 max_coord = (f32)(r - 1);
+	f32 u = std::clamp((s * 0.5f + 0.5f) * (f32)r - 0.5f, 0.f, max_coord);
+	f32 v = std::clamp((t * 0.5f + 0.5f) * (f32)r - 0.5f, 0.f, max_coord);
+	size_t i0 = (size_t)u;
+	size_t j0 = (size_t)v;
+	size_t i1 = std::min(i0 + 1, r - 1);
+	size_t j1 = std::min(j0 + 1, r - 1);
+	f32 fu = u - (f32)i0;
+	f32 fv = v - (f32)j0;
+
+	const f32* row0 = texels + (f * r + j0) * r;
+	const f32* row1 = texels + (f * r + j1) * r;
+	f32 h0 = row0[i0] + (row0[i1] - row0[i0]) * fu;
+	f32 h1 = row1[i0] + (row1[i1] - row1[i0]) * fu;
+	return h0 + (h1 - h0) * fv;
+}
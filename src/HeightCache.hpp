@@ -0,0 +1,43 @@
+#pragma once
+
+#include "Common.hpp"
+#include "Maths.hpp"
+#include "Noise.hpp"
+
+#include <vector>
+
+// Everything the baked heights depend on, two caches with equal keys hold the same texels.
+struct Height_Cache_Key {
+	u32 basis = 0;
+	u32 octave = 0;
+	f32 roughness = 0.f;
+	f32 lacunarity = 0.f;
+	u32 resolution = 0;
+
+	bool operator==(const Height_Cache_Key& other) const = default;
+};
+
+// Where the heights of key are cached on disk.
+extern void height_cache_path(const Height_Cache_Key& key, char* path, size_t size);
+
+// Fractal noise baked on the unit sphere into a cube map, the tiles of every order sample it
+// instead of evaluating the noise. Face f, texel (i, j) of a level of resolution r is stored at
+// (f * r + j) * r + i, faces are +X -X +Y -Y +Z -Z. Level 0 is key.resolution texels wide, each
+// following level halves it with a box filter down to 1.
+struct Height_Cube {
+	Height_Cache_Key key;
+	std::vector<std::vector<f32>> levels;
+	bool valid = false;
+
+	// In memory if the key matches, then from the disk cache, else bakes it. The bake is saved
+	// when the key was asked for before, save only keeps the most recently used files.
+	void prepare(const Height_Cache_Key& key);
+	void bake(const Height_Cache_Key& key);
+	bool load(const Height_Cache_Key& key);
+	bool save() const;
+
+	// Coarsest level with at least two texels per tile edge for a sphere split in tile_count.
+	size_t level_for(size_t tile_count) const;
+	// Bilinear lookup of the height in direction dir, dir does not need to be normalized.
+	f32 sample(Vector3f dir, size_t level) const;
+};
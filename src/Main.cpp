@@ -1,4 +1,5 @@
 #include "Common.hpp"
+#include "AssetLoader.hpp"
 
 #include "SDL3/SDL.h"
 #include "SDL3/SDL_main.h"
@@ -7,86 +8,91 @@
 #include "imgui/imgui_impl_sdl3.h"
 #include "imgui/imgui_impl_sdlgpu3.h"
 
+#include <algorithm>
 #include <stdio.h>
 #include <vector>
 #include <optional>
 #include <unordered_map>
 
 #include "Maths.hpp"
+#include "Camera.hpp"
 #include "Noise.hpp"
 #include "Planet.hpp"
 #include "Cosmos.hpp"
 #include "Graphics.hpp"
 #include "Atmosphere.hpp"
-
-struct Camera {
-	Vector3f position;
-	Vector3f target;
-	Vector3f up;
-
-	f32 speed = 100.f;
-
-	f32 fov = 45.5f;
-	f32 aspect = 16.0f / 9.0f;
-	f32 near = 0.1f;
-	f32 far = 100.0f;
-
-	Vector3f unproject_ray_ndc(f32 x, f32 y) {
-		Vector3f ndc = { x, y, -1.0f };
-
-		Matrix4f proj = perspective(fov, aspect, near, far);
-		Matrix4f view = lookAt(position, target, up);
-
-		Vector4f ray_eye = inverse(proj) * Vector4f(ndc, 1.0f);
-		ray_eye.z = -1.0f;
-		ray_eye.w = 0.0f;
-
-		Vector3f ray_world = (Vector3f)(view * ray_eye);
-		return normalize(ray_world);
-	}
-	Vector3f unproject_ray(f32 x, f32 y) {
-		Vector3f ndc = {
-			2.0f * x - 1.0f,
-			1.0f - 2.0f * y,
-			-1.0f
-		};
-		return unproject_ray_ndc(ndc.x, ndc.y);
-
-	}
-};
+#include "AtmosphereReference.hpp"
+#include "Bench.hpp"
+#include "RenderScale.hpp"
+#include "RenderSettings.hpp"
+#include "ShaderBuild.hpp"
+#include "ShaderWatcher.hpp"
 
 struct Targets {
 	size_t width = 1366;
 	size_t height = 768;
+	Render_Settings settings;
+	// Multisampled, null with a single sample where the scene draws in the resolve texture.
 	SDL_GPUTexture* color_texture = nullptr;
 	SDL_GPUTexture* depth_texture = nullptr;
 
 	SDL_GPUTexture* resolve_texture = nullptr;
+
+	// The atmosphere at render scale, upsampled over the color texture.
+	size_t scaled_width = 1366;
+	size_t scaled_height = 768;
+	SDL_GPUTexture* scaled_texture = nullptr;
 };
 
-void destroy_targets(SDL_GPUDevice* gpu, Targets& targets);
-bool update_targets(SDL_GPUDevice* gpu, Targets& targets) {
-	destroy_targets(gpu, targets);
+bool update_scaled_targets(SDL_GPUDevice* gpu, Targets& targets, const Render_Scale& scale) {
+	if (targets.scaled_texture)
+		SDL_ReleaseGPUTexture(gpu, targets.scaled_texture);
 
-	SDL_GPUTextureCreateInfo color_texture_info = {
+	targets.scaled_width = scale.apply((u32)targets.width);
+	targets.scaled_height = scale.apply((u32)targets.height);
+	SDL_GPUTextureCreateInfo scaled_texture_info = {
 		.type = SDL_GPU_TEXTURETYPE_2D,
-		.format = SDL_GPU_TEXTUREFORMAT_R32G32B32A32_FLOAT,
-		.usage = SDL_GPU_TEXTUREUSAGE_COLOR_TARGET,
-		.width = (u32)targets.width,
-		.height = (u32)targets.height,
+		.format = targets.settings.scaled_format,
+		.usage = SDL_GPU_TEXTUREUSAGE_COLOR_TARGET | SDL_GPU_TEXTUREUSAGE_SAMPLER,
+		.width = (u32)targets.scaled_width,
+		.height = (u32)targets.scaled_height,
 		.layer_count_or_depth = 1,
 		.num_levels = 1,
-		.sample_count = SDL_GPU_SAMPLECOUNT_8,
+		.sample_count = SDL_GPU_SAMPLECOUNT_1,
 	};
-	targets.color_texture = SDL_CreateGPUTexture(gpu, &color_texture_info);
-	if (!targets.color_texture) {
-		printf("Failed to create color texture: %s\n", SDL_GetError());
+	targets.scaled_texture = SDL_CreateGPUTexture(gpu, &scaled_texture_info);
+	if (!targets.scaled_texture) {
+		printf("Failed to create scaled texture: %s\n", SDL_GetError());
 		return false;
 	}
+	return true;
+}
+
+void destroy_targets(SDL_GPUDevice* gpu, Targets& targets);
+bool update_targets(SDL_GPUDevice* gpu, Targets& targets, const Render_Scale& scale) {
+	destroy_targets(gpu, targets);
+
+	if (targets.settings.sample_count != SDL_GPU_SAMPLECOUNT_1) {
+		SDL_GPUTextureCreateInfo color_texture_info = {
+			.type = SDL_GPU_TEXTURETYPE_2D,
+			.format = targets.settings.color_format,
+			.usage = SDL_GPU_TEXTUREUSAGE_COLOR_TARGET,
+			.width = (u32)targets.width,
+			.height = (u32)targets.height,
+			.layer_count_or_depth = 1,
+			.num_levels = 1,
+			.sample_count = targets.settings.sample_count,
+		};
+		targets.color_texture = SDL_CreateGPUTexture(gpu, &color_texture_info);
+		if (!targets.color_texture) {
+			printf("Failed to create color texture: %s\n", SDL_GetError());
+			return false;
+		}
+	}
 
 	SDL_GPUTextureCreateInfo resolve_texture_info = {
 		.type = SDL_GPU_TEXTURETYPE_2D,
-		.format = SDL_GPU_TEXTUREFORMAT_R32G32B32A32_FLOAT,
+		.format = targets.settings.color_format,
 		.usage = SDL_GPU_TEXTUREUSAGE_COLOR_TARGET | SDL_GPU_TEXTUREUSAGE_SAMPLER,
 		.width = (u32)targets.width,
 		.height = (u32)targets.height,
@@ -102,20 +108,20 @@ bool update_targets(SDL_GPUDevice* gpu, Targets& targets) {
 
 	SDL_GPUTextureCreateInfo depth_texture_info = {
 		.type = SDL_GPU_TEXTURETYPE_2D,
-		.format = SDL_GPU_TEXTUREFORMAT_D32_FLOAT,
+		.format = targets.settings.depth_format,
 		.usage = SDL_GPU_TEXTUREUSAGE_DEPTH_STENCIL_TARGET,
 		.width = (u32)targets.width,
 		.height = (u32)targets.height,
 		.layer_count_or_depth = 1,
 		.num_levels = 1,
-		.sample_count = SDL_GPU_SAMPLECOUNT_8,
+		.sample_count = targets.settings.sample_count,
 	};
 	targets.depth_texture = SDL_CreateGPUTexture(gpu, &depth_texture_info);
 	if (!targets.depth_texture) {
 		printf("Failed to create depth texture: %s\n", SDL_GetError());
 		return false;
 	}
-	return true;
+	return update_scaled_targets(gpu, targets, scale);
 }
 void destroy_targets(SDL_GPUDevice* gpu, Targets& targets) {
 	if (targets.color_texture) {
@@ -130,46 +136,35 @@ void destroy_targets(SDL_GPUDevice* gpu, Targets& targets) {
 		SDL_ReleaseGPUTexture(gpu, targets.resolve_texture);
 		targets.resolve_texture = nullptr;
 	}
-}
-#include <filesystem>
-
-void compile_shaders() {
-	std::filesystem::path shader_dir = std::filesystem::current_path() / "src" / "shaders";
-
-	// for every file in the shader directory
-	for (const std::filesystem::directory_entry& entry : std::filesystem::directory_iterator(shader_dir))
-	{
-		// if the file is a file
-		if (entry.is_regular_file()) {
-			// if the file is a shader file
-			if (entry.path().extension() == ".frag") {
-				// compile the shader
-				std::string output_name = "frag_" + entry.path().filename().replace_extension(".spv").generic_string();
-				std::filesystem::path input_path = entry.path();
-				std::filesystem::path output_path =
-					std::filesystem::current_path() / "assets" / "shaders" / output_name;
-
-				std::string command = "glslc " + input_path.generic_string();
-				command += " -o " + output_path.generic_string();
-				printf("Compiling fragment shader: %s\n", command.c_str());
-				system(command.c_str());
-			}
-			else if (entry.path().extension() == ".vert") {
-				// compile the shader
-				std::string output_name = "vert_" + entry.path().filename().replace_extension(".spv").generic_string();
-				std::filesystem::path input_path = entry.path();
-				std::filesystem::path output_path =
-					std::filesystem::current_path() / "assets" / "shaders" / output_name;
-
-				std::string command = "glslc " + input_path.generic_string();
-				command += " -o " + output_path.generic_string();
-				printf("Compiling vertex shader:   %s\n", command.c_str());
-				system(command.c_str());
-			}
-		}
+	if (targets.scaled_texture) {
+		SDL_ReleaseGPUTexture(gpu, targets.scaled_texture);
+		targets.scaled_texture = nullptr;
 	}
 }
 
+// Recreates the pipelines of the shaders that were compiled again, the others stay as they are.
+void reload_pipelines(
+	SDL_GPUDevice* gpu,
+	const Shader_Build_Result& shaders,
+	const Render_Settings& settings,
+	Planet& planet,
+	Cosmos& cosmos,
+	Atmosphere& atmosphere
+) {
+	for (const std::string& path : shaders.outputs)
+		Pipeline_Factory::factory.forget_shader(gpu, path.c_str());
+
+	if (shaders.touched("planet"))
+		planet.mesh.create_pipeline(gpu, settings);
+	if (shaders.touched("arrow"))
+		planet.vector_field.create_pipeline(gpu, settings);
+	if (shaders.touched("cosmos"))
+		cosmos.create_pipeline(gpu, settings);
+	// Both of its pipelines use vert_atmosphere, Pipeline_Factory::factory hands back the one
+	// whose shaders did not change.
+	if (shaders.touched("atmosphere") || shaders.touched("upsample"))
+		atmosphere.create_pipeline(gpu, settings);
+}
 
 int main(int argc, char** argv) {
 	defer {
@@ -188,6 +183,23 @@ int main(int argc, char** argv) {
 		SDL_QuitSubSystem(flags);
 	};
 
+	// Every file the boot reads, in flight while the window and the device are created. The
+	// pipelines and the caches below wait only for their own files.
+	u64 boot_ns = SDL_GetTicksNS();
+	Asset_Loader::loader.request_directory("assets/shaders", ".spv");
+	{
+		char path[256];
+		Cosmos sky;
+		sky_cache_path(sky.current_key(sky.cube_size), path, sizeof(path));
+		Asset_Loader::loader.request(path);
+
+		Height_Cache_Key key = Planet::height_cache_key(Planet::Generation_Param());
+		if (key.resolution > 0) {
+			height_cache_path(key, path, sizeof(path));
+			Asset_Loader::loader.request(path);
+		}
+	}
+
 	SDL_Window* window = nullptr;
 
 	SDL_WindowFlags window_flags = 0;
@@ -215,6 +227,9 @@ int main(int argc, char** argv) {
 	defer {
 		SDL_DestroyGPUDevice(gpu);
 	};
+	defer {
+		Pipeline_Factory::factory.release(gpu);
+	};
 
 	if (!SDL_ClaimWindowForGPUDevice(gpu, window)) {
 		printf("Failed to claim window for GPU device: %s\n", SDL_GetError());
@@ -222,8 +237,9 @@ int main(int argc, char** argv) {
 	}
 
 	Targets targets;
+	Render_Scale render_scale;
 
-	if (!update_targets(gpu, targets)) {
+	if (!update_targets(gpu, targets, render_scale)) {
 		return 1;
 	}
 	defer {
@@ -239,7 +255,7 @@ int main(int argc, char** argv) {
 	Camera arcball_camera = camera;
 
 	Cosmos cosmos;
-	cosmos.create_pipeline(gpu);
+	cosmos.create_pipeline(gpu, targets.settings);
 	defer {
 		cosmos.release(gpu);
 	};
@@ -247,17 +263,23 @@ int main(int argc, char** argv) {
 	Planet planet;
 	planet.generate_icosphere(gpu, planet.order);
 	planet.generate_from_mesh(planet.generation_param);
-	planet.create_pipeline(gpu, SDL_GPU_TEXTUREFORMAT_R32G32B32A32_FLOAT);
+	planet.create_pipeline(gpu, targets.settings);
 	defer {
 		planet.release(gpu);
 	};
 
 	Atmosphere atmosphere;
-	atmosphere.create_pipeline(gpu);
+	atmosphere.create_pipeline(gpu, targets.settings);
 	defer {
 		atmosphere.release(gpu);
 	};
 
+	// The first update would read it, boot takes it while the file is still in flight. A cold
+	// start saves its bake right away so the next launch loads it.
+	cosmos.prepare_cubemap(cosmos.cube_size, true);
+	Asset_Loader::loader.finish();
+	printf("Boot: %.2f ms\n", (SDL_GetTicksNS() - boot_ns) / 1e6);
+
 	Common_Uniform common_uniform = {};
 
 	ImGui::CreateContext();
@@ -292,6 +314,14 @@ int main(int argc, char** argv) {
 	SDL_Event event;
 
 	bool render_imgui = true;
+	// Primary and light steps of the offline atmosphere render.
+	int reference_steps[2] = { 256, 64 };
+
+	Shader_Watcher shader_watcher;
+	shader_watcher.start();
+	defer {
+		shader_watcher.stop();
+	};
 
 	ImGuiIO& io = ImGui::GetIO();
 	float target_camera_distance = length(camera.position);
@@ -343,7 +373,7 @@ int main(int argc, char** argv) {
 				if (ok && w > 0 && h > 0) {
 					targets.width = w;
 					targets.height = h;
-					if (!update_targets(gpu, targets)) {
+					if (!update_targets(gpu, targets, render_scale)) {
 						return 1;
 					}
 				} else {
@@ -372,6 +402,29 @@ int main(int argc, char** argv) {
 
 			ImGui::Begin("Atmosphere");
 			atmosphere.imgui();
+			if (ImGui::CollapsingHeader("Reference render")) {
+				ImGui::InputInt2("Steps", reference_steps);
+				if (ImGui::Button("Render to screenshot/atmosphere.pfm")) {
+					Atmosphere_Image image;
+					image.width = (u32)targets.width;
+					image.height = (u32)targets.height;
+
+					u64 start = SDL_GetPerformanceCounter();
+					render_atmosphere(
+						atmosphere.uniform,
+						camera,
+						std::max(reference_steps[0], 1),
+						std::max(reference_steps[1], 1),
+						image
+					);
+					f64 seconds = (f64)(SDL_GetPerformanceCounter() - start)
+						/ (f64)SDL_GetPerformanceFrequency();
+					printf("Rendered the atmosphere in %.2f s\n", seconds);
+
+					if (!save_pfm(image, "screenshot/atmosphere.pfm"))
+						printf("Failed to save the atmosphere: %s\n", SDL_GetError());
+				}
+			}
 			ImGui::End();
 
 			ImGui::Begin("Postprocess");
@@ -381,6 +434,87 @@ int main(int argc, char** argv) {
 			ImGui::Text("FPS: % 5.2f, MS: % 5.2f ms", 1.0f / dt, (dt * 1000));
 			ImGui::Checkbox("Show planet", &show_planet);
 
+			if (ImGui::CollapsingHeader("Render scale")) {
+				// Vsync would hold every frame at the refresh rate, the controller needs the real
+				// frame times.
+				bool dynamic = render_scale.dynamic;
+				if (ImGui::Checkbox("Dynamic", &dynamic)) {
+					SDL_GPUPresentMode mode = SDL_GPU_PRESENTMODE_VSYNC;
+					if (
+						dynamic &&
+						SDL_WindowSupportsGPUPresentMode(gpu, window, SDL_GPU_PRESENTMODE_IMMEDIATE)
+					)
+						mode = SDL_GPU_PRESENTMODE_IMMEDIATE;
+					SDL_SetGPUSwapchainParameters(
+						gpu, window, SDL_GPU_SWAPCHAINCOMPOSITION_SDR, mode
+					);
+					render_scale.dynamic = dynamic;
+					render_scale.smoothed_ms = 0.f;
+				}
+				if (render_scale.dynamic) {
+					ImGui::SliderFloat("Target ms", &render_scale.target_ms, 2.f, 50.f);
+					ImGui::Text(
+						"Scale %.3f, %.2f ms", render_scale.scale, render_scale.smoothed_ms
+					);
+				} else {
+					ImGui::SliderFloat(
+						"Scale", &render_scale.scale, render_scale.min_scale, render_scale.max_scale
+					);
+					render_scale.scale =
+						roundf(render_scale.scale / render_scale.step) * render_scale.step;
+				}
+				ImGui::Text(
+					"Atmosphere at %zu x %zu", targets.scaled_width, targets.scaled_height
+				);
+			}
+			if (ImGui::CollapsingHeader("Render targets")) {
+				if (render_settings_imgui(gpu, targets.settings)) {
+					if (!update_targets(gpu, targets, render_scale))
+						return 1;
+					planet.create_pipeline(gpu, targets.settings);
+					cosmos.create_pipeline(gpu, targets.settings);
+					atmosphere.create_pipeline(gpu, targets.settings);
+				}
+
+				Render_Target_Memory memory = render_target_memory(
+					targets.settings,
+					(u32)targets.width,
+					(u32)targets.height,
+					(u32)targets.scaled_width,
+					(u32)targets.scaled_height
+				);
+				constexpr f64 MiB = 1024.0 * 1024.0;
+				ImGui::Text(
+					"Color %.1f, depth %.1f, resolve %.1f, atmosphere %.1f MiB",
+					memory.color / MiB,
+					memory.depth / MiB,
+					memory.resolve / MiB,
+					memory.scaled / MiB
+				);
+				ImGui::Text("Total %.1f MiB", memory.total() / MiB);
+
+				// What the other sample counts would cost with these formats.
+				for (SDL_GPUSampleCount count : {
+					SDL_GPU_SAMPLECOUNT_1,
+					SDL_GPU_SAMPLECOUNT_2,
+					SDL_GPU_SAMPLECOUNT_4,
+					SDL_GPU_SAMPLECOUNT_8
+				}) {
+					Render_Settings other = targets.settings;
+					other.sample_count = count;
+					Render_Target_Memory m = render_target_memory(
+						other,
+						(u32)targets.width,
+						(u32)targets.height,
+						(u32)targets.scaled_width,
+						(u32)targets.scaled_height
+					);
+					ImGui::Text(
+						"  %ux MSAA: %.1f MiB", sample_count_value(count), m.total() / MiB
+					);
+				}
+			}
+
 			if (ImGui::CollapsingHeader("Camera")) {
 				ImGui::SliderFloat("FOV", &camera.fov, 1.0f, 179.0f);
 				arcball_camera.fov = camera.fov;
@@ -414,12 +548,39 @@ int main(int argc, char** argv) {
 				}
 			}
 			if (ImGui::CollapsingHeader("Shaders")) {
+				bool watching = shader_watcher.running();
+				if (ImGui::Checkbox("Watch sources", &watching)) {
+					if (watching)
+						shader_watcher.start();
+					else
+						shader_watcher.stop();
+				}
 				if (ImGui::Button("Reload")) {
-					compile_shaders();
-					planet.create_pipeline(gpu, SDL_GPU_TEXTUREFORMAT_R32G32B32A32_FLOAT);
-					cosmos.create_pipeline(gpu);
-					atmosphere.create_pipeline(gpu);
+					if (watching) {
+						shader_watcher.request_build();
+					} else {
+						Shader_Build_Result shaders = build_shaders();
+						reload_pipelines(
+							gpu, shaders, targets.settings, planet, cosmos, atmosphere
+						);
+					}
 				}
+				const Pipeline_Factory& factory = Pipeline_Factory::factory;
+				ImGui::Text(
+					"Pipelines: %zu, %zu created, %zu reused",
+					factory.pipelines.size(),
+					factory.pipelines_created,
+					factory.pipelines_reused
+				);
+				ImGui::Text(
+					"Shaders: %zu, %zu files read, %zu created",
+					factory.shaders.size(),
+					factory.files_read,
+					factory.shaders_created
+				);
+			}
+			if (ImGui::CollapsingHeader("Benchmarks")) {
+				bench_imgui();
 			}
 
 			ImGui::End();
@@ -428,14 +589,20 @@ int main(int argc, char** argv) {
 
 		}
 
+		Shader_Build_Result shaders = shader_watcher.take();
+		if (!shaders.compiled.empty())
+			reload_pipelines(gpu, shaders, targets.settings, planet, cosmos, atmosphere);
+
 		planet.update(dt);
 
-		std::vector<SDL_GPUFence*> upload_fences;
-		planet.upload(gpu, upload_fences);
-		defer {
-			for (SDL_GPUFence* upload_fence : upload_fences)
-				SDL_ReleaseGPUFence(gpu, upload_fence);
-		};
+		render_scale.update(dt * 1000.f);
+		if (
+			targets.scaled_width != render_scale.apply((u32)targets.width) ||
+			targets.scaled_height != render_scale.apply((u32)targets.height)
+		) {
+			if (!update_scaled_targets(gpu, targets, render_scale))
+				return 1;
+		}
 
 		SDL_GetMouseState(&mouse_x, &mouse_y);
 		mouse_x /= targets.width;
@@ -470,7 +637,7 @@ int main(int argc, char** argv) {
 			if (ok && w > 0 && h > 0) {
 				targets.width = w;
 				targets.height = h;
-				if (!update_targets(gpu, targets)) {
+				if (!update_targets(gpu, targets, render_scale)) {
 					return 1;
 				}
 			} else {
@@ -563,13 +730,44 @@ int main(int argc, char** argv) {
 		common_uniform.view = lookAt(
 			camera.position + planet.position, planet.position, camera.up
 		);
+
+		// After the camera moved this frame, the chunks are culled against this very view.
+		planet.update_lod(
+			common_uniform.view,
+			common_uniform.projection,
+			camera.position - camera.target,
+			camera.fov,
+			(f32)targets.height
+		);
+		planet.update_arrows(
+			common_uniform.view,
+			common_uniform.projection,
+			camera.position - camera.target,
+			camera.fov,
+			(f32)targets.height
+		);
+
+		std::vector<SDL_GPUFence*> upload_fences;
+		planet.upload(gpu, upload_fences);
+		atmosphere.update(gpu, upload_fences);
+		cosmos.update(gpu, upload_fences);
+		defer {
+			for (SDL_GPUFence* upload_fence : upload_fences)
+				SDL_ReleaseGPUFence(gpu, upload_fence);
+		};
 		{
+			// With a single sample the scene draws in the resolve texture, there is no resolve.
+			bool multisampled = targets.color_texture != nullptr;
+			SDL_GPUStoreOp last_store = multisampled
+				? SDL_GPU_STOREOP_RESOLVE
+				: SDL_GPU_STOREOP_STORE;
+
 			SDL_GPUColorTargetInfo color_target = {};
-			color_target.texture = targets.color_texture;
+			color_target.texture = multisampled ? targets.color_texture : targets.resolve_texture;
 			color_target.clear_color = { 0.025f, 0.025f, 0.05f, 1.0f };
 			color_target.load_op = SDL_GPU_LOADOP_DONT_CARE;
-			color_target.store_op = SDL_GPU_STOREOP_STORE;
-			color_target.resolve_texture = targets.resolve_texture;
+			color_target.store_op = show_planet ? SDL_GPU_STOREOP_STORE : last_store;
+			color_target.resolve_texture = multisampled ? targets.resolve_texture : nullptr;
 
 			SDL_GPUDepthStencilTargetInfo depth_target = {};
 			depth_target.texture = targets.depth_texture;
@@ -592,18 +790,26 @@ int main(int argc, char** argv) {
 			SDL_EndGPURenderPass(pass);
 
 			if (show_planet) {
-				color_target.load_op = SDL_GPU_LOADOP_LOAD;
-				color_target.store_op = SDL_GPU_STOREOP_RESOLVE;
-				pass = SDL_BeginGPURenderPass(buffer, &color_target, 1, nullptr);
+				SDL_GPUColorTargetInfo scaled_target = {};
+				scaled_target.texture = targets.scaled_texture;
+				scaled_target.load_op = SDL_GPU_LOADOP_DONT_CARE;
+				scaled_target.store_op = SDL_GPU_STOREOP_STORE;
+				pass = SDL_BeginGPURenderPass(buffer, &scaled_target, 1, nullptr);
 				atmosphere.common_uniform = common_uniform;
-				atmosphere.uniform.width = targets.width;
-				atmosphere.uniform.height = targets.height;
+				atmosphere.uniform.width = targets.scaled_width;
+				atmosphere.uniform.height = targets.scaled_height;
 				atmosphere.uniform.eye = camera.position;
 				atmosphere.uniform.planet_world_position =
 					(Vector3f)(planet.position);
 				atmosphere.uniform.planet_radius = 1.0f;
 				atmosphere.render(pass, buffer);
 				SDL_EndGPURenderPass(pass);
+
+				color_target.load_op = SDL_GPU_LOADOP_LOAD;
+				color_target.store_op = last_store;
+				pass = SDL_BeginGPURenderPass(buffer, &color_target, 1, nullptr);
+				atmosphere.composite(pass, buffer, targets.scaled_texture);
+				SDL_EndGPURenderPass(pass);
 			}
 			
 			SDL_GPUBlitInfo blit = {};
@@ -1,109 +1,5 @@
 #include "Maths.hpp"
-
-Vector2f normalize(Vector2f v) {
-	f32 l = sqrtf(v.x * v.x + v.y * v.y);
-	return {
-		v.x / l,
-		v.y / l
-	};
-}
-f32 dot(Vector2f a, Vector2f b) {
-	return a.x * b.x + a.y * b.y;
-}
-f32 length(Vector2f v) {
-	return sqrtf(v.x * v.x + v.y * v.y);
-}
-
-Vector3f::Vector3f(const Vector4f& v) {
-	x = v.x;
-	y = v.y;
-	z = v.z;
-}
-
-Vector3f& Vector3f::operator*=(f32 s) {
-	x *= s;
-	y *= s;
-	z *= s;
-	return *this;
-}
-
-Vector3f operator*(Vector3f v, f32 s) {
-	return {
-		v.x * s,
-		v.y * s,
-		v.z * s
-	};
-}
-Vector3f operator*(f32 s, Vector3f v) {
-	return {
-		v.x * s,
-		v.y * s,
-		v.z * s
-	};
-}
-Vector3f operator/(Vector3f v, f32 s) {
-	return {
-		v.x / s,
-		v.y / s,
-		v.z / s
-	};
-}
-Vector3f operator-(Vector3f a, Vector3f b) {
-	return {
-		a.x - b.x,
-		a.y - b.y,
-		a.z - b.z
-	};
-}
-Vector3f operator+(Vector3f a, Vector3f b) {
-	return {
-		a.x + b.x,
-		a.y + b.y,
-		a.z + b.z
-	};
-}
-
-Vector3f cross(Vector3f a, Vector3f b) {
-	return {
-		a.y * b.z - a.z * b.y,
-		a.z * b.x - a.x * b.z,
-		a.x * b.y - a.y * b.x
-	};
-}
-
-f32 dot(Vector3f a, Vector3f b) {
-	return a.x * b.x + a.y * b.y + a.z * b.z;
-}
-
-f32 length(Vector3f v) {
-	return sqrtf(v.x * v.x + v.y * v.y + v.z * v.z);
-}
-
-Vector3f normalize(Vector3f v) {
-	f32 l = sqrtf(v.x * v.x + v.y * v.y + v.z * v.z);
-	return {
-		v.x / l,
-		v.y / l,
-		v.z / l
-	};
-}
-
-f32 angle(Vector3f a, Vector3f b) {
-	f32 c = dot(a, b);
-	f32 s = length(cross(a, b));
-
-	if (c < -1)
-		c = -1;
-	if (s < -1)
-		s = -1;
-	if (c > 1)
-		c = 1;
-	if (s > 1)
-		s = 1;
-
-	return atan2f(s, c);
-}
-
+#include "Packet.hpp"
 
 Quaternionf Quaternionf::axis_angle(Vector3f axis, f32 angle) {
 	f32 s = sinf(angle / 2);
@@ -219,12 +115,21 @@ Matrix4f lookAt(Vector3f eye, Vector3f target, Vector3f up) {
 	return m;
 }
 
+// Column i of C is the combination of the columns of A weighted by column i of B.
 Matrix4f operator*(const Matrix4f& A, const Matrix4f& B) {
+	f32x4 a0 = f32x4::load(A.m + 0);
+	f32x4 a1 = f32x4::load(A.m + 4);
+	f32x4 a2 = f32x4::load(A.m + 8);
+	f32x4 a3 = f32x4::load(A.m + 12);
+
 	Matrix4f C;
-	for (size_t i = 0; i < 4; i += 1)
-	for (size_t j = 0; j < 4; j += 1)
-	for (size_t k = 0; k < 4; k += 1) {
-		C.m[i * 4 + j] += A.m[k * 4 + j] * B.m[i * 4 + k];
+	for (size_t i = 0; i < 4; i += 1) {
+		const f32* b = B.m + i * 4;
+		f32x4 c = a0 * f32x4::set1(b[0]);
+		c = c + a1 * f32x4::set1(b[1]);
+		c = c + a2 * f32x4::set1(b[2]);
+		c = c + a3 * f32x4::set1(b[3]);
+		c.store(C.m + i * 4);
 	}
 	return C;
 }
@@ -297,8 +202,8 @@ Matrix4f inverse(const Matrix4f& mm) {
 
 	inv[13] = m[0]  * m[9] * m[14] -
 				m[0]  * m[10] * m[13] -
-				m[8]  * m[2] * m[13] +
 				m[8]  * m[1] * m[14] +
+				m[8]  * m[2] * m[13] +
 				m[12] * m[1] * m[10] -
 				m[12] * m[2] * m[9];
 
@@ -358,7 +263,7 @@ Matrix4f inverse(const Matrix4f& mm) {
 				m[8] * m[1] * m[6] -
 				m[8] * m[2] * m[5];
 
-	f32 det = m[0] * inv[0] + m[1] * inv[4] + m[2] * inv[8] + m[3] * m[12];
+	f32 det = m[0] * inv[0] + m[1] * inv[4] + m[2] * inv[8] + m[3] * inv[12];
 	if (det == 0)
 		return {};
 	det = 1.0f / det;
@@ -369,15 +274,6 @@ Matrix4f inverse(const Matrix4f& mm) {
 	return minv;
 }
 
-Vector3f operator*(Quaternionf q, Vector3f v) {
-	Vector3f u = {q.x, q.y, q.z};
-	f32 s = q.w;
-
-	return 2 * dot(u, v) * u
-		+ (s * s - dot(u, u)) * v
-		+ 2 * s * cross(u, v);
-}
-
 Matrix4f to_rotation_matrix(const Quaternionf& q) {
 	Vector3f x = q * Vector3f(1, 0, 0);
 	Vector3f y = q * Vector3f(0, 1, 0);
@@ -390,6 +286,101 @@ Matrix4f to_rotation_matrix(const Quaternionf& q) {
 	);
 }
 
+Matrix4f transpose(const Matrix4f& m) {
+	Matrix4f t;
+	for (size_t i = 0; i < 4; i += 1)
+	for (size_t j = 0; j < 4; j += 1)
+		t.m[i * 4 + j] = m.m[j * 4 + i];
+	return t;
+}
+
+Matrix4f affine_inverse(const Matrix4f& mm) {
+	const f32* m = mm.m;
+	Vector3f c0 = { m[0], m[1], m[2] };
+	Vector3f c1 = { m[4], m[5], m[6] };
+	Vector3f c2 = { m[8], m[9], m[10] };
+	Vector3f t = { m[12], m[13], m[14] };
+
+	// The rows of the inverse of [c0 c1 c2] are the cross products of its columns over the det.
+	Vector3f r0 = cross(c1, c2);
+	Vector3f r1 = cross(c2, c0);
+	Vector3f r2 = cross(c0, c1);
+	f32 det = dot(c0, r0);
+	if (det == 0)
+		return {};
+	det = 1.0f / det;
+	r0 *= det;
+	r1 *= det;
+	r2 *= det;
+
+	Matrix4f minv;
+	f32* inv = minv.m;
+	inv[0] = r0.x;
+	inv[1] = r1.x;
+	inv[2] = r2.x;
+	inv[4] = r0.y;
+	inv[5] = r1.y;
+	inv[6] = r2.y;
+	inv[8] = r0.z;
+	inv[9] = r1.z;
+	inv[10] = r2.z;
+	inv[12] = -dot(r0, t);
+	inv[13] = -dot(r1, t);
+	inv[14] = -dot(r2, t);
+	inv[15] = 1.0f;
+	return minv;
+}
+
+template <typename F>
+static Vector3fx<F> transform_point(const Matrix4f& mm, Vector3fx<F> p) {
+	const f32* m = mm.m;
+	auto row = [&] (size_t j) {
+		return
+			F::set1(m[j]) * p.x +
+			F::set1(m[4 + j]) * p.y +
+			F::set1(m[8 + j]) * p.z +
+			F::set1(m[12 + j]);
+	};
+	F w = row(3);
+	return { row(0) / w, row(1) / w, row(2) / w };
+}
+
+void transform_points(const Matrix4f& m, const Vector3f* in, Vector3f* out, usz n) {
+	usz i = 0;
+	for (; i + f32x8::Width <= n; i += f32x8::Width)
+		transform_point(m, Vector3fx8::load(in + i)).store(out + i);
+
+	for (; i < n; i += 1) {
+		const f32* r = m.m;
+		Vector3f p = in[i];
+		f32 w = r[3] * p.x + r[7] * p.y + r[11] * p.z + r[15];
+		out[i] = {
+			(r[0] * p.x + r[4] * p.y + r[8] * p.z + r[12]) / w,
+			(r[1] * p.x + r[5] * p.y + r[9] * p.z + r[13]) / w,
+			(r[2] * p.x + r[6] * p.y + r[10] * p.z + r[14]) / w
+		};
+	}
+}
+
+void rotate_vectors(Quaternionf q, const Vector3f* in, Vector3f* out, usz n) {
+	Vector3f u = { q.x, q.y, q.z };
+	f32 s = q.w;
+
+	Vector3fx8 ux = Vector3fx8::splat(u);
+	f32x8 two = f32x8::set1(2);
+	f32x8 vv = f32x8::set1(s * s - dot(u, u));
+	f32x8 uv = f32x8::set1(2 * s);
+
+	usz i = 0;
+	for (; i + f32x8::Width <= n; i += f32x8::Width) {
+		Vector3fx8 v = Vector3fx8::load(in + i);
+		Vector3fx8 r = ux * (two * dot(ux, v)) + v * vv + cross(ux, v) * uv;
+		r.store(out + i);
+	}
+	for (; i < n; i += 1)
+		out[i] = q * in[i];
+}
+
 Quaternionf operator*(const Quaternionf& a, const Quaternionf& b)
 {
 	return {
@@ -432,3 +423,32 @@ Quaternionf::operator Matrix4f()
 	mm.m[15] = 1;
 	return mm;
 }
+
+Frustum frustum_from_clip(const Matrix4f& clip) {
+	auto row = [&] (size_t i) -> Vector4f {
+		return { clip.m[i], clip.m[4 + i], clip.m[8 + i], clip.m[12 + i] };
+	};
+	auto plane = [] (Vector4f a, Vector4f b, f32 s) -> Vector4f {
+		Vector4f p = { a.x + s * b.x, a.y + s * b.y, a.z + s * b.z, a.w + s * b.w };
+		f32 l = length(Vector3f(p));
+		return { p.x / l, p.y / l, p.z / l, p.w / l };
+	};
+
+	Vector4f w = row(3);
+	Frustum frustum;
+	frustum.planes[0] = plane(w, row(0), +1);
+	frustum.planes[1] = plane(w, row(0), -1);
+	frustum.planes[2] = plane(w, row(1), +1);
+	frustum.planes[3] = plane(w, row(1), -1);
+	frustum.planes[4] = plane(w, row(2), +1);
+	frustum.planes[5] = plane(w, row(2), -1);
+	return frustum;
+}
+
+bool sphere_in_frustum(const Frustum& frustum, Vector3f center, f32 radius) {
+	for (const Vector4f& p : frustum.planes) {
+		if (p.x * center.x + p.y * center.y + p.z * center.z + p.w < -radius)
+			return false;
+	}
+	return true;
+}
@@ -9,20 +9,37 @@ struct Vector2f {
 	f32 x = 0;
 	f32 y = 0;
 };
-extern Vector2f normalize(Vector2f v);
-extern f32 dot(Vector2f a, Vector2f b);
-extern f32 length(Vector2f v);
+inline Vector2f normalize(Vector2f v) {
+	f32 l = sqrtf(v.x * v.x + v.y * v.y);
+	return {
+		v.x / l,
+		v.y / l
+	};
+}
+constexpr f32 dot(Vector2f a, Vector2f b) {
+	return a.x * b.x + a.y * b.y;
+}
+inline f32 length(Vector2f v) {
+	return sqrtf(v.x * v.x + v.y * v.y);
+}
 
 struct Vector3f {
 	f32 x = 0;
 	f32 y = 0;
 	f32 z = 0;
 
-	Vector3f() : x(0), y(0), z(0) {}
-	Vector3f(f32 x, f32 y, f32 z) : x(x), y(y), z(z) {}
-	Vector3f(const Vector4f& v);
+	constexpr Vector3f() : x(0), y(0), z(0) {}
+	constexpr Vector3f(f32 x, f32 y, f32 z) : x(x), y(y), z(z) {}
+	constexpr Vector3f(const Vector4f& v);
 
-	Vector3f& operator*=(f32 s);
+	constexpr Vector3f& operator*=(f32 s) {
+		x *= s;
+		y *= s;
+		z *= s;
+		return *this;
+	}
+
+	constexpr bool operator==(const Vector3f& other) const = default;
 };
 struct Vector4f {
 	f32 x = 0;
@@ -30,20 +47,96 @@ struct Vector4f {
 	f32 z = 0;
 	f32 w = 0;
 
-	Vector4f() : x(0), y(0), z(0), w(0) {}
-	Vector4f(f32 x, f32 y, f32 z, f32 w) : x(x), y(y), z(z), w(w) {}
-	Vector4f(Vector3f v, f32 w) : x(v.x), y(v.y), z(v.z), w(w) {}
+	constexpr Vector4f() : x(0), y(0), z(0), w(0) {}
+	constexpr Vector4f(f32 x, f32 y, f32 z, f32 w) : x(x), y(y), z(z), w(w) {}
+	constexpr Vector4f(Vector3f v, f32 w) : x(v.x), y(v.y), z(v.z), w(w) {}
 };
-Vector3f operator*(Vector3f v, f32 s);
-Vector3f operator*(f32 s, Vector3f v);
-Vector3f operator/(Vector3f v, f32 s);
-Vector3f operator-(Vector3f a, Vector3f b);
-Vector3f operator+(Vector3f a, Vector3f b);
-Vector3f cross(Vector3f a, Vector3f b);
-f32 dot(Vector3f a, Vector3f b);
-f32 length(Vector3f v);
-Vector3f normalize(Vector3f v);
-f32 angle(Vector3f a, Vector3f b);
+constexpr Vector3f::Vector3f(const Vector4f& v) : x(v.x), y(v.y), z(v.z) {}
+
+constexpr Vector3f operator*(Vector3f v, f32 s) {
+	return {
+		v.x * s,
+		v.y * s,
+		v.z * s
+	};
+}
+constexpr Vector3f operator*(f32 s, Vector3f v) {
+	return {
+		v.x * s,
+		v.y * s,
+		v.z * s
+	};
+}
+// Component wise, like vec3 * vec3 in the shaders.
+constexpr Vector3f operator*(Vector3f a, Vector3f b) {
+	return {
+		a.x * b.x,
+		a.y * b.y,
+		a.z * b.z
+	};
+}
+constexpr Vector3f operator/(Vector3f v, f32 s) {
+	return {
+		v.x / s,
+		v.y / s,
+		v.z / s
+	};
+}
+constexpr Vector3f operator-(Vector3f a, Vector3f b) {
+	return {
+		a.x - b.x,
+		a.y - b.y,
+		a.z - b.z
+	};
+}
+constexpr Vector3f operator+(Vector3f a, Vector3f b) {
+	return {
+		a.x + b.x,
+		a.y + b.y,
+		a.z + b.z
+	};
+}
+
+constexpr Vector3f cross(Vector3f a, Vector3f b) {
+	return {
+		a.y * b.z - a.z * b.y,
+		a.z * b.x - a.x * b.z,
+		a.x * b.y - a.y * b.x
+	};
+}
+
+constexpr f32 dot(Vector3f a, Vector3f b) {
+	return a.x * b.x + a.y * b.y + a.z * b.z;
+}
+
+inline f32 length(Vector3f v) {
+	return sqrtf(v.x * v.x + v.y * v.y + v.z * v.z);
+}
+
+inline Vector3f normalize(Vector3f v) {
+	f32 l = sqrtf(v.x * v.x + v.y * v.y + v.z * v.z);
+	return {
+		v.x / l,
+		v.y / l,
+		v.z / l
+	};
+}
+
+inline f32 angle(Vector3f a, Vector3f b) {
+	f32 c = dot(a, b);
+	f32 s = length(cross(a, b));
+
+	if (c < -1)
+		c = -1;
+	if (s < -1)
+		s = -1;
+	if (c > 1)
+		c = 1;
+	if (s > 1)
+		s = 1;
+
+	return atan2f(s, c);
+}
 
 std::optional<Vector3f> intersect_sphere_ray(Vector3f o, f32 r, Vector3f p, Vector3f d);
 struct Matrix4f {
@@ -57,9 +150,9 @@ struct Quaternionf {
 	f32 z = 0;
 	f32 w = 0;
 
-	Quaternionf() : x(0), y(0), z(0), w(0) {}
-	Quaternionf(f32 x, f32 y, f32 z, f32 w) : x(x), y(y), z(z), w(w) {}
-	Quaternionf(Vector3f vector, f32 scalar) {
+	constexpr Quaternionf() : x(0), y(0), z(0), w(0) {}
+	constexpr Quaternionf(f32 x, f32 y, f32 z, f32 w) : x(x), y(y), z(z), w(w) {}
+	constexpr Quaternionf(Vector3f vector, f32 scalar) {
 		x = vector.x;
 		y = vector.y;
 		z = vector.z;
@@ -80,5 +173,30 @@ Matrix4f lookAt(Vector3f eye, Vector3f target, Vector3f up = { 0, 0, 1 });
 Matrix4f operator*(const Matrix4f& A, const Matrix4f& B);
 Vector4f operator*(const Matrix4f& A, const Vector4f& b);
 Matrix4f inverse(const Matrix4f& mm);
-Vector3f operator*(Quaternionf q, Vector3f v);
+constexpr Vector3f operator*(Quaternionf q, Vector3f v) {
+	Vector3f u = {q.x, q.y, q.z};
+	f32 s = q.w;
+
+	return 2 * dot(u, v) * u
+		+ (s * s - dot(u, u)) * v
+		+ 2 * s * cross(u, v);
+}
 Matrix4f to_rotation_matrix(const Quaternionf& q);
+Matrix4f transpose(const Matrix4f& m);
+// Inverse of a matrix whose last row is (0, 0, 0, 1), rotation, scale and translation only.
+Matrix4f affine_inverse(const Matrix4f& m);
+
+// Batch kernels, column major like the shaders: out[i] = (m * vec4(in[i], 1)).xyz / w.
+// Note that operator*(Matrix4f, Vector4f) multiplies by the transpose of m.
+void transform_points(const Matrix4f& m, const Vector3f* in, Vector3f* out, usz n);
+// out[i] = q * in[i]
+void rotate_vectors(Quaternionf q, const Vector3f* in, Vector3f* out, usz n);
+
+// Planes (a, b, c, d) of a clip matrix, a * x + b * y + c * z + d >= 0 inside, with a unit normal.
+// Left, right, bottom, top, near then far, for the -w <= z <= w clip space of perspective.
+struct Frustum {
+	Vector4f planes[6];
+};
+Frustum frustum_from_clip(const Matrix4f& clip);
+// False only when the sphere is entirely outside one of the planes.
+bool sphere_in_frustum(const Frustum& frustum, Vector3f center, f32 radius);
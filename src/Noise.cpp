@@ -1,6 +1,9 @@
 #include "Noise.hpp"
 #include "Maths.hpp"
 
+#include <random>
+#include <utility>
+
 static size_t permutation[] = {
 	151,160,137,91,90,15,
 	131,13,201,95,96,53,194,233,7,225,140,36,103,30,69,142,8,99,37,240,21,10,23,
@@ -47,6 +50,40 @@ static size_t permutation[] = {
 	138,236,205,93,222,114,67,29,24,72,243,141,128,195,78,66,215,61,156,180
 };
 
+// Perlin's 12 edge gradients padded to 16 with the usual repeats, indexed by hash & 15. Same
+// values as the u/v sign selection of the reference implementation without the branches.
+static constexpr f32 perlin_gradients[16][3] = {
+	{ +1, +1, 0 }, { -1, +1, 0 }, { +1, -1, 0 }, { -1, -1, 0 },
+	{ +1, 0, +1 }, { -1, 0, +1 }, { +1, 0, -1 }, { -1, 0, -1 },
+	{ 0, +1, +1 }, { 0, -1, +1 }, { 0, +1, -1 }, { 0, -1, -1 },
+	{ +1, +1, 0 }, { 0, -1, +1 }, { -1, +1, 0 }, { 0, -1, -1 },
+};
+
+// The same table by axis, for the gathers of the batched kernels.
+static constexpr f32 perlin_gradients_x[16] = { 1, -1, 1, -1, 1, -1, 1, -1, 0, 0, 0, 0, 1, 0, -1, 0 };
+static constexpr f32 perlin_gradients_y[16] = { 1, 1, -1, -1, 0, 0, 0, 0, 1, -1, 1, -1, 1, -1, 1, -1 };
+static constexpr f32 perlin_gradients_z[16] = { 0, 0, 0, 0, 1, 1, -1, -1, 1, 1, -1, -1, 0, 1, 0, -1 };
+
+// Permutation hash of the 8 corners of the cell (X, Y, Z), in the order 000, 100, 010, 110, 001,
+// 101, 011, 111 (x, y, z offsets). X, Y and Z are already wrapped to [0, 255].
+static void perlin_corner_hashes(i64 X, i64 Y, i64 Z, size_t hashes[8]) {
+	i64 A  = permutation[X + 0] + Y + 0;
+	i64 AA = permutation[A + 0] + Z + 0;
+	i64 AB = permutation[A + 1] + Z + 0;
+	i64 B  = permutation[X + 1] + Y + 0;
+	i64 BA = permutation[B + 0] + Z + 0;
+	i64 BB = permutation[B + 1] + Z + 0;
+
+	hashes[0] = permutation[AA + 0];
+	hashes[1] = permutation[BA + 0];
+	hashes[2] = permutation[AB + 0];
+	hashes[3] = permutation[BB + 0];
+	hashes[4] = permutation[AA + 1];
+	hashes[5] = permutation[BA + 1];
+	hashes[6] = permutation[AB + 1];
+	hashes[7] = permutation[BB + 1];
+}
+
 f32 perlin(f32 x, f32 y, f32 z) {
 	auto ease = [] (f32 x) -> f32 {
 		return ((6 * x - 15) * x + 10) * x * x * x;
@@ -57,10 +94,8 @@ f32 perlin(f32 x, f32 y, f32 z) {
 	};
 
 	auto grad = [] (size_t hash, f32 x, f32 y, f32 z) -> f32 {
-		size_t h = hash & 15;
-		f32 u = h < 8 ? x : y;
-		f32 v = h < 4 ? y : ((h == 12 || h == 14) ? x : z);
-		return ((h & 1) == 0 ? u : -u) + ((h & 2) == 0 ? v : -v);
+		const f32* g = perlin_gradients[hash & 15];
+		return g[0] * x + g[1] * y + g[2] * z;
 	};
 
 	i64 X = (i64)floor(x) & 255;
@@ -74,21 +109,17 @@ f32 perlin(f32 x, f32 y, f32 z) {
 	f32 v = ease(yf);
 	f32 w = ease(zf);
 
-	i64 A  = permutation[X + 0] + Y + 0;
-	i64 AA = permutation[A + 0] + Z + 0;
-	i64 AB = permutation[A + 1] + Z + 0;
-	i64 B  = permutation[X + 1] + Y + 0;
-	i64 BA = permutation[B + 0] + Z + 0;
-	i64 BB = permutation[B + 1] + Z + 0;
+	size_t h[8];
+	perlin_corner_hashes(X, Y, Z, h);
 
-	f32 grad000 = grad(permutation[AA + 0], xf + 0, yf + 0, zf + 0);
-	f32 grad100 = grad(permutation[BA + 0], xf - 1, yf + 0, zf + 0);
-	f32 grad010 = grad(permutation[AB + 0], xf + 0, yf - 1, zf + 0);
-	f32 grad110 = grad(permutation[BB + 0], xf - 1, yf - 1, zf + 0);
-	f32 grad001 = grad(permutation[AA + 1], xf + 0, yf + 0, zf - 1);
-	f32 grad101 = grad(permutation[BA + 1], xf - 1, yf + 0, zf - 1);
-	f32 grad011 = grad(permutation[AB + 1], xf + 0, yf - 1, zf - 1);
-	f32 grad111 = grad(permutation[BB + 1], xf - 1, yf - 1, zf - 1);
+	f32 grad000 = grad(h[0], xf + 0, yf + 0, zf + 0);
+	f32 grad100 = grad(h[1], xf - 1, yf + 0, zf + 0);
+	f32 grad010 = grad(h[2], xf + 0, yf - 1, zf + 0);
+	f32 grad110 = grad(h[3], xf - 1, yf - 1, zf + 0);
+	f32 grad001 = grad(h[4], xf + 0, yf + 0, zf - 1);
+	f32 grad101 = grad(h[5], xf - 1, yf + 0, zf - 1);
+	f32 grad011 = grad(h[6], xf + 0, yf - 1, zf - 1);
+	f32 grad111 = grad(h[7], xf - 1, yf - 1, zf - 1);
 
 	f32 u0 = lerp(u, grad000, grad100);
 	f32 u1 = lerp(u, grad010, grad110);
@@ -139,6 +170,499 @@ f32 perlin(f32 x, f32 y, f32 z) {
 	// return lerp(w, nxy0, nxy1);
 }
 
+static f32 noise_ease(f32 t) {
+	return ((6 * t - 15) * t + 10) * t * t * t;
+}
+static f32x8 noise_ease(f32x8 t) {
+	return ((6.f * t - 15.f) * t + 10.f) * t * t * t;
+}
+
+template <typename F>
+static F noise_lerp(F t, F a, F b) {
+	return a + t * (b - a);
+}
+
+// Trilinear blend of the 8 corners in perlin_corner_hashes order.
+template <typename F>
+static F noise_trilinear(const F c[8], F u, F v, F w) {
+	F u0 = noise_lerp(u, c[0], c[1]);
+	F u1 = noise_lerp(u, c[2], c[3]);
+	F u2 = noise_lerp(u, c[4], c[5]);
+	F u3 = noise_lerp(u, c[6], c[7]);
+
+	F v0 = noise_lerp(v, u0, u1);
+	F v1 = noise_lerp(v, u2, u3);
+
+	return noise_lerp(w, v0, v1);
+}
+
+// The batched kernels work on 8 samples: the lattice hashing runs per lane on the cell corners
+// written out by this, everything else runs on f32x8.
+struct Noise_Cells_x8 {
+	alignas(32) f32 x[8];
+	alignas(32) f32 y[8];
+	alignas(32) f32 z[8];
+};
+
+// Dot of the gradients picked by indices (one per lane) with (dx, dy, dz).
+static f32x8 gradient_dot_x8(
+	const f32* gx, const f32* gy, const f32* gz, const i32* indices, f32x8 dx, f32x8 dy, f32x8 dz
+) {
+	return gather(gx, indices) * dx + gather(gy, indices) * dy + gather(gz, indices) * dz;
+}
+
+static f32x8 perlin_x8(f32x8 x, f32x8 y, f32x8 z) {
+	f32x8 x0 = floor(x);
+	f32x8 y0 = floor(y);
+	f32x8 z0 = floor(z);
+	Noise_Cells_x8 cells;
+	x0.store(cells.x);
+	y0.store(cells.y);
+	z0.store(cells.z);
+
+	// gradient[corner][lane]
+	alignas(32) i32 gradient[8][8];
+	for (size_t l = 0; l < 8; l += 1) {
+		size_t h[8];
+		perlin_corner_hashes(
+			(i64)cells.x[l] & 255, (i64)cells.y[l] & 255, (i64)cells.z[l] & 255, h
+		);
+		for (size_t c = 0; c < 8; c += 1)
+			gradient[c][l] = (i32)(h[c] & 15);
+	}
+
+	f32x8 xf = x - x0;
+	f32x8 yf = y - y0;
+	f32x8 zf = z - z0;
+
+	f32x8 corners[8];
+	for (size_t c = 0; c < 8; c += 1) {
+		corners[c] = gradient_dot_x8(
+			perlin_gradients_x,
+			perlin_gradients_y,
+			perlin_gradients_z,
+			gradient[c],
+			(c & 1) ? xf - 1.f : xf,
+			(c & 2) ? yf - 1.f : yf,
+			(c & 4) ? zf - 1.f : zf
+		);
+	}
+
+	return noise_trilinear(corners, noise_ease(xf), noise_ease(yf), noise_ease(zf));
+}
+
+// Value noise, a random value in [-1, 1] per lattice point from the Perlin permutation, blended
+// with the same quintic ease.
+static f32 value_noise(f32 x, f32 y, f32 z) {
+	f32 x0 = floorf(x);
+	f32 y0 = floorf(y);
+	f32 z0 = floorf(z);
+
+	size_t h[8];
+	perlin_corner_hashes((i64)x0 & 255, (i64)y0 & 255, (i64)z0 & 255, h);
+
+	f32 corners[8];
+	for (size_t c = 0; c < 8; c += 1)
+		corners[c] = h[c] * (2 / 255.f) - 1.f;
+
+	return noise_trilinear(corners, noise_ease(x - x0), noise_ease(y - y0), noise_ease(z - z0));
+}
+
+static f32x8 value_noise_x8(f32x8 x, f32x8 y, f32x8 z) {
+	f32x8 x0 = floor(x);
+	f32x8 y0 = floor(y);
+	f32x8 z0 = floor(z);
+	Noise_Cells_x8 cells;
+	x0.store(cells.x);
+	y0.store(cells.y);
+	z0.store(cells.z);
+
+	alignas(32) f32 values[8][8];
+	for (size_t l = 0; l < 8; l += 1) {
+		size_t h[8];
+		perlin_corner_hashes(
+			(i64)cells.x[l] & 255, (i64)cells.y[l] & 255, (i64)cells.z[l] & 255, h
+		);
+		for (size_t c = 0; c < 8; c += 1)
+			values[c][l] = h[c] * (2 / 255.f) - 1.f;
+	}
+
+	f32x8 corners[8];
+	for (size_t c = 0; c < 8; c += 1)
+		corners[c] = f32x8::load(values[c]);
+
+	return noise_trilinear(
+		corners, noise_ease(x - x0), noise_ease(y - y0), noise_ease(z - z0)
+	);
+}
+
+// Gradient lattice, random unit gradients (scaled to Perlin's sqrt(2) length) precomputed for a
+// multiplicative hash of the lattice point. One small table lookup per corner instead of the
+// chained permutation lookups, the table stays in L1.
+static constexpr size_t Lattice_Gradients = 256;
+
+struct Lattice_Gradient_Table {
+	f32 x[Lattice_Gradients];
+	f32 y[Lattice_Gradients];
+	f32 z[Lattice_Gradients];
+
+	Lattice_Gradient_Table() {
+		std::mt19937 rng(0x5eed);
+		std::normal_distribution<f32> dist;
+		for (size_t i = 0; i < Lattice_Gradients; i += 1) {
+			Vector3f v;
+			do {
+				v = { dist(rng), dist(rng), dist(rng) };
+			} while (length(v) < 1e-3f);
+			v = normalize(v) * sqrtf(2);
+			x[i] = v.x;
+			y[i] = v.y;
+			z[i] = v.z;
+		}
+	}
+};
+static const Lattice_Gradient_Table lattice_gradients;
+
+static i32 lattice_hash(i64 X, i64 Y, i64 Z) {
+	u32 h = (u32)X * 73856093u ^ (u32)Y * 19349663u ^ (u32)Z * 83492791u;
+	return (i32)((h >> 8) & (Lattice_Gradients - 1));
+}
+
+static f32 gradient_lattice_noise(f32 x, f32 y, f32 z) {
+	f32 x0 = floorf(x);
+	f32 y0 = floorf(y);
+	f32 z0 = floorf(z);
+	f32 xf = x - x0;
+	f32 yf = y - y0;
+	f32 zf = z - z0;
+
+	f32 corners[8];
+	for (size_t c = 0; c < 8; c += 1) {
+		i64 dx = c & 1;
+		i64 dy = (c >> 1) & 1;
+		i64 dz = (c >> 2) & 1;
+		i32 h = lattice_hash((i64)x0 + dx, (i64)y0 + dy, (i64)z0 + dz);
+		corners[c] =
+			lattice_gradients.x[h] * (xf - dx) +
+			lattice_gradients.y[h] * (yf - dy) +
+			lattice_gradients.z[h] * (zf - dz);
+	}
+
+	return noise_trilinear(corners, noise_ease(xf), noise_ease(yf), noise_ease(zf));
+}
+
+static f32x8 gradient_lattice_noise_x8(f32x8 x, f32x8 y, f32x8 z) {
+	f32x8 x0 = floor(x);
+	f32x8 y0 = floor(y);
+	f32x8 z0 = floor(z);
+	Noise_Cells_x8 cells;
+	x0.store(cells.x);
+	y0.store(cells.y);
+	z0.store(cells.z);
+
+	alignas(32) i32 gradient[8][8];
+	for (size_t l = 0; l < 8; l += 1) {
+		i64 X = (i64)cells.x[l];
+		i64 Y = (i64)cells.y[l];
+		i64 Z = (i64)cells.z[l];
+		for (size_t c = 0; c < 8; c += 1)
+			gradient[c][l] = lattice_hash(X + (c & 1), Y + ((c >> 1) & 1), Z + (c >> 2));
+	}
+
+	f32x8 xf = x - x0;
+	f32x8 yf = y - y0;
+	f32x8 zf = z - z0;
+
+	f32x8 corners[8];
+	for (size_t c = 0; c < 8; c += 1) {
+		corners[c] = gradient_dot_x8(
+			lattice_gradients.x,
+			lattice_gradients.y,
+			lattice_gradients.z,
+			gradient[c],
+			(c & 1) ? xf - 1.f : xf,
+			(c & 2) ? yf - 1.f : yf,
+			(c & 4) ? zf - 1.f : zf
+		);
+	}
+
+	return noise_trilinear(corners, noise_ease(xf), noise_ease(yf), noise_ease(zf));
+}
+
+// OpenSimplex2 3D (K.jpg, public domain), the fallback orientation: the input is rotated onto
+// two offset cubic lattices (a BCC lattice) and each copy contributes its closest point and, when
+// in range, its second closest, so at most 4 points per sample. Gradients are Perlin's edges.
+static constexpr u64 OS2_Prime_X = 0x5205402B9270C86Full;
+static constexpr u64 OS2_Prime_Y = 0x598CD327003817B5ull;
+static constexpr u64 OS2_Prime_Z = 0x5BCC226E9FA0BACBull;
+static constexpr u64 OS2_Hash_Multiplier = 0x53A3F72DEEC546F5ull;
+static constexpr u64 OS2_Seed_Flip = 0xAD2AB84D169129D7ull;
+static constexpr f32 OS2_Radius_Squared = 0.6f;
+// Gives the same standard deviation as perlin, the extremes stay around +-0.6.
+static constexpr f32 OS2_Normalizer = 1.f / 0.0492f;
+
+static i32 os2_gradient_index(u64 seed, u64 xp, u64 yp, u64 zp) {
+	u64 hash = (seed ^ xp) ^ (yp ^ zp);
+	hash *= OS2_Hash_Multiplier;
+	hash ^= hash >> 58;
+	return (i32)(hash & 15);
+}
+
+static const f32* os2_gradient(u64 seed, u64 xp, u64 yp, u64 zp) {
+	return perlin_gradients[os2_gradient_index(seed, xp, yp, zp)];
+}
+
+static void os2_rotate(f32 x, f32 y, f32 z, f32& xr, f32& yr, f32& zr) {
+	f32 r = (2.f / 3.f) * (x + y + z);
+	xr = r - x;
+	yr = r - y;
+	zr = r - z;
+}
+
+// Which axis the second closest point of a lattice copy is offset along: 0, 1 or 2.
+static size_t os2_second_axis(f32 ax, f32 ay, f32 az) {
+	if (ax >= ay && ax >= az)
+		return 0;
+	if (ay > ax && ay >= az)
+		return 1;
+	return 2;
+}
+
+static f32 opensimplex2_noise(f32 x, f32 y, f32 z) {
+	f32 xr, yr, zr;
+	os2_rotate(x, y, z, xr, yr, zr);
+
+	f32 xrb = floorf(xr + 0.5f);
+	f32 yrb = floorf(yr + 0.5f);
+	f32 zrb = floorf(zr + 0.5f);
+	f32 ri[3] = { xr - xrb, yr - yrb, zr - zrb };
+	f32 sign[3];
+	f32 a0[3];
+	for (size_t k = 0; k < 3; k += 1) {
+		sign[k] = ri[k] < 0 ? 1.f : -1.f;
+		a0[k] = fabsf(ri[k]);
+	}
+	u64 p[3] = {
+		(u64)(i64)xrb * OS2_Prime_X, (u64)(i64)yrb * OS2_Prime_Y, (u64)(i64)zrb * OS2_Prime_Z
+	};
+	const u64 primes[3] = { OS2_Prime_X, OS2_Prime_Y, OS2_Prime_Z };
+	u64 seed = 0;
+
+	f32 value = 0;
+	f32 a = (OS2_Radius_Squared - ri[0] * ri[0]) - (ri[1] * ri[1] + ri[2] * ri[2]);
+	for (size_t l = 0; l < 2; l += 1) {
+		if (a > 0) {
+			const f32* g = os2_gradient(seed, p[0], p[1], p[2]);
+			value += (a * a) * (a * a) * (g[0] * ri[0] + g[1] * ri[1] + g[2] * ri[2]);
+		}
+
+		size_t k = os2_second_axis(a0[0], a0[1], a0[2]);
+		f32 b = a + a0[k] + a0[k];
+		if (b > 1) {
+			b -= 1;
+			u64 q[3] = { p[0], p[1], p[2] };
+			f32 d[3] = { ri[0], ri[1], ri[2] };
+			q[k] -= (u64)(i64)sign[k] * primes[k];
+			d[k] += sign[k];
+			const f32* g = os2_gradient(seed, q[0], q[1], q[2]);
+			value += (b * b) * (b * b) * (g[0] * d[0] + g[1] * d[1] + g[2] * d[2]);
+		}
+
+		if (l == 1)
+			break;
+
+		// Move to the other lattice copy, offset by half a cell.
+		for (size_t k = 0; k < 3; k += 1) {
+			a0[k] = 0.5f - a0[k];
+			ri[k] = sign[k] * a0[k];
+			if (sign[k] < 0)
+				p[k] += primes[k];
+			sign[k] = -sign[k];
+		}
+		a += (0.75f - a0[0]) - (a0[1] + a0[2]);
+		seed ^= OS2_Seed_Flip;
+	}
+
+	return value * OS2_Normalizer;
+}
+
+static f32x8 opensimplex2_noise_x8(f32x8 x, f32x8 y, f32x8 z) {
+	f32x8 r = (2.f / 3.f) * (x + y + z);
+	f32x8 xr = r - x;
+	f32x8 yr = r - y;
+	f32x8 zr = r - z;
+
+	f32x8 p[3] = { floor(xr + 0.5f), floor(yr + 0.5f), floor(zr + 0.5f) };
+	f32x8 ri[3] = { xr - p[0], yr - p[1], zr - p[2] };
+	f32x8 sign[3];
+	f32x8 a0[3];
+	for (size_t k = 0; k < 3; k += 1) {
+		sign[k] = select(ri[k] < 0.f, f32x8(1.f), f32x8(-1.f));
+		a0[k] = absolute(ri[k]);
+	}
+
+	// Lattice points of both copies as floats: the closest point and the second closest one,
+	// offset by -sign along the axis with the largest |ri|. Only the hashing runs per lane.
+	Noise_Cells_x8 points[4];
+	f32x8 offsets[2][3];
+	for (size_t l = 0; l < 2; l += 1) {
+		f32x8 mx = (a0[0] >= a0[1]) & (a0[0] >= a0[2]);
+		f32x8 my = select(mx, f32x8(0.f), a0[1] >= a0[2]);
+		offsets[l][0] = select(mx, sign[0], f32x8(0.f));
+		offsets[l][1] = select(my, sign[1], f32x8(0.f));
+		offsets[l][2] = select(mx | my, f32x8(0.f), sign[2]);
+
+		p[0].store(points[l * 2].x);
+		p[1].store(points[l * 2].y);
+		p[2].store(points[l * 2].z);
+		(p[0] - offsets[l][0]).store(points[l * 2 + 1].x);
+		(p[1] - offsets[l][1]).store(points[l * 2 + 1].y);
+		(p[2] - offsets[l][2]).store(points[l * 2 + 1].z);
+
+		for (size_t k = 0; k < 3; k += 1) {
+			a0[k] = 0.5f - a0[k];
+			p[k] = p[k] + select(sign[k] < 0.f, f32x8(1.f), f32x8(0.f));
+			sign[k] = -sign[k];
+		}
+	}
+
+	alignas(32) i32 gradient[4][8];
+	for (size_t i = 0; i < 4; i += 1) {
+		u64 seed = i < 2 ? 0 : OS2_Seed_Flip;
+		for (size_t lane = 0; lane < 8; lane += 1) {
+			gradient[i][lane] = os2_gradient_index(
+				seed,
+				(u64)(i64)points[i].x[lane] * OS2_Prime_X,
+				(u64)(i64)points[i].y[lane] * OS2_Prime_Y,
+				(u64)(i64)points[i].z[lane] * OS2_Prime_Z
+			);
+		}
+	}
+
+	auto falloff = [] (f32x8 t) {
+		t = max(t, f32x8(0.f));
+		return (t * t) * (t * t);
+	};
+	auto contribution = [&] (const i32* indices, f32x8 dx, f32x8 dy, f32x8 dz) {
+		return gradient_dot_x8(
+			perlin_gradients_x, perlin_gradients_y, perlin_gradients_z, indices, dx, dy, dz
+		);
+	};
+
+	f32x8 value = 0.f;
+	f32x8 a = (OS2_Radius_Squared - ri[0] * ri[0]) - (ri[1] * ri[1] + ri[2] * ri[2]);
+	for (size_t k = 0; k < 3; k += 1)
+		a0[k] = absolute(ri[k]);
+	for (size_t l = 0; l < 2; l += 1) {
+		const f32x8* o = offsets[l];
+		value = value + falloff(a) * contribution(gradient[l * 2], ri[0], ri[1], ri[2]);
+
+		// The offset is +-1 on the chosen axis, so o * o picks that axis' distance.
+		f32x8 along = a0[0] * (o[0] * o[0]) + a0[1] * (o[1] * o[1]) + a0[2] * (o[2] * o[2]);
+		f32x8 b = a + along + along - 1.f;
+		value = value + falloff(b) * contribution(
+			gradient[l * 2 + 1], ri[0] + o[0], ri[1] + o[1], ri[2] + o[2]
+		);
+
+		if (l == 1)
+			break;
+
+		for (size_t k = 0; k < 3; k += 1) {
+			f32x8 s = select(ri[k] < 0.f, f32x8(1.f), f32x8(-1.f));
+			a0[k] = 0.5f - a0[k];
+			// The sign flips with the copy, the relative coordinate keeps the old one.
+			ri[k] = s * a0[k];
+		}
+		a = a + ((0.75f - a0[0]) - (a0[1] + a0[2]));
+	}
+
+	return value * OS2_Normalizer;
+}
+
+static const Noise_Basis_Kernel noise_basis_kernels[(u8)Noise_Basis::COUNT] = {
+	{ "Perlin", perlin, perlin_x8 },
+	{ "OpenSimplex2", opensimplex2_noise, opensimplex2_noise_x8 },
+	{ "Value", value_noise, value_noise_x8 },
+	{ "Gradient lattice", gradient_lattice_noise, gradient_lattice_noise_x8 },
+};
+
+const Noise_Basis_Kernel& get_noise_basis(Noise_Basis basis) {
+	return noise_basis_kernels[(u8)basis];
+}
+
+// 8 samples of fractal_perlin<N> for any basis, unrolled the same way.
+template <size_t N>
+static f32x8 fractal_noise_x8(
+	const Noise_Basis_Kernel& kernel, f32x8 x, f32x8 y, f32x8 z, const Fractal_Weights& weights
+) {
+	f32x8 sum = 0.f;
+	[&] <size_t... I> (std::index_sequence<I...>) {
+		((sum = sum + kernel.sample_x8(
+			x * weights.scale[I], y * weights.scale[I], z * weights.scale[I]
+		) * weights.amp[I]), ...);
+	}(std::make_index_sequence<N>{});
+	return sum;
+}
+
+using Fractal_Noise_x8_Fn = f32x8 (*)(
+	const Noise_Basis_Kernel& kernel, f32x8 x, f32x8 y, f32x8 z, const Fractal_Weights& weights
+);
+
+void fractal_noise(
+	Noise_Basis basis,
+	const f32* x,
+	const f32* y,
+	const f32* z,
+	f32* out,
+	usz n,
+	size_t octaves,
+	f32 roughness,
+	f32 lacunarity
+) {
+	static constexpr Fractal_Noise_x8_Fn table[Max_Fractal_Octaves + 1] = {
+		fractal_noise_x8<0>,
+		fractal_noise_x8<1>,
+		fractal_noise_x8<2>,
+		fractal_noise_x8<3>,
+		fractal_noise_x8<4>,
+		fractal_noise_x8<5>,
+		fractal_noise_x8<6>,
+		fractal_noise_x8<7>,
+		fractal_noise_x8<8>,
+	};
+
+	const Noise_Basis_Kernel& kernel = get_noise_basis(basis);
+	Fractal_Weights weights = make_fractal_weights(roughness, lacunarity);
+
+	// Same running scale and amplitude as fractal_perlin, for octave counts past the table.
+	auto octave_sum = [&] (auto px, auto py, auto pz, auto sample) {
+		f32 scale = 1.f;
+		f32 amp = 1.f;
+		decltype(px) sum = 0.f;
+		for (size_t o = 0; o < octaves; o += 1) {
+			sum = sum + sample(px * scale, py * scale, pz * scale) * amp;
+			amp *= roughness;
+			scale *= lacunarity;
+		}
+		return sum;
+	};
+
+	usz i = 0;
+	for (; i + f32x8::Width <= n; i += f32x8::Width) {
+		f32x8 px = f32x8::load(x + i);
+		f32x8 py = f32x8::load(y + i);
+		f32x8 pz = f32x8::load(z + i);
+
+		f32x8 sum = octaves <= Max_Fractal_Octaves
+			? table[octaves](kernel, px, py, pz, weights)
+			: octave_sum(px, py, pz, kernel.sample_x8);
+		sum.store(out + i);
+	}
+
+	for (; i < n; i += 1)
+		out[i] = octave_sum(x[i], y[i], z[i], kernel.sample);
+}
+
 f32 fractal_perlin(f32 x, f32 y, f32 z, size_t octaves, f32 roughness, f32 lacunarity) {
 	f32 scale = 1.f;
 	f32 amp = 1.0f;
@@ -155,3 +679,47 @@ f32 fractal_perlin(f32 x, f32 y, f32 z, size_t octaves, f32 roughness, f32 lacun
 
 	return sum;
 }
+
+template <size_t N>
+f32 fractal_perlin(f32 x, f32 y, f32 z, const Fractal_Weights& weights) {
+	static_assert(N <= Max_Fractal_Octaves);
+
+	auto octave = [&] (size_t i) -> f32 {
+		f32 scale = weights.scale[i];
+		return perlin(x * scale, y * scale, z * scale) * weights.amp[i];
+	};
+
+	// Same summation order as the runtime loop so both give the same bits.
+	f32 sum = 0.0f;
+	[&] <size_t... I> (std::index_sequence<I...>) {
+		((sum += octave(I)), ...);
+	}(std::make_index_sequence<N>{});
+	return sum;
+}
+
+template f32 fractal_perlin<0>(f32, f32, f32, const Fractal_Weights&);
+template f32 fractal_perlin<1>(f32, f32, f32, const Fractal_Weights&);
+template f32 fractal_perlin<2>(f32, f32, f32, const Fractal_Weights&);
+template f32 fractal_perlin<3>(f32, f32, f32, const Fractal_Weights&);
+template f32 fractal_perlin<4>(f32, f32, f32, const Fractal_Weights&);
+template f32 fractal_perlin<5>(f32, f32, f32, const Fractal_Weights&);
+template f32 fractal_perlin<6>(f32, f32, f32, const Fractal_Weights&);
+template f32 fractal_perlin<7>(f32, f32, f32, const Fractal_Weights&);
+template f32 fractal_perlin<8>(f32, f32, f32, const Fractal_Weights&);
+
+Fractal_Perlin_Fn get_fractal_perlin(size_t octaves) {
+	static constexpr Fractal_Perlin_Fn table[Max_Fractal_Octaves + 1] = {
+		fractal_perlin<0>,
+		fractal_perlin<1>,
+		fractal_perlin<2>,
+		fractal_perlin<3>,
+		fractal_perlin<4>,
+		fractal_perlin<5>,
+		fractal_perlin<6>,
+		fractal_perlin<7>,
+		fractal_perlin<8>,
+	};
+	if (octaves > Max_Fractal_Octaves)
+		return nullptr;
+	return table[octaves];
+}
@@ -1,5 +1,66 @@
 #pragma once
 #include "Common.hpp"
+#include "Packet.hpp"
 
 extern f32 perlin(f32 x, f32 y, f32 z);
-extern f32 fractal_perlin(f32 x, f32 y, f32 z, size_t octaves, f32 roughness, f32 lacunarity);
\ No newline at end of file
+extern f32 fractal_perlin(f32 x, f32 y, f32 z, size_t octaves, f32 roughness, f32 lacunarity);
+
+// Octave counts up to this one have a specialized, fully unrolled fractal_perlin<N>.
+constexpr size_t Max_Fractal_Octaves = 8;
+
+// Per octave frequency and amplitude, octave i samples at lacunarity^i with weight roughness^i.
+struct Fractal_Weights {
+	f32 scale[Max_Fractal_Octaves];
+	f32 amp[Max_Fractal_Octaves];
+};
+
+constexpr Fractal_Weights make_fractal_weights(f32 roughness, f32 lacunarity) {
+	Fractal_Weights weights = {};
+	f32 scale = 1.f;
+	f32 amp = 1.f;
+	for (size_t i = 0; i < Max_Fractal_Octaves; i += 1) {
+		weights.scale[i] = scale;
+		weights.amp[i] = amp;
+		amp *= roughness;
+		scale *= lacunarity;
+	}
+	return weights;
+}
+
+template <size_t N>
+f32 fractal_perlin(f32 x, f32 y, f32 z, const Fractal_Weights& weights);
+
+using Fractal_Perlin_Fn = f32 (*)(f32 x, f32 y, f32 z, const Fractal_Weights& weights);
+// The fractal_perlin<N> matching a runtime octave count, nullptr past Max_Fractal_Octaves.
+extern Fractal_Perlin_Fn get_fractal_perlin(size_t octaves);
+
+enum class Noise_Basis : u8 {
+	Perlin = 0,
+	OpenSimplex2,
+	Value,
+	Gradient_Lattice,
+	COUNT
+};
+
+// A noise basis, sample is the reference and sample_x8 evaluates 8 points at once. Every basis
+// returns roughly [-1, 1].
+struct Noise_Basis_Kernel {
+	const char* name;
+	f32 (*sample)(f32 x, f32 y, f32 z);
+	f32x8 (*sample_x8)(f32x8 x, f32x8 y, f32x8 z);
+};
+
+extern const Noise_Basis_Kernel& get_noise_basis(Noise_Basis basis);
+
+// Batched fractal_perlin for any basis, out[i] is the octave sum at (x[i], y[i], z[i]).
+extern void fractal_noise(
+	Noise_Basis basis,
+	const f32* x,
+	const f32* y,
+	const f32* z,
+	f32* out,
+	usz n,
+	size_t octaves,
+	f32 roughness,
+	f32 lacunarity
+);
@@ -0,0 +1,75 @@
+#include "PackedVertex.hpp"
+
+#include <algorithm>
+#include <math.h>
+
+// floorf compiles to a single instruction, lroundf to a libm call.
+static i32 quantize_snorm(f32 x, f32 max) {
+	return (i32)floorf(std::clamp(x, -1.f, 1.f) * max + 0.5f);
+}
+
+static f32 dequantize_snorm(i32 x, f32 max) {
+	return std::max((f32)x / max, -1.f);
+}
+
+// Maps the sphere onto the [-1, 1] square, the lower hemisphere folded over the diagonals.
+u16 encode_octahedral(Vector3f n) {
+	f32 l1 = fabsf(n.x) + fabsf(n.y) + fabsf(n.z);
+	if (l1 == 0)
+		return 0;
+
+	f32 x = n.x / l1;
+	f32 y = n.y / l1;
+	if (n.z < 0) {
+		f32 folded_x = (1 - fabsf(y)) * (x < 0 ? -1.f : 1.f);
+		f32 folded_y = (1 - fabsf(x)) * (y < 0 ? -1.f : 1.f);
+		x = folded_x;
+		y = folded_y;
+	}
+
+	u32 ex = (u8)(i8)quantize_snorm(x, 127.f);
+	u32 ey = (u8)(i8)quantize_snorm(y, 127.f);
+	return (u16)(ex | ey << 8);
+}
+
+Vector3f decode_octahedral(u16 e) {
+	f32 x = dequantize_snorm((i8)(e & 0xFF), 127.f);
+	f32 y = dequantize_snorm((i8)(e >> 8), 127.f);
+	f32 z = 1 - fabsf(x) - fabsf(y);
+
+	// Same as planet.vert, unfolds the lower hemisphere.
+	f32 t = std::max(-z, 0.f);
+	x += x >= 0 ? -t : t;
+	y += y >= 0 ? -t : t;
+	return normalize(Vector3f(x, y, z));
+}
+
+Packed_Vertex pack_vertex(const Vertex_Attributes& v, const Vertex_Quantization& q, u16 slot) {
+	Vector3f p = (v.position - q.center) * (1.f / q.scale);
+	u32 scalar = (u32)(std::clamp(v.scalar, 0.f, 1.f) * 65535.f + 0.5f);
+
+	Packed_Vertex out;
+	out.position[0] = (i16)quantize_snorm(p.x, 32767.f);
+	out.position[1] = (i16)quantize_snorm(p.y, 32767.f);
+	out.position[2] = (i16)quantize_snorm(p.z, 32767.f);
+	out.slot = (i16)slot;
+	out.normal_scalar = encode_octahedral(v.normal) | scalar << 16;
+	out.palette_barycenter = (v.palette_index & 0xFF) | (v.barycenter & 0xFFFFFF) << 8;
+	return out;
+}
+
+Vertex_Attributes unpack_vertex(const Packed_Vertex& v, const Vertex_Quantization& q) {
+	Vector3f p = {
+		dequantize_snorm(v.position[0], 32767.f),
+		dequantize_snorm(v.position[1], 32767.f),
+		dequantize_snorm(v.position[2], 32767.f),
+	};
+
+	Vertex_Attributes out;
+	out.position = q.center + p * q.scale;
+	out.normal = decode_octahedral((u16)(v.normal_scalar & 0xFFFF));
+	out.scalar = (f32)(v.normal_scalar >> 16) / 65535.f;
+	out.palette_index = v.palette_barycenter & 0xFF;
+	out.barycenter = v.palette_barycenter >> 8;
+	return out;
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include "Common.hpp"
+#include "Maths.hpp"
+
+// The planet vertex as the gpu reads it, 16 bytes against the 36 of Planet::Mesh::Vertex.
+// position is snorm16 inside the sphere of quantization slot `slot`, the vertex shader holds the
+// slots in its QuantizationBlock and slot 0 is the unit sphere the tile mesh lives on.
+struct Packed_Vertex {
+	i16 position[3];
+	i16 slot;
+	// Octahedral normal as 2 snorm bytes, then the overlay scalar as unorm16.
+	u32 normal_scalar;
+	// Palette index in the low byte, the barycenter as 3 unorm bytes above it.
+	u32 palette_barycenter;
+};
+static_assert(sizeof(Packed_Vertex) == 16);
+
+// Must match the size of u_quantization in planet.vert.
+constexpr usz Max_Quantization_Slots = 1024;
+
+// A position decodes to center + snorm * scale.
+struct Vertex_Quantization {
+	Vector3f center;
+	f32 scale = 1.f;
+};
+
+struct Vertex_Attributes {
+	Vector3f position;
+	Vector3f normal; // any length
+	f32 scalar; // clamped to [0, 1], the overlay saturates it anyway
+	u32 palette_index;
+	u32 barycenter; // 3 unorm bytes, like Chunk_Vertex
+};
+
+// Barycenter of corner k of a triangle in the format of Vertex_Attributes.
+constexpr u32 corner_barycenter(u32 k) { return 0xFFu << (8 * k); }
+
+extern u16 encode_octahedral(Vector3f n);
+extern Vector3f decode_octahedral(u16 e);
+
+extern Packed_Vertex pack_vertex(
+	const Vertex_Attributes& v, const Vertex_Quantization& q, u16 slot
+);
+// The normal comes back unit length.
+extern Vertex_Attributes unpack_vertex(const Packed_Vertex& v, const Vertex_Quantization& q);
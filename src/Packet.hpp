@@ -0,0 +1,289 @@
+#pragma once
+
+#include "Common.hpp"
+#include "Maths.hpp"
+
+#include <immintrin.h>
+#include <string.h>
+
+// Float lanes with the usual arithmetic, f32x4 is SSE and f32x8 is AVX when the build targets it.
+// A single f32 converts to every lane so constants can be written as plain floats. Comparisons
+// return a mask of all ones or all zeros per lane for select().
+struct f32x4 {
+	static constexpr usz Width = 4;
+	__m128 v;
+
+	f32x4() = default;
+	f32x4(__m128 v) : v(v) {}
+	f32x4(f32 x) : v(_mm_set1_ps(x)) {}
+
+	static f32x4 set1(f32 x) { return { _mm_set1_ps(x) }; }
+	static f32x4 load(const f32* p) { return { _mm_loadu_ps(p) }; }
+	void store(f32* p) const { _mm_storeu_ps(p, v); }
+};
+inline f32x4 operator+(f32x4 a, f32x4 b) { return { _mm_add_ps(a.v, b.v) }; }
+inline f32x4 operator-(f32x4 a, f32x4 b) { return { _mm_sub_ps(a.v, b.v) }; }
+inline f32x4 operator*(f32x4 a, f32x4 b) { return { _mm_mul_ps(a.v, b.v) }; }
+inline f32x4 operator/(f32x4 a, f32x4 b) { return { _mm_div_ps(a.v, b.v) }; }
+inline f32x4 operator-(f32x4 a) { return { _mm_xor_ps(a.v, _mm_set1_ps(-0.f)) }; }
+inline f32x4 operator<(f32x4 a, f32x4 b) { return { _mm_cmplt_ps(a.v, b.v) }; }
+inline f32x4 operator>(f32x4 a, f32x4 b) { return { _mm_cmpgt_ps(a.v, b.v) }; }
+inline f32x4 operator<=(f32x4 a, f32x4 b) { return { _mm_cmple_ps(a.v, b.v) }; }
+inline f32x4 operator>=(f32x4 a, f32x4 b) { return { _mm_cmpge_ps(a.v, b.v) }; }
+inline f32x4 operator&(f32x4 a, f32x4 b) { return { _mm_and_ps(a.v, b.v) }; }
+inline f32x4 operator|(f32x4 a, f32x4 b) { return { _mm_or_ps(a.v, b.v) }; }
+inline f32x4 min(f32x4 a, f32x4 b) { return { _mm_min_ps(a.v, b.v) }; }
+inline f32x4 max(f32x4 a, f32x4 b) { return { _mm_max_ps(a.v, b.v) }; }
+inline f32x4 sqrt(f32x4 a) { return { _mm_sqrt_ps(a.v) }; }
+inline f32x4 absolute(f32x4 a) { return { _mm_andnot_ps(_mm_set1_ps(-0.f), a.v) }; }
+inline f32x4 select(f32x4 mask, f32x4 a, f32x4 b) {
+	return { _mm_or_ps(_mm_and_ps(mask.v, a.v), _mm_andnot_ps(mask.v, b.v)) };
+}
+// Nearest integer, ties to even, |a| < 2^22.
+inline f32x4 round_nearest(f32x4 a) { return { _mm_cvtepi32_ps(_mm_cvtps_epi32(a.v)) }; }
+#if defined(__SSE4_1__) || defined(__AVX__)
+inline f32x4 floor(f32x4 a) { return { _mm_floor_ps(a.v) }; }
+#else
+inline f32x4 floor(f32x4 a) {
+	// Integral floats past 2^23 have no fraction to drop, the conversion only covers 2^31.
+	f32x4 r = select(absolute(a) < 8388608.f, round_nearest(a), a);
+	return r - select(r > a, f32x4(1.f), f32x4(0.f));
+}
+#endif
+// 2^n for an integral n in [-126, 127].
+inline f32x4 exp2_int(f32x4 n) {
+	__m128i e = _mm_add_epi32(_mm_cvtps_epi32(n.v), _mm_set1_epi32(127));
+	return { _mm_castsi128_ps(_mm_slli_epi32(e, 23)) };
+}
+// Splits a positive normal a into mantissa * 2^exponent with the mantissa in [1, 2).
+inline f32x4 split_exponent(f32x4 a, f32x4& mantissa) {
+	__m128i bits = _mm_castps_si128(a.v);
+	__m128i e = _mm_sub_epi32(_mm_srli_epi32(bits, 23), _mm_set1_epi32(127));
+	__m128i m = _mm_or_si128(
+		_mm_and_si128(bits, _mm_set1_epi32(0x007fffff)), _mm_set1_epi32(0x3f800000)
+	);
+	mantissa = { _mm_castsi128_ps(m) };
+	return { _mm_cvtepi32_ps(e) };
+}
+
+#if defined(__AVX__)
+struct f32x8 {
+	static constexpr usz Width = 8;
+	__m256 v;
+
+	f32x8() = default;
+	f32x8(__m256 v) : v(v) {}
+	f32x8(f32 x) : v(_mm256_set1_ps(x)) {}
+	f32x8(f32x4 lo, f32x4 hi) : v(_mm256_insertf128_ps(_mm256_castps128_ps256(lo.v), hi.v, 1)) {}
+
+	f32x4 lo() const { return { _mm256_castps256_ps128(v) }; }
+	f32x4 hi() const { return { _mm256_extractf128_ps(v, 1) }; }
+
+	static f32x8 set1(f32 x) { return { _mm256_set1_ps(x) }; }
+	static f32x8 load(const f32* p) { return { _mm256_loadu_ps(p) }; }
+	void store(f32* p) const { _mm256_storeu_ps(p, v); }
+};
+inline f32x8 operator+(f32x8 a, f32x8 b) { return { _mm256_add_ps(a.v, b.v) }; }
+inline f32x8 operator-(f32x8 a, f32x8 b) { return { _mm256_sub_ps(a.v, b.v) }; }
+inline f32x8 operator*(f32x8 a, f32x8 b) { return { _mm256_mul_ps(a.v, b.v) }; }
+inline f32x8 operator/(f32x8 a, f32x8 b) { return { _mm256_div_ps(a.v, b.v) }; }
+inline f32x8 operator-(f32x8 a) { return { _mm256_xor_ps(a.v, _mm256_set1_ps(-0.f)) }; }
+inline f32x8 operator<(f32x8 a, f32x8 b) { return { _mm256_cmp_ps(a.v, b.v, _CMP_LT_OQ) }; }
+inline f32x8 operator>(f32x8 a, f32x8 b) { return { _mm256_cmp_ps(a.v, b.v, _CMP_GT_OQ) }; }
+inline f32x8 operator<=(f32x8 a, f32x8 b) { return { _mm256_cmp_ps(a.v, b.v, _CMP_LE_OQ) }; }
+inline f32x8 operator>=(f32x8 a, f32x8 b) { return { _mm256_cmp_ps(a.v, b.v, _CMP_GE_OQ) }; }
+inline f32x8 operator&(f32x8 a, f32x8 b) { return { _mm256_and_ps(a.v, b.v) }; }
+inline f32x8 operator|(f32x8 a, f32x8 b) { return { _mm256_or_ps(a.v, b.v) }; }
+inline f32x8 min(f32x8 a, f32x8 b) { return { _mm256_min_ps(a.v, b.v) }; }
+inline f32x8 max(f32x8 a, f32x8 b) { return { _mm256_max_ps(a.v, b.v) }; }
+inline f32x8 sqrt(f32x8 a) { return { _mm256_sqrt_ps(a.v) }; }
+inline f32x8 absolute(f32x8 a) { return { _mm256_andnot_ps(_mm256_set1_ps(-0.f), a.v) }; }
+inline f32x8 select(f32x8 mask, f32x8 a, f32x8 b) { return { _mm256_blendv_ps(b.v, a.v, mask.v) }; }
+inline f32x8 round_nearest(f32x8 a) { return { _mm256_round_ps(a.v, _MM_FROUND_TO_NEAREST_INT) }; }
+inline f32x8 floor(f32x8 a) { return { _mm256_floor_ps(a.v) }; }
+#if defined(__AVX2__)
+inline f32x8 exp2_int(f32x8 n) {
+	__m256i e = _mm256_add_epi32(_mm256_cvtps_epi32(n.v), _mm256_set1_epi32(127));
+	return { _mm256_castsi256_ps(_mm256_slli_epi32(e, 23)) };
+}
+inline f32x8 split_exponent(f32x8 a, f32x8& mantissa) {
+	__m256i bits = _mm256_castps_si256(a.v);
+	__m256i e = _mm256_sub_epi32(_mm256_srli_epi32(bits, 23), _mm256_set1_epi32(127));
+	__m256i m = _mm256_or_si256(
+		_mm256_and_si256(bits, _mm256_set1_epi32(0x007fffff)), _mm256_set1_epi32(0x3f800000)
+	);
+	mantissa = { _mm256_castsi256_ps(m) };
+	return { _mm256_cvtepi32_ps(e) };
+}
+#else
+// AVX has no 256 bit integer ops, the bit tricks go through the SSE halves.
+inline f32x8 exp2_int(f32x8 n) { return { exp2_int(n.lo()), exp2_int(n.hi()) }; }
+inline f32x8 split_exponent(f32x8 a, f32x8& mantissa) {
+	f32x4 m_lo;
+	f32x4 m_hi;
+	f32x4 e_lo = split_exponent(a.lo(), m_lo);
+	f32x4 e_hi = split_exponent(a.hi(), m_hi);
+	mantissa = { m_lo, m_hi };
+	return { e_lo, e_hi };
+}
+#endif
+#else
+// Without AVX an 8 wide lane is two SSE halves.
+struct f32x8 {
+	static constexpr usz Width = 8;
+	f32x4 l;
+	f32x4 h;
+
+	f32x8() = default;
+	f32x8(f32 x) : l(x), h(x) {}
+	f32x8(f32x4 lo, f32x4 hi) : l(lo), h(hi) {}
+
+	f32x4 lo() const { return l; }
+	f32x4 hi() const { return h; }
+
+	static f32x8 set1(f32 x) { return { f32x4::set1(x), f32x4::set1(x) }; }
+	static f32x8 load(const f32* p) { return { f32x4::load(p), f32x4::load(p + 4) }; }
+	void store(f32* p) const { l.store(p); h.store(p + 4); }
+};
+inline f32x8 operator+(f32x8 a, f32x8 b) { return { a.l + b.l, a.h + b.h }; }
+inline f32x8 operator-(f32x8 a, f32x8 b) { return { a.l - b.l, a.h - b.h }; }
+inline f32x8 operator*(f32x8 a, f32x8 b) { return { a.l * b.l, a.h * b.h }; }
+inline f32x8 operator/(f32x8 a, f32x8 b) { return { a.l / b.l, a.h / b.h }; }
+inline f32x8 operator-(f32x8 a) { return { -a.l, -a.h }; }
+inline f32x8 operator<(f32x8 a, f32x8 b) { return { a.l < b.l, a.h < b.h }; }
+inline f32x8 operator>(f32x8 a, f32x8 b) { return { a.l > b.l, a.h > b.h }; }
+inline f32x8 operator<=(f32x8 a, f32x8 b) { return { a.l <= b.l, a.h <= b.h }; }
+inline f32x8 operator>=(f32x8 a, f32x8 b) { return { a.l >= b.l, a.h >= b.h }; }
+inline f32x8 operator&(f32x8 a, f32x8 b) { return { a.l & b.l, a.h & b.h }; }
+inline f32x8 operator|(f32x8 a, f32x8 b) { return { a.l | b.l, a.h | b.h }; }
+inline f32x8 min(f32x8 a, f32x8 b) { return { min(a.l, b.l), min(a.h, b.h) }; }
+inline f32x8 max(f32x8 a, f32x8 b) { return { max(a.l, b.l), max(a.h, b.h) }; }
+inline f32x8 sqrt(f32x8 a) { return { sqrt(a.l), sqrt(a.h) }; }
+inline f32x8 absolute(f32x8 a) { return { absolute(a.l), absolute(a.h) }; }
+inline f32x8 select(f32x8 mask, f32x8 a, f32x8 b) {
+	return { select(mask.l, a.l, b.l), select(mask.h, a.h, b.h) };
+}
+inline f32x8 round_nearest(f32x8 a) { return { round_nearest(a.l), round_nearest(a.h) }; }
+inline f32x8 floor(f32x8 a) { return { floor(a.l), floor(a.h) }; }
+inline f32x8 exp2_int(f32x8 n) { return { exp2_int(n.l), exp2_int(n.h) }; }
+inline f32x8 split_exponent(f32x8 a, f32x8& mantissa) {
+	f32x4 m_lo;
+	f32x4 m_hi;
+	f32x4 e_lo = split_exponent(a.l, m_lo);
+	f32x4 e_hi = split_exponent(a.h, m_hi);
+	mantissa = { m_lo, m_hi };
+	return { e_lo, e_hi };
+}
+#endif
+
+// Lane i is base[indices[i]].
+inline f32x8 gather(const f32* base, const i32* indices) {
+#if defined(__AVX2__)
+	return { _mm256_i32gather_ps(base, _mm256_loadu_si256((const __m256i*)indices), 4) };
+#else
+	alignas(32) f32 v[8];
+	for (usz i = 0; i < 8; i += 1)
+		v[i] = base[indices[i]];
+	return f32x8::load(v);
+#endif
+}
+
+// The same primitives on a single f32, so lane generic code also compiles for scalars.
+inline f32 absolute(f32 a) { return fabsf(a); }
+inline f32 select(bool mask, f32 a, f32 b) { return mask ? a : b; }
+inline f32 round_nearest(f32 a) {
+	// Adding 1.5 * 2^23 pushes the fraction bits out of the mantissa, ties to even.
+	constexpr f32 magic = 12582912.f;
+	return (a + magic) - magic;
+}
+inline f32 exp2_int(f32 n) {
+	u32 bits = (u32)((i32)n + 127) << 23;
+	f32 r;
+	memcpy(&r, &bits, sizeof(r));
+	return r;
+}
+inline f32 split_exponent(f32 a, f32& mantissa) {
+	u32 bits;
+	memcpy(&bits, &a, sizeof(bits));
+	i32 e = (i32)(bits >> 23) - 127;
+	bits = (bits & 0x007fffff) | 0x3f800000;
+	memcpy(&mantissa, &bits, sizeof(mantissa));
+	return (f32)e;
+}
+
+// Width vectors at once, x, y and z each hold one lane per vector.
+template <typename F>
+struct Vector3fx {
+	F x;
+	F y;
+	F z;
+
+	static Vector3fx splat(Vector3f v) { return { F::set1(v.x), F::set1(v.y), F::set1(v.z) }; }
+
+	static Vector3fx load(const Vector3f* p) {
+		alignas(32) f32 x[F::Width];
+		alignas(32) f32 y[F::Width];
+		alignas(32) f32 z[F::Width];
+		for (usz i = 0; i < F::Width; i += 1) {
+			x[i] = p[i].x;
+			y[i] = p[i].y;
+			z[i] = p[i].z;
+		}
+		return { F::load(x), F::load(y), F::load(z) };
+	}
+
+	void store(Vector3f* p) const {
+		alignas(32) f32 xs[F::Width];
+		alignas(32) f32 ys[F::Width];
+		alignas(32) f32 zs[F::Width];
+		x.store(xs);
+		y.store(ys);
+		z.store(zs);
+		for (usz i = 0; i < F::Width; i += 1) {
+			p[i] = { xs[i], ys[i], zs[i] };
+		}
+	}
+};
+using Vector3fx4 = Vector3fx<f32x4>;
+using Vector3fx8 = Vector3fx<f32x8>;
+
+template <typename F>
+inline Vector3fx<F> operator+(Vector3fx<F> a, Vector3fx<F> b) {
+	return { a.x + b.x, a.y + b.y, a.z + b.z };
+}
+template <typename F>
+inline Vector3fx<F> operator-(Vector3fx<F> a, Vector3fx<F> b) {
+	return { a.x - b.x, a.y - b.y, a.z - b.z };
+}
+template <typename F>
+inline Vector3fx<F> operator*(Vector3fx<F> v, F s) {
+	return { v.x * s, v.y * s, v.z * s };
+}
+template <typename F>
+inline Vector3fx<F> operator*(F s, Vector3fx<F> v) {
+	return { v.x * s, v.y * s, v.z * s };
+}
+template <typename F>
+inline Vector3fx<F> operator/(Vector3fx<F> v, F s) {
+	return { v.x / s, v.y / s, v.z / s };
+}
+template <typename F>
+inline Vector3fx<F> cross(Vector3fx<F> a, Vector3fx<F> b) {
+	return {
+		a.y * b.z - a.z * b.y,
+		a.z * b.x - a.x * b.z,
+		a.x * b.y - a.y * b.x
+	};
+}
+template <typename F>
+inline F dot(Vector3fx<F> a, Vector3fx<F> b) {
+	return a.x * b.x + a.y * b.y + a.z * b.z;
+}
+template <typename F>
+inline F length(Vector3fx<F> v) {
+	return sqrt(dot(v, v));
+}
+template <typename F>
+inline Vector3fx<F> normalize(Vector3fx<F> v) {
+	return v / length(v);
+}
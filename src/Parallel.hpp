@@ -0,0 +1,37 @@
+#pragma once
+
+#include "Common.hpp"
+
+#include <algorithm>
+#include <thread>
+#include <vector>
+
+// Number of workers worth spawning for n items when each worker should get at least grain items.
+inline usz worker_count(usz n, usz grain) {
+	usz hw = std::max<usz>(std::thread::hardware_concurrency(), 1);
+	usz by_size = std::max<usz>(n / std::max<usz>(grain, 1), 1);
+	return std::min(hw, by_size);
+}
+
+// Runs f(w) for every w in [0, workers), the calling thread takes worker 0.
+template <typename F>
+void parallel_workers(usz workers, F&& f) {
+	std::vector<std::thread> threads;
+	threads.reserve(workers > 0 ? workers - 1 : 0);
+	for (usz w = 1; w < workers; w += 1) {
+		threads.emplace_back([&f, w] { f(w); });
+	}
+	if (workers > 0)
+		f((usz)0);
+	for (std::thread& thread : threads)
+		thread.join();
+}
+
+// Splits [0, n) into contiguous ranges and runs f(begin, end) on each of them in parallel.
+template <typename F>
+void parallel_for(usz n, usz grain, F&& f) {
+	usz workers = worker_count(n, grain);
+	parallel_workers(workers, [&] (usz w) {
+		f(n * w / workers, n * (w + 1) / workers);
+	});
+}
@@ -4,11 +4,14 @@
 #include "Graphics.hpp"
 #include "Maths.hpp"
 #include "Noise.hpp"
+#include "Parallel.hpp"
+#include "FastMath.hpp"
 #include "SDL3/SDL_gpu.h"
 #include "imgui/imgui.h"
 
 #include <unordered_map>
 #include <algorithm>
+#include <barrier>
 #include <cmath>
 #include <vector>
 
@@ -54,13 +57,14 @@ Planet::Planet() {
 	};
 }
 
-void Planet::create_pipeline(SDL_GPUDevice* gpu, SDL_GPUTextureFormat format) {
-	mesh.create_pipeline(gpu, format);
-	vector_field.create_pipeline(gpu, format);
+void Planet::create_pipeline(SDL_GPUDevice* gpu, const Render_Settings& settings) {
+	mesh.create_pipeline(gpu, settings);
+	vector_field.create_pipeline(gpu, settings);
 }
 
 void Planet::release(SDL_GPUDevice* gpu) {
 	mesh.release(gpu);
+	lod.mesh.release(gpu);
 	vector_field.release(gpu);
 }
 
@@ -71,34 +75,22 @@ void Planet::Mesh::release(SDL_GPUDevice* gpu) {
 	if (gpu_transfer_buffer) {
 		SDL_ReleaseGPUTransferBuffer(gpu, gpu_transfer_buffer);
 	}
-	if (pipeline) {
-		SDL_ReleaseGPUGraphicsPipeline(gpu, pipeline);
-	}
+	// The pipeline belongs to Pipeline_Factory::factory.
+	pipeline = nullptr;
 }
 
 void Planet::generate_icosphere(SDL_GPUDevice* gpu, size_t order) {
-	float f = (1 + sqrtf(5)) / 2;
 	std::vector<Vector3f> positions;
-	positions.push_back(normalize({-1, +f, +0}));
-	positions.push_back(normalize({+1, +f, +0}));
-	positions.push_back(normalize({-1, -f, +0}));
-	positions.push_back(normalize({+1, -f, +0}));
-	positions.push_back(normalize({+0, -1, +f}));
-	positions.push_back(normalize({+0, +1, +f}));
-	positions.push_back(normalize({+0, -1, -f}));
-	positions.push_back(normalize({+0, +1, -f}));
-	positions.push_back(normalize({+f, +0, -1}));
-	positions.push_back(normalize({+f, +0, +1}));
-	positions.push_back(normalize({-f, +0, -1}));
-	positions.push_back(normalize({-f, +0, +1}));
+	for (size_t i = 0; i < 12; i += 1)
+		positions.push_back(icosahedron_vertex(i));
 
 	size_t v = 12;
-	std::vector<size_t> indices{
-		0, 11, 5, 0, 5, 1, 0, 1, 7, 0, 7, 10, 0, 10, 11,
-		11, 10, 2, 5, 11, 4, 1, 5, 9, 7, 1, 8, 10, 7, 6,
-		3, 9, 4, 3, 4, 2, 3, 2, 6, 3, 6, 8, 3, 8, 9,
-		9, 8, 1, 4, 9, 5, 2, 4, 11, 6, 2, 10, 8, 6, 7
-	};
+	std::vector<size_t> indices;
+	for (size_t i = 0; i < 20; i += 1) {
+		indices.push_back(Icosahedron_Faces[i][0]);
+		indices.push_back(Icosahedron_Faces[i][1]);
+		indices.push_back(Icosahedron_Faces[i][2]);
+	}
 
 	std::unordered_map<size_t, size_t> cache;
 
@@ -165,6 +157,7 @@ void Planet::generate_icosphere(SDL_GPUDevice* gpu, size_t order) {
 	}
 
 	tiles.resize(mesh.vertices.size() / 3);
+	geo.valid = false;
 	std::unordered_map<size_t, size_t> edge_to_face;
 	auto edge_to_key = [] (size_t a, size_t b) -> size_t {
 		return (a + b) * (a + b + 1) / 2 + std::min(a, b);
@@ -247,61 +240,276 @@ void Planet::generate_icosphere(SDL_GPUDevice* gpu, size_t order) {
 		tiles[i / 3].center = center;
 	}
 
-	if (mesh.gpu_vertex_buffer) {
-		SDL_ReleaseGPUBuffer(gpu, mesh.gpu_vertex_buffer);
-	}
-	mesh.gpu_vertex_buffer = SDL_CreateGPUBuffer(
-		gpu,
-		&(SDL_GPUBufferCreateInfo) {
-			.usage = SDL_GPU_BUFFERUSAGE_VERTEX,
-			.size = (u32)(mesh.vertices.size() * sizeof(*mesh.vertices.data()))
-		}
-	);
+	graph.build(tiles);
 
-	if (mesh.gpu_transfer_buffer) {
-		SDL_ReleaseGPUTransferBuffer(gpu, mesh.gpu_transfer_buffer);
-	}
-	mesh.gpu_transfer_buffer = SDL_CreateGPUTransferBuffer(
-		gpu, &(SDL_GPUTransferBufferCreateInfo) {
-			.usage = SDL_GPU_TRANSFERBUFFERUSAGE_UPLOAD,
-			.size = (u32)(mesh.vertices.size() * sizeof(*mesh.vertices.data()))
-		}
-	);
+	lod.tile_corners.resize(mesh.vertices.size());
+	for (size_t i = 0; i < mesh.vertices.size(); i += 1)
+		lod.tile_corners[i] = mesh.vertices[i].position;
+	lod.param.tile_order = (u32)order;
+	lod.cache.clear();
+	tile_version += 1;
+
+	mesh.reserve(gpu, mesh.vertices.size());
+}
+
+Height_Cache_Key Planet::height_cache_key(const Generation_Param& param) {
+	return {
+		(u32)param.noise_basis,
+		(u32)param.octave,
+		param.roughness,
+		param.lacunarity,
+		param.height_cache_resolution
+	};
 }
 
 void Planet::generate_from_mesh(const Planet::Generation_Param& param) {
 	generation_param = param;
 
-	fill_height(param.octave, param.roughness, param.lacunarity);
+	fill_height(
+		param.noise_basis,
+		param.octave,
+		param.roughness,
+		param.lacunarity,
+		param.height_cache_resolution
+	);
 	grow_plates(
 		param.n_plates, param.plate_speed, param.plate_fail_smooth, param.plate_fail_smooth_factor
 	);
 	find_water(param.water_level, param.peak_level);
 	categorize_tiles();
-	fill_year_temperature();
-	fill_base_pressure();
-	fill_macro_wind();
+	fill_climate();
 	fill_wind_step_to_moutain();
 	fill_humidity();
+
+	biome_index.base_kind.resize(tiles.size());
+	for (size_t i = 0; i < tiles.size(); i += 1) {
+		biome_index.base_kind[i] = tiles[i].kind;
+	}
+	biome_index.valid = false;
+	tile_version += 1;
 }
 
-void Planet::fill_height(size_t octave, f32 roughness, f32 lacunarity) {
-	for (size_t i = 0; i < mesh.vertices.size(); i += 3) {
-		Vector3f a = mesh.vertices[i + 0].position;
-		Vector3f b = mesh.vertices[i + 1].position;
-		Vector3f c = mesh.vertices[i + 2].position;
+void Planet::fill_height(
+	Noise_Basis basis, size_t octave, f32 roughness, f32 lacunarity, u32 cache_resolution
+) {
+	size_t n = mesh.vertices.size() / 3;
+	std::vector<f32> heights(n);
+
+	if (cache_resolution > 0) {
+		height_cube.prepare({ (u32)basis, (u32)octave, roughness, lacunarity, cache_resolution });
+		size_t level = height_cube.level_for(n);
+
+		for (size_t i = 0; i < n; i += 1) {
+			Vector3f a = mesh.vertices[i * 3 + 0].position;
+			Vector3f b = mesh.vertices[i * 3 + 1].position;
+			Vector3f c = mesh.vertices[i * 3 + 2].position;
+			heights[i] = height_cube.sample(a + b + c, level);
+		}
+	} else {
+		std::vector<f32> xs(n);
+		std::vector<f32> ys(n);
+		std::vector<f32> zs(n);
+
+		for (size_t i = 0; i < n; i += 1) {
+			Vector3f a = mesh.vertices[i * 3 + 0].position;
+			Vector3f b = mesh.vertices[i * 3 + 1].position;
+			Vector3f c = mesh.vertices[i * 3 + 2].position;
+
+			Vector3f center = (a + b + c) * (1 / 3.0f);
+			center = center * 0.5f + Vector3f(0.5f, 0.5f, 0.5f);
+			xs[i] = center.x;
+			ys[i] = center.y;
+			zs[i] = center.z;
+		}
 
-		Vector3f center = (a + b + c) * (1 / 3.0f);
-		center = center * 0.5f + Vector3f(0.5f, 0.5f, 0.5f);
-		f32 height = fractal_perlin(center.x, center.y, center.z, octave, roughness, lacunarity);
-		height *= 10;
+		fractal_noise(
+			basis, xs.data(), ys.data(), zs.data(), heights.data(), n, octave, roughness, lacunarity
+		);
+	}
+
+	for (size_t i = 0; i < n; i += 1) {
+		f32 height = heights[i] * 10;
 
-		tiles[i / 3].height = height;
+		tiles[i].height = height;
 		min_height = std::min(min_height, height);
 		max_height = std::max(max_height, height);
 	}
 }
 
+void Planet::fill_geo_field() {
+	if (geo.valid && geo.axial_tilt == axial_tilt && geo.sin_latitude.size() == tiles.size())
+		return;
+
+	Vector3f axis = get_rotation_axis();
+	Vector3f zero = get_zero_longitude_axis();
+	Vector3f east = cross(axis, zero);
+
+	geo.sin_latitude.resize(tiles.size());
+	geo.cos_latitude.resize(tiles.size());
+	geo.cos_longitude.resize(tiles.size());
+
+	parallel_for(tiles.size(), 16 * 1024, [&] (size_t begin, size_t end) {
+		for (size_t i = begin; i < end; i += 1) {
+			Vector3f dt = normalize(tiles[i].center);
+			f32 s = std::clamp(dot(axis, dt), -1.f, 1.f);
+			f32 c = std::sqrt(1 - s * s);
+
+			// Longitude is measured in the equatorial plane, from the zero longitude axis.
+			f32 lx = dot(dt, zero);
+			f32 ly = dot(dt, east);
+			f32 l = std::sqrt(lx * lx + ly * ly);
+
+			geo.sin_latitude[i] = s;
+			geo.cos_latitude[i] = c;
+			geo.cos_longitude[i] = lx / l;
+		}
+	});
+
+	geo.axial_tilt = axial_tilt;
+	geo.valid = true;
+}
+
+// Per tile climate math of fill_climate.
+struct Insolation {
+	f32 k2;
+	f32 k4;
+	f32 k6;
+	f32 average;
+};
+
+static f32 legendre_p2(f32 b) {
+	return (3 * b * b - 1) / 2;
+}
+static f32 legendre_p4(f32 b) {
+	return (35 * b * b * b * b - 30 * b * b + 3) / 8;
+}
+static f32 legendre_p6(f32 b) {
+	return (231 * b * b * b * b * b * b - 315 * b * b * b * b + 105 * b * b - 5) / 16;
+}
+
+static Insolation get_insolation(f32 axial_tilt, f32 average_temperature) {
+	// Only the y dependent half of the insolation series changes from tile to tile.
+	f32 cos_beta = cosf(axial_tilt * DEG_RADf);
+	Insolation insolation;
+	insolation.k2 = 5 * legendre_p2(cos_beta) / 8;
+	insolation.k4 = 9 * legendre_p4(cos_beta) / 64;
+	insolation.k6 = 65 * legendre_p6(cos_beta) / 1024;
+	insolation.average = average_temperature;
+	return insolation;
+}
+
+static void fill_tile_temperature(Tile& tile, f32 sin_latitude, const Insolation& insolation) {
+	static constexpr f32 dividors[(u8)Tile::Kind::COUNT + 1] = {
+		1.05f,  // DEEP_OCEAN
+		1.01f,  // SHALLOW_OCEAN
+		1.005f, // BEACH
+		1.f,    // DESERT
+		1.f,    // TUNDRA
+		1.f,    // STEPPE
+		0.95f,  // FOREST
+		1.f,    // RAIN_FOREST
+		1.3f,   // PEAK
+		1.f,    // SNOW
+		1.f,    // SNOW_PEAK
+		1.f,    // ICE
+		1.f,    // COUNT
+	};
+
+	// theta is the latitude with the sign flipped, so sin(theta) = -sin(latitude).
+	f32 y = -sin_latitude;
+	f32 average = insolation.average;
+
+	f32 intensity = 1.0f;
+	intensity -= insolation.k2 * legendre_p2(y);
+	intensity -= insolation.k4 * legendre_p4(y);
+	intensity -= insolation.k6 * legendre_p6(y);
+	tile.heat_quantity = intensity * 10 + average;
+	intensity += average;
+	f32 dividor = dividors[(u8)tile.kind];
+	intensity /= 1 + (dividor - 1) / 75;
+	intensity = 10 * (intensity - average);
+	intensity += average;
+
+	tile.year_temperature = intensity;
+}
+
+static void fill_tile_pressure(Tile& tile, f32 cos_latitude, f32 cos_longitude, bool fast_math) {
+	// cos(6x) as a polynomial of cos(x).
+	auto cos6 = [] (f32 c) -> f32 {
+		f32 c2 = c * c;
+		return ((32 * c2 - 48) * c2 + 18) * c2 - 1;
+	};
+
+	f32 y = 1.f - cos6(cos_latitude);
+	f32 x = cos6(cos_longitude);
+
+	f32 t = tile.heat_quantity;
+
+	f32 p = 0.287 * t / 5;
+	f32 altitude =
+		1 - std::clamp(6.87535f * 0.000001f * 3281 * std::max(tile.height, 0.f), 0.f, 1.f);
+	f32 factorAlt = (fast_math ? fast_pow(altitude, 5.2561f) : std::powf(altitude, 5.2561f)) / 30;
+	f32 factorLL = y * ((cos_latitude * cos_latitude) * 0.25f * x + 0.5f);
+	tile.base_pressure = p * factorAlt + factorLL;
+}
+
+static Vector3f get_tile_macro_wind(const std::vector<Tile>& tiles, size_t i) {
+	f32 curr = tiles[i].base_pressure;
+	f32 a = tiles[tiles[i].na].base_pressure;
+	f32 b = tiles[tiles[i].nb].base_pressure;
+	f32 c = tiles[tiles[i].nc].base_pressure;
+
+	Vector3f da = normalize(tiles[tiles[i].na].center - tiles[i].center);
+	Vector3f db = normalize(tiles[tiles[i].nb].center - tiles[i].center);
+	Vector3f dc = normalize(tiles[tiles[i].nc].center - tiles[i].center);
+
+	return normalize((curr - a) * da + (curr - b) * db + (curr - c) * dc);
+}
+
+void Planet::fill_climate() {
+	// Tiles are processed in small chunks so the second read of a record in the first sweep is
+	// still in L1, the macro wind needs every neighbour's pressure so it gets its own sweep.
+	constexpr size_t Chunk = 1024;
+
+	fill_geo_field();
+	Insolation insolation = get_insolation(axial_tilt, generation_param.average_temperature);
+
+	size_t workers = worker_count(tiles.size(), 16 * 1024);
+	std::vector<f32> min_temps(workers, +FLT_MAX);
+	std::vector<f32> max_temps(workers, -FLT_MAX);
+	std::barrier sync((std::ptrdiff_t)workers);
+
+	parallel_workers(workers, [&] (size_t w) {
+		size_t begin = tiles.size() * w / workers;
+		size_t end = tiles.size() * (w + 1) / workers;
+
+		for (size_t chunk = begin; chunk < end; chunk += Chunk) {
+			size_t chunk_end = std::min(chunk + Chunk, end);
+			for (size_t i = chunk; i < chunk_end; i += 1) {
+				fill_tile_temperature(tiles[i], geo.sin_latitude[i], insolation);
+				fill_tile_pressure(
+					tiles[i], geo.cos_latitude[i], geo.cos_longitude[i], generation_param.fast_math
+				);
+				min_temps[w] = std::min(min_temps[w], tiles[i].year_temperature);
+				max_temps[w] = std::max(max_temps[w], tiles[i].year_temperature);
+			}
+		}
+
+		sync.arrive_and_wait();
+
+		for (size_t i = begin; i < end; i += 1) {
+			tiles[i].macro_wind = get_tile_macro_wind(tiles, i);
+		}
+	});
+
+	for (size_t w = 0; w < workers; w += 1) {
+		min_year_temp = std::min(min_year_temp, min_temps[w]);
+		max_year_temp = std::max(max_year_temp, max_temps[w]);
+	}
+}
+
+// The three passes below are the formulas fill_climate was fused from, written out on their own
+// so check_climate compares it against something it does not share code with.
 void Planet::fill_year_temperature() {
 	auto p2 = [] (f32 b) -> f32 {
 		return (3 * b * b - 1) / 2;
@@ -313,51 +521,44 @@ void Planet::fill_year_temperature() {
 		return (231 * b * b * b * b * b * b - 315 * b * b * b * b + 105 * b * b - 5) / 16;
 	};
 
-	auto sig = [&] (f32 y, f32 b) -> f32 {
-		f32 ret = 1.0f;
-		ret -= 5 * p2(cos(b)) * p2(y) / 8;
-		ret -= 9 * p4(cos(b)) * p4(y) / 64;
-		ret -= 65 * p6(cos(b)) * p6(y) / 1024;
-		return ret;
+	fill_geo_field();
+
+	// Only the y dependent half of the insolation series changes from tile to tile.
+	f32 cos_beta = cosf(axial_tilt * DEG_RADf);
+	f32 k2 = 5 * p2(cos_beta) / 8;
+	f32 k4 = 9 * p4(cos_beta) / 64;
+	f32 k6 = 65 * p6(cos_beta) / 1024;
+
+	static constexpr f32 dividors[(u8)Tile::Kind::COUNT + 1] = {
+		1.05f,  // DEEP_OCEAN
+		1.01f,  // SHALLOW_OCEAN
+		1.005f, // BEACH
+		1.f,    // DESERT
+		1.f,    // TUNDRA
+		1.f,    // STEPPE
+		0.95f,  // FOREST
+		1.f,    // RAIN_FOREST
+		1.3f,   // PEAK
+		1.f,    // SNOW
+		1.f,    // SNOW_PEAK
+		1.f,    // ICE
+		1.f,    // COUNT
 	};
-	Vector3f axis = get_rotation_axis();
 
+	f32 average = generation_param.average_temperature;
 	for (size_t i = 0; i < tiles.size(); i += 1)
 	{
 		Tile& tile = tiles[i];
-		Vector3f dt = normalize(tile.center);
-		f32 theta = angle(axis, dt);
-		theta = theta - PIf / 2;
-		f32 beta = axial_tilt * DEG_RADf;
-		f32 y = sinf(theta);
-
-		f32 intensity = sig(y, beta);
-		tile.heat_quantity = intensity * 10 + generation_param.average_temperature;
-		intensity += generation_param.average_temperature;
-		f32 dividor = 1.0f;
-		switch (tile.kind)
-		{
-		case Tile::Kind::DEEP_OCEAN:
-			dividor = 1.05;
-			break;
-		case Tile::Kind::SHALLOW_OCEAN:
-			dividor = 1.01;
-			break;
-		case Tile::Kind::BEACH:
-			dividor = 1.005;
-			break;
-		case Tile::Kind::FOREST:
-			dividor = 0.95;
-			break;
-		case Tile::Kind::PEAK:
-			dividor = 1.3;
-			break;
-		case Tile::Kind::COUNT:
-			break;
-		}
+		// theta is the latitude with the sign flipped, so sin(theta) = -sin(latitude).
+		f32 y = -geo.sin_latitude[i];
+
+		f32 intensity = 1.0f - k2 * p2(y) - k4 * p4(y) - k6 * p6(y);
+		tile.heat_quantity = intensity * 10 + average;
+		intensity += average;
+		f32 dividor = dividors[(u8)tile.kind];
 		intensity /= 1 + (dividor - 1) / 75;
-		intensity = 10 * (intensity - generation_param.average_temperature);
-		intensity += generation_param.average_temperature;
+		intensity = 10 * (intensity - average);
+		intensity += average;
 
 		tile.year_temperature = intensity;
 		min_year_temp = std::min(min_year_temp, intensity);
@@ -366,38 +567,29 @@ void Planet::fill_year_temperature() {
 }
 
 void Planet::fill_base_pressure() {
-	f32 min_p = +FLT_MAX;
-	f32 max_p = -FLT_MAX;
-	Vector3f axis = get_rotation_axis();
-	Vector3f zero = get_zero_longitude_axis();
-
-	auto A = [] (f32 x) -> f32 {
-		return std::powf(std::powf(std::sinf(2 * std::abs(x)), 1/3.f), 2.f);
-	};
-	auto B = [] (f32 x) -> f32 {
-		return (0.5 + (1 - std::sinf(x) * std::sinf(x))) / 2;
-	};
-	auto f = [&] (f32 x) -> f32 {
-		return (A(x) + B(x)) / 1.75f;
+	// cos(6x) as a polynomial of cos(x).
+	auto cos6 = [] (f32 c) -> f32 {
+		f32 c2 = c * c;
+		return ((32 * c2 - 48) * c2 + 18) * c2 - 1;
 	};
 
+	fill_geo_field();
+
+	bool fast_math = generation_param.fast_math;
 	for (size_t i = 0; i < tiles.size(); i += 1) {
 		Tile& tile = tiles[i];
-		Vector3f dt = normalize(tile.center);
-		f32 theta = angle(axis, dt);
-		theta = theta - PIf / 2;
-		f32 y = 1.f - cosf(theta * 6.f);
-		f32 x = cosf(6.f * angle(zero, normalize(dt - axis * dot(dt, axis))));
+		f32 cos_theta = geo.cos_latitude[i];
+		f32 y = 1.f - cos6(cos_theta);
+		f32 x = cos6(geo.cos_longitude[i]);
 
 		f32 t = tile.heat_quantity;
 
 		f32 p = 0.287 * t / 5;
-		f32 factorAlt = std::powf(
-			1 - std::clamp(6.87535f * 0.000001f * 3281 * std::max(tile.height, 0.f), 0.f, 1.f),
-			5.2561f
-		) / 30;
-		f32 factorTilt = f(theta);
-		f32 factorLL = y * ((cos(theta) * cos(theta)) * 0.25f * x + 0.5f);
+		f32 altitude =
+			1 - std::clamp(6.87535f * 0.000001f * 3281 * std::max(tile.height, 0.f), 0.f, 1.f);
+		f32 factorAlt =
+			(fast_math ? fast_pow(altitude, 5.2561f) : std::powf(altitude, 5.2561f)) / 30;
+		f32 factorLL = y * ((cos_theta * cos_theta) * 0.25f * x + 0.5f);
 		tile.base_pressure = p * factorAlt + factorLL;
 	}
 }
@@ -418,6 +610,59 @@ void Planet::fill_macro_wind() {
 	}
 }
 
+size_t Planet::check_climate() {
+	std::vector<Tile> saved = tiles;
+	f32 saved_min = min_year_temp;
+	f32 saved_max = max_year_temp;
+
+	fill_year_temperature();
+	fill_base_pressure();
+	fill_macro_wind();
+	std::vector<Tile> reference = std::move(tiles);
+	f32 reference_min = min_year_temp;
+	f32 reference_max = max_year_temp;
+
+	tiles = std::move(saved);
+	min_year_temp = saved_min;
+	max_year_temp = saved_max;
+	fill_climate();
+
+	// Field by field, Tile has padding.
+	size_t mismatches = 0;
+	for (size_t i = 0; i < tiles.size(); i += 1) {
+		const Tile& a = tiles[i];
+		const Tile& b = reference[i];
+		bool same = true;
+		same &= memcmp(&a.heat_quantity, &b.heat_quantity, sizeof(a.heat_quantity)) == 0;
+		same &= memcmp(&a.year_temperature, &b.year_temperature, sizeof(a.year_temperature)) == 0;
+		same &= memcmp(&a.base_pressure, &b.base_pressure, sizeof(a.base_pressure)) == 0;
+		same &= memcmp(&a.macro_wind, &b.macro_wind, sizeof(a.macro_wind)) == 0;
+		if (!same) {
+			if (mismatches == 0) {
+				printf(
+					"Climate: tile %zu differs, fused %a %a %a, separate %a %a %a\n",
+					i,
+					a.heat_quantity,
+					a.year_temperature,
+					a.base_pressure,
+					b.heat_quantity,
+					b.year_temperature,
+					b.base_pressure
+				);
+			}
+			mismatches += 1;
+		}
+	}
+	if (
+		memcmp(&min_year_temp, &reference_min, sizeof(f32)) != 0 ||
+		memcmp(&max_year_temp, &reference_max, sizeof(f32)) != 0
+	) {
+		printf("Climate: year temperature range differs\n");
+		mismatches += 1;
+	}
+	return mismatches;
+}
+
 void Planet::fill_wind_step_to_moutain() {
 	std::vector<size_t> open;
 	std::vector<float> weights;
@@ -577,23 +822,16 @@ void Planet::fill_humidity() {
 		tile.humidity -= tile.height / 20;
 	}
 
-	if (true) for (size_t j = 0; j < 4; j += 1) {
-		std::vector<float> temp_humidity;
-		temp_humidity.resize(tiles.size());
-
+	{
+		std::vector<f32> humidity(tiles.size());
 		for (size_t i = 0; i < tiles.size(); i += 1) {
-			Tile& tile = tiles[i];
-
-			float ha = tiles[tile.na].humidity;
-			float hb = tiles[tile.nb].humidity;
-			float hc = tiles[tile.nc].humidity;
-
-			temp_humidity[i] = (tile.humidity + (ha + hb + hc) / 3.f) / 2.f;
+			humidity[i] = tiles[i].humidity;
 		}
 
+		diffuse(graph, humidity.data(), 4, 0.5f, 0.5f);
+
 		for (size_t i = 0; i < tiles.size(); i += 1) {
-			Tile& tile = tiles[i];
-			tile.humidity = temp_humidity[i];
+			tiles[i].humidity = humidity[i];
 		}
 	}
 	for (size_t i = 0; i < tiles.size(); i += 1) {
@@ -624,9 +862,52 @@ void Planet::fill_humidity() {
 }
 
 
+void Planet::Mesh::reserve(SDL_GPUDevice* gpu, usz count) {
+	if (count <= gpu_capacity)
+		return;
+	gpu_capacity = std::max(count, gpu_capacity + gpu_capacity / 2);
+
+	if (gpu_vertex_buffer) {
+		SDL_ReleaseGPUBuffer(gpu, gpu_vertex_buffer);
+	}
+	gpu_vertex_buffer = SDL_CreateGPUBuffer(
+		gpu,
+		&(SDL_GPUBufferCreateInfo) {
+			.usage = SDL_GPU_BUFFERUSAGE_VERTEX,
+			.size = (u32)(gpu_capacity * sizeof(Packed_Vertex))
+		}
+	);
+
+	if (gpu_transfer_buffer) {
+		SDL_ReleaseGPUTransferBuffer(gpu, gpu_transfer_buffer);
+	}
+	gpu_transfer_buffer = SDL_CreateGPUTransferBuffer(
+		gpu, &(SDL_GPUTransferBufferCreateInfo) {
+			.usage = SDL_GPU_TRANSFERBUFFERUSAGE_UPLOAD,
+			.size = (u32)(gpu_capacity * sizeof(Packed_Vertex))
+		}
+	);
+}
+
+void Planet::Mesh::pack() {
+	packed.resize(vertices.size());
+	parallel_for(vertices.size(), 16 * 1024, [&] (usz begin, usz end) {
+		for (usz i = begin; i < end; i += 1) {
+			const Vertex& v = vertices[i];
+			// The tile mesh numbers its corners, chunks already store a barycenter.
+			u32 barycenter = v.triangle_index <= 2
+				? corner_barycenter(v.triangle_index)
+				: v.triangle_index;
+			packed[i] = pack_vertex(
+				{ v.position, v.normal, v.scalar, v.palette_index, barycenter }, {}, 0
+			);
+		}
+	});
+}
+
 void Planet::Mesh::upload(SDL_GPUDevice* gpu, std::vector<SDL_GPUFence*>& fences) {
 	void* gpu_data = SDL_MapGPUTransferBuffer(gpu, gpu_transfer_buffer, false);
-	memcpy(gpu_data, vertices.data(), vertices.size() * sizeof(*vertices.data()));
+	memcpy(gpu_data, packed.data(), packed.size() * sizeof(*packed.data()));
 	SDL_UnmapGPUTransferBuffer(gpu, gpu_transfer_buffer);
 
 	SDL_GPUCommandBuffer* buffer = SDL_AcquireGPUCommandBuffer(gpu);
@@ -641,7 +922,7 @@ void Planet::Mesh::upload(SDL_GPUDevice* gpu, std::vector<SDL_GPUFence*>& fences
 		&(SDL_GPUBufferRegion) {
 			.buffer = gpu_vertex_buffer,
 			.offset = 0,
-			.size = (u32)(vertices.size() * sizeof(*vertices.data()))
+			.size = (u32)(packed.size() * sizeof(*packed.data()))
 		},
 		false
 	);
@@ -650,119 +931,38 @@ void Planet::Mesh::upload(SDL_GPUDevice* gpu, std::vector<SDL_GPUFence*>& fences
 	fences.push_back(SDL_SubmitGPUCommandBufferAndAcquireFence(buffer));
 }
 
-bool Planet::Mesh::create_pipeline(SDL_GPUDevice* gpu, SDL_GPUTextureFormat format) {
-	SDL_GPUShader* vertex_shader = nullptr;
-	SDL_GPUShader* fragment_shader = nullptr;
-	{
-		size_t vertex_size = 0;
-		void* plain_vertex = SDL_LoadFile("assets/shaders/vert_planet.spv", &vertex_size);
-		defer {
-			SDL_free(plain_vertex);
-		};
-
-		size_t fragment_size = 0;
-		void* plain_fragment = SDL_LoadFile("assets/shaders/frag_planet.spv", &fragment_size);
-		defer {
-			SDL_free(plain_fragment);
-		};
-
-		if (!plain_vertex || !plain_fragment) {
-			printf("Failed to load shader files: %s\n", SDL_GetError());
-			return false;
-		}
-
-		SDL_GPUShaderCreateInfo vertex_info = {};
-		vertex_info.code_size = vertex_size;
-		vertex_info.code = (u8*)plain_vertex;
-		vertex_info.entrypoint = "main";
-		vertex_info.format = SDL_GPU_SHADERFORMAT_SPIRV;
-		vertex_info.stage = SDL_GPU_SHADERSTAGE_VERTEX;
-		vertex_info.num_samplers = 0;
-		vertex_info.num_storage_textures = 0;
-		vertex_info.num_storage_buffers = 0;
-		vertex_info.num_uniform_buffers = 2;
-		vertex_shader = SDL_CreateGPUShader(gpu, &vertex_info);
-
-		SDL_GPUShaderCreateInfo fragment_info = {};
-		fragment_info.code_size = fragment_size;
-		fragment_info.code = (u8*)plain_fragment;
-		fragment_info.entrypoint = "main";
-		fragment_info.format = SDL_GPU_SHADERFORMAT_SPIRV;
-		fragment_info.stage = SDL_GPU_SHADERSTAGE_FRAGMENT;
-		fragment_info.num_samplers = 0;
-		fragment_info.num_storage_textures = 0;
-		fragment_info.num_storage_buffers = 0;
-		fragment_info.num_uniform_buffers = 2;
-		fragment_shader = SDL_CreateGPUShader(gpu, &fragment_info);
-	}
-
-	if (!vertex_shader || !fragment_shader) {
-		printf("Failed to create shaders: %s\n", SDL_GetError());
-		return false;
-	}
-
-	SDL_GPUColorTargetDescription color_target_desc[] = {
-		{
-			.format = format,
-		}
-	};
-	SDL_GPUVertexBufferDescription vertex_buffer_desc[] = {
-		{
-			.slot = 0,
-			.pitch = sizeof(Vertex),
-			.input_rate = SDL_GPU_VERTEXINPUTRATE_VERTEX
-		}
-	};
-	SDL_GPUVertexAttribute vertex_attributes[] = {
-		{
-			.location = 0,
-			.buffer_slot = 0,
-			.format = SDL_GPU_VERTEXELEMENTFORMAT_FLOAT3,
-			.offset = offsetof(Vertex, position),
-		},
-		{
-			.location = 1,
-			.buffer_slot = 0,
-			.format = SDL_GPU_VERTEXELEMENTFORMAT_FLOAT3,
-			.offset = offsetof(Vertex, normal),
-		},
-		{
-			.location = 2,
-			.buffer_slot = 0,
-			.format = SDL_GPU_VERTEXELEMENTFORMAT_FLOAT,
-			.offset = offsetof(Vertex, scalar),
-		},
-		{
-			.location = 3,
-			.buffer_slot = 0,
-			.format = SDL_GPU_VERTEXELEMENTFORMAT_UINT,
-			.offset = offsetof(Vertex, palette_index),
-		},
-		{
-			.location = 4,
-			.buffer_slot = 0,
-			.format = SDL_GPU_VERTEXELEMENTFORMAT_UINT,
-			.offset = offsetof(Vertex, triangle_index),
-		}
-	};
-	SDL_GPUGraphicsPipelineCreateInfo info = {
-		.vertex_shader = vertex_shader,
-		.fragment_shader = fragment_shader,
-		.vertex_input_state = {
-			.vertex_buffer_descriptions = vertex_buffer_desc,
-			.num_vertex_buffers = sizeof(vertex_buffer_desc) / sizeof(*vertex_buffer_desc),
-			.vertex_attributes = vertex_attributes,
-			.num_vertex_attributes = sizeof(vertex_attributes) / sizeof(*vertex_attributes),
-		},
-		.primitive_type = SDL_GPU_PRIMITIVETYPE_TRIANGLELIST,
-		.rasterizer_state = {
-			.fill_mode = SDL_GPU_FILLMODE_FILL,
-			.cull_mode = SDL_GPU_CULLMODE_NONE,
-			.front_face = SDL_GPU_FRONTFACE_COUNTER_CLOCKWISE,
+bool Planet::Mesh::create_pipeline(SDL_GPUDevice* gpu, const Render_Settings& settings) {
+	Pipeline_Desc desc = {
+		.vertex = { .path = "assets/shaders/vert_planet.spv", .num_uniform_buffers = 3 },
+		.fragment = { .path = "assets/shaders/frag_planet.spv", .num_uniform_buffers = 2 },
+		.vertex_buffers = {
+			{
+				.slot = 0,
+				.pitch = sizeof(Packed_Vertex),
+				.input_rate = SDL_GPU_VERTEXINPUTRATE_VERTEX
+			}
 		},
-		.multisample_state = {
-			.sample_count = SDL_GPU_SAMPLECOUNT_8,
+		.vertex_attributes = {
+			{
+				.location = 0,
+				.buffer_slot = 0,
+				.format = SDL_GPU_VERTEXELEMENTFORMAT_SHORT4,
+				.offset = offsetof(Packed_Vertex, position),
+			},
+			{
+				.location = 1,
+				.buffer_slot = 0,
+				.format = SDL_GPU_VERTEXELEMENTFORMAT_UINT,
+				.offset = offsetof(Packed_Vertex, normal_scalar),
+			},
+			{
+				.location = 2,
+				.buffer_slot = 0,
+				.format = SDL_GPU_VERTEXELEMENTFORMAT_UINT,
+				.offset = offsetof(Packed_Vertex, palette_barycenter),
+			}
 		},
+		.sample_count = settings.sample_count,
 		.depth_stencil_state = {
 			.compare_op = SDL_GPU_COMPAREOP_LESS,
 			.write_mask = 0xFF,
@@ -770,25 +970,12 @@ bool Planet::Mesh::create_pipeline(SDL_GPUDevice* gpu, SDL_GPUTextureFormat form
 			.enable_depth_write = true,
 			.enable_stencil_test = false,
 		},
-		.target_info = {
-			.color_target_descriptions = color_target_desc,
-			.num_color_targets = sizeof(color_target_desc) / sizeof(*color_target_desc),
-			.depth_stencil_format = SDL_GPU_TEXTUREFORMAT_D32_FLOAT,
-			.has_depth_stencil_target = true,
-		},
+		.color_targets = { { .format = settings.color_format } },
+		.depth_stencil_format = settings.depth_format,
+		.has_depth_stencil_target = true,
 	};
-	if (pipeline) {
-		SDL_ReleaseGPUGraphicsPipeline(gpu, pipeline);
-	}
-	pipeline = SDL_CreateGPUGraphicsPipeline(gpu, &info);
-	if (!pipeline) {
-		printf("Failed to create graphics pipeline: %s\n", SDL_GetError());
-		return false;
-	}
-
-	SDL_ReleaseGPUShader(gpu, vertex_shader);
-	SDL_ReleaseGPUShader(gpu, fragment_shader);
-	return true;
+	pipeline = Pipeline_Factory::factory.create(gpu, desc);
+	return pipeline != nullptr;
 }
 
 void Planet::imgui(SDL_GPUDevice* gpu) {
@@ -806,6 +993,31 @@ void Planet::imgui(SDL_GPUDevice* gpu) {
 		x = 1;
 	generation_param.octave = x;
 
+	x = (int)generation_param.noise_basis;
+	need_regen |= ImGui::Combo(
+		"Noise", &x, "Perlin\0" "OpenSimplex2\0" "Value\0" "Gradient lattice\0"
+	);
+	generation_param.noise_basis = (Noise_Basis)x;
+
+	{
+		// Off, then powers of two from 256 to 4096.
+		u32 resolution = generation_param.height_cache_resolution;
+		x = 0;
+		while (resolution >= 256u << x)
+			x += 1;
+		need_regen |= ImGui::Combo(
+			"Height cache", &x, "Off\0" "256\0" "512\0" "1024\0" "2048\0" "4096\0"
+		);
+		generation_param.height_cache_resolution = x > 0 ? 128u << x : 0;
+
+		// prepare only saves the keys it is asked for twice, this one is wanted now.
+		if (height_cube.valid) {
+			ImGui::SameLine();
+			if (ImGui::Button("Save##height_cache") && !height_cube.save())
+				printf("Failed to save the height cache: %s\n", SDL_GetError());
+		}
+	}
+
 	need_regen |= ImGui::SliderFloat("Roughness", &generation_param.roughness, 0.0f, 1.0f);
 	need_regen |= ImGui::SliderFloat("Lacunarity", &generation_param.lacunarity, 0.0f, 10.0f);
 	need_regen |= ImGui::SliderFloat("Water level", &generation_param.water_level, 0.0f, 1.0f);
@@ -828,6 +1040,7 @@ void Planet::imgui(SDL_GPUDevice* gpu) {
 	);
 
 	need_regen |= ImGui::SliderFloat("Plate speed", &generation_param.plate_speed, 0.0f, 10.0f);
+	need_regen |= ImGui::Checkbox("Fast math", &generation_param.fast_math);
 
 	ImGui::SeparatorText("Palette");
 
@@ -860,6 +1073,36 @@ void Planet::imgui(SDL_GPUDevice* gpu) {
 	need_regen |= ImGui::SliderFloat("Axial tilt", &axial_tilt, 0.0f, 90.0f);
 
 
+	ImGui::SeparatorText("Level of detail");
+
+	ImGui::Checkbox("Chunked mesh", &lod.enabled);
+	ImGui::SliderFloat("Max screen error px", &lod.param.max_screen_error, 0.25f, 32.f);
+	x = lod.param.subdivision;
+	if (ImGui::SliderInt("Chunk subdivision", &x, 1, 6)) {
+		lod.param.subdivision = x;
+		lod.cache.clear();
+	}
+	if (ImGui::Checkbox("Chunk skirts", &lod.param.skirts))
+		lod.cache.clear();
+	x = lod.param.max_depth;
+	ImGui::SliderInt("Max chunk depth", &x, 0, Max_Chunk_Depth);
+	lod.param.max_depth = x;
+	ImGui::Checkbox("Chunk culling", &lod.culling);
+	ImGui::Text(
+		"Chunks %zu, triangles %zu, cached %zu, generated %zu",
+		lod.selected.size(),
+		lod.mesh.packed.size() / 3,
+		lod.cache.entries.size(),
+		lod.cache.generated
+	);
+	ImGui::Text(
+		"Culled %zu frustum, %zu horizon, %zu visible triangles in %zu draws",
+		lod.stats.frustum_culled,
+		lod.stats.horizon_culled,
+		lod.stats.visible_triangles,
+		lod.draw_ranges.size()
+	);
+
 	ImGui::SeparatorText("Overlay");
 	{
 		int x = (int)overlay_render;
@@ -880,6 +1123,18 @@ void Planet::imgui(SDL_GPUDevice* gpu) {
 		uniform.overlay = x;
 		overlay_render = (Overlay_Render)x;
 	}
+	if (overlay_render == Overlay_Render::MacroWind) {
+		ImGui::SliderFloat("Arrow spacing px", &arrows.spacing, 4.f, 256.f);
+		x = (int)arrows.max_arrows;
+		ImGui::SliderInt("Max arrows", &x, 256, 1 << 18);
+		arrows.max_arrows = x;
+		ImGui::Text(
+			"Arrows %zu of %zu in %zu draws",
+			arrows.drawn,
+			arrows.instances.size(),
+			arrows.draw_ranges.size()
+		);
+	}
 
 	ImGui::SeparatorText("Info");
 
@@ -891,9 +1146,7 @@ void Planet::imgui(SDL_GPUDevice* gpu) {
 		generate_from_mesh(generation_param);
 	}
 	if (need_recategorize) {
-		find_water(generation_param.water_level, generation_param.peak_level);
-		categorize_tiles();
-		final_categorize_tiles();
+		recategorize_tiles();
 	}
 }
 
@@ -1036,47 +1289,274 @@ void Planet::update(f32 dt)
 }
 
 
+void Planet::update_lod(
+	const Matrix4f& view,
+	const Matrix4f& projection,
+	Vector3f eye,
+	f32 fov,
+	f32 viewport_height
+) {
+	if (!lod.enabled)
+		return;
+
+	Quaternionf to_local = { -orientation.x, -orientation.y, -orientation.z, orientation.w };
+	Vector3f local_eye = to_local * eye;
+	select_chunks({ local_eye, fov, viewport_height }, lod.param, lod.selected);
+
+	lod.cache.frame += 1;
+	bool same_chunks = lod.assembled.size() == lod.selected.size();
+	for (size_t i = 0; same_chunks && i < lod.selected.size(); i += 1)
+		same_chunks = lod.assembled[i] == lod.selected[i].packed();
+
+	bool rebuild =
+		!same_chunks ||
+		lod.assembled_tile_version != tile_version ||
+		lod.assembled_overlay != overlay_render;
+	if (rebuild) {
+		std::vector<const Chunk_Geometry*> chunks(lod.selected.size());
+		size_t n = 0;
+		for (size_t i = 0; i < lod.selected.size(); i += 1) {
+			chunks[i] = &lod.cache.get(lod.selected[i], lod.param, lod.tile_corners);
+			n += chunks[i]->vertices.size();
+		}
+
+		lod.assembled.resize(chunks.size());
+		lod.bounds.resize(chunks.size());
+		lod.chunk_ranges.resize(chunks.size());
+		lod.occluder_radius = 1.f;
+		lod.mesh.packed.resize(n);
+
+		u32 first = 0;
+		for (size_t i = 0; i < chunks.size(); i += 1) {
+			const Chunk_Geometry& chunk = *chunks[i];
+			lod.assembled[i] = chunk.key.packed();
+			lod.bounds[i] = chunk.bounds;
+			lod.chunk_ranges[i] = { first, (u32)chunk.vertices.size() };
+			lod.occluder_radius = std::min(lod.occluder_radius, chunk.bounds.surface_radius);
+			first += (u32)chunk.vertices.size();
+
+			// Past the last slot chunks fall back to the unit sphere, at a coarser precision.
+			if (i + 1 < Max_Quantization_Slots) {
+				const Chunk_Bounds& b = chunk.bounds;
+				lod.quantization[i + 1] = { b.center.x, b.center.y, b.center.z, b.radius };
+			}
+		}
+
+		// Chunk vertices carry their tile, the per tile attributes come from the order mesh.
+		parallel_for(chunks.size(), 8, [&] (usz begin, usz end) {
+			for (usz i = begin; i < end; i += 1) {
+				u16 slot = i + 1 < Max_Quantization_Slots ? (u16)(i + 1) : 0;
+				Vector4f q = lod.quantization[slot];
+				Vertex_Quantization quantization = { { q.x, q.y, q.z }, q.w };
+
+				Packed_Vertex* out = lod.mesh.packed.data() + lod.chunk_ranges[i].first;
+				for (const Chunk_Vertex& v : chunks[i]->vertices) {
+					const Mesh::Vertex& tile = mesh.vertices[(size_t)v.tile * 3];
+					*out++ = pack_vertex(
+						{ v.position, v.normal, tile.scalar, tile.palette_index, v.barycenter },
+						quantization,
+						slot
+					);
+				}
+			}
+		});
+
+		lod.assembled_tile_version = tile_version;
+		lod.assembled_overlay = overlay_render;
+		lod.needs_upload = true;
+	} else {
+		for (const Chunk_Key& key : lod.selected)
+			lod.cache.get(key, lod.param, lod.tile_corners);
+	}
+	lod.cache.evict();
+
+	// Culling in the planet frame, neighbouring visible chunks are merged into a single range.
+	Frustum frustum = frustum_from_clip(projection * view * mesh.local);
+	lod.stats = {};
+	lod.stats.chunks = lod.assembled.size();
+	lod.draw_ranges.clear();
+	for (size_t i = 0; i < lod.assembled.size(); i += 1) {
+		Chunk_Cull cull = Chunk_Cull::Visible;
+		if (lod.culling)
+			cull = cull_chunk(lod.bounds[i], frustum, local_eye, lod.occluder_radius);
+
+		if (cull == Chunk_Cull::Frustum) {
+			lod.stats.frustum_culled += 1;
+			continue;
+		}
+		if (cull == Chunk_Cull::Horizon) {
+			lod.stats.horizon_culled += 1;
+			continue;
+		}
+
+		Lod::Range range = lod.chunk_ranges[i];
+		lod.stats.visible_triangles += range.count / 3;
+		if (!lod.draw_ranges.empty()) {
+			Lod::Range& last = lod.draw_ranges.back();
+			if (last.first + last.count == range.first) {
+				last.count += range.count;
+				continue;
+			}
+		}
+		lod.draw_ranges.push_back(range);
+	}
+}
+
+// Arrows sit this far above the unit sphere, over the planet mesh.
+static constexpr f32 Arrow_Lift = 1.001f;
+
+void Planet::build_arrow_field() {
+	arrows.level_offset.resize(order + 1);
+	u32 total = 0;
+	for (size_t l = 0; l <= order; l += 1) {
+		arrows.level_offset[l] = total;
+		total += 20u << (2 * l);
+	}
+	arrows.instances.resize(total);
+	arrows.radius.resize(total);
+
+	u32 finest = arrows.level_offset[order];
+	for (size_t i = 0; i < tiles.size(); i += 1) {
+		WorldArrow::Instance& instance = arrows.instances[finest + i];
+		instance.color = Vector3f(1.f, 1.f, 1.f);
+		instance.dir = tiles[i].macro_wind;
+		instance.pos = tiles[i].center * Arrow_Lift;
+		instance.scale = 0.003f;
+		instance.up = normalize(tiles[i].center);
+		arrows.radius[finest + i] = 0;
+	}
+
+	// Children of triangle c are 4c to 4c + 3 on the next level, like the tiles.
+	for (size_t l = order; l-- > 0;) {
+		u32 offset = arrows.level_offset[l];
+		u32 child_offset = arrows.level_offset[l + 1];
+		for (u32 c = 0; c < (20u << (2 * l)); c += 1) {
+			const WorldArrow::Instance* children = &arrows.instances[child_offset + 4 * c];
+			const f32* children_radius = &arrows.radius[child_offset + 4 * c];
+
+			Vector3f center = {};
+			Vector3f wind = {};
+			for (size_t k = 0; k < 4; k += 1) {
+				center = center + children[k].pos;
+				wind = wind + children[k].dir;
+			}
+			Vector3f up = normalize(center);
+			wind = wind * 0.25f;
+
+			WorldArrow::Instance& instance = arrows.instances[offset + c];
+			instance.color = Vector3f(1.f, 1.f, 1.f);
+			instance.dir = wind - up * dot(wind, up);
+			instance.pos = up * Arrow_Lift;
+			instance.scale = children[0].scale * 2.f;
+			instance.up = up;
+
+			f32 r = 0;
+			for (size_t k = 0; k < 4; k += 1)
+				r = std::max(r, children_radius[k] + length(children[k].pos - instance.pos));
+			arrows.radius[offset + c] = r;
+		}
+	}
+
+	arrows.tile_version = tile_version;
+	arrows.needs_upload = true;
+}
+
+void Planet::update_arrows(
+	const Matrix4f& view,
+	const Matrix4f& projection,
+	Vector3f eye,
+	f32 fov,
+	f32 viewport_height
+) {
+	arrows.draw_ranges.clear();
+	arrows.drawn = 0;
+	if (!render_vector_field)
+		return;
+	if (arrows.tile_version != tile_version)
+		build_arrow_field();
+
+	Quaternionf to_local = { -orientation.x, -orientation.y, -orientation.z, orientation.w };
+	Vector3f local_eye = to_local * eye;
+	Frustum frustum = frustum_from_clip(projection * view * mesh.local);
+	f32 pixels_per_unit = viewport_height / (2 * tanf(fov * DEG_RADf / 2));
+
+	// Breadth first down the quadtree, a cell is split while its arrows would be further than
+	// spacing apart and while its children still fit in max_arrows.
+	arrows.open.resize(20);
+	for (u32 c = 0; c < 20; c += 1)
+		arrows.open[c] = c;
+
+	for (size_t l = 0; !arrows.open.empty(); l += 1) {
+		arrows.next.clear();
+		for (size_t k = 0; k < arrows.open.size(); k += 1) {
+			u32 c = arrows.open[k];
+			u32 i = arrows.level_offset[l] + c;
+			const WorldArrow::Instance& instance = arrows.instances[i];
+			f32 radius = arrows.radius[i];
+
+			// The tiles under the cell plus the length of their arrows.
+			Chunk_Bounds bounds;
+			bounds.center = instance.pos;
+			bounds.radius = radius + 2 * instance.scale * length(instance.dir);
+			bounds.axis = instance.up;
+			bounds.cone_angle = 2 * asinf(std::min(1.f, bounds.radius * 0.5f));
+			if (cull_chunk(bounds, frustum, local_eye, 1.f / Arrow_Lift) != Chunk_Cull::Visible)
+				continue;
+
+			f32 distance = std::max(length(local_eye - instance.pos) - radius, 1e-4f);
+			f32 spacing = 2 * radius / distance * pixels_per_unit;
+			usz pending = arrows.drawn + arrows.next.size() + (arrows.open.size() - k);
+			if (l < order && spacing > arrows.spacing && pending + 3 <= arrows.max_arrows) {
+				for (u32 child = 0; child < 4; child += 1)
+					arrows.next.push_back(4 * c + child);
+				continue;
+			}
+
+			arrows.drawn += 1;
+			if (!arrows.draw_ranges.empty()) {
+				WorldArrow::Range& last = arrows.draw_ranges.back();
+				if (last.first + last.count == i) {
+					last.count += 1;
+					continue;
+				}
+			}
+			arrows.draw_ranges.push_back({ i, 1 });
+		}
+		std::swap(arrows.open, arrows.next);
+	}
+}
+
 void Planet::upload(SDL_GPUDevice* gpu, std::vector<SDL_GPUFence*>& fences) {
 	if (render_vector_field) {
 		if (!vector_field.vertex_buffer)
 			vector_field.upload(gpu, fences);
-		switch (overlay_render) {
-			case Overlay_Render::MacroWind: {
-				std::vector<WorldArrow::Instance> instances;
-				instances.resize(tiles.size());
-				for (size_t i = 0; i < tiles.size(); i += 1)
-				{
-					WorldArrow::Instance& instance = instances[i];
-					instance.color = Vector3f(1.f, 1.f, 1.f);
-					instance.dir = tiles[i].macro_wind;
-					instance.pos = tiles[i].center * 1.001f;
-					instance.scale = 0.003f;
-					instance.up = normalize(tiles[i].center);
-				}
-				vector_field.set_instances(gpu, instances.data(), instances.size(), fences);
-				break;
-			}
-			case Overlay_Render::None:
-			case Overlay_Render::Height:
-			case Overlay_Render::WaterDistance:
-			case Overlay_Render::TectonicPlates:
-			case Overlay_Render::Temperature:
-			case Overlay_Render::Pressure:
-			case Overlay_Render::WindStepToMoutain:
-			case Overlay_Render::Humidity:
-			case Overlay_Render::HeatQuantity:
-			case Overlay_Render::Count:
-				break;
+		if (arrows.needs_upload) {
+			vector_field.set_instances(
+				gpu, arrows.instances.data(), arrows.instances.size(), fences
+			);
+			arrows.needs_upload = false;
+		}
+		vector_field.ranges = arrows.draw_ranges;
+	}
+	if (lod.enabled) {
+		if (lod.needs_upload) {
+			lod.mesh.reserve(gpu, lod.mesh.packed.size());
+			lod.mesh.upload(gpu, fences);
+			lod.needs_upload = false;
 		}
+	} else {
+		mesh.pack();
+		mesh.upload(gpu, fences);
 	}
-	mesh.upload(gpu, fences);
 }
 
 void Planet::render(SDL_GPURenderPass* pass, SDL_GPUCommandBuffer* command) {
 
+	const Mesh& drawn = lod.enabled ? lod.mesh : mesh;
+
 	SDL_BindGPUGraphicsPipeline(pass, mesh.pipeline);
 	SDL_BindGPUVertexBuffers(pass, 0, &(SDL_GPUBufferBinding) {
-		.buffer = mesh.gpu_vertex_buffer,
+		.buffer = drawn.gpu_vertex_buffer,
 		.offset = 0
 	}, 1);
 
@@ -1088,7 +1568,16 @@ void Planet::render(SDL_GPURenderPass* pass, SDL_GPUCommandBuffer* command) {
 	SDL_PushGPUVertexUniformData(command, 1, &uniform, sizeof(uniform));
 	SDL_PushGPUFragmentUniformData(command, 1, &uniform, sizeof(uniform));
 
-	SDL_DrawGPUPrimitives(pass, mesh.vertices.size(), 1, 0, 0);
+	SDL_PushGPUVertexUniformData(
+		command, 2, lod.quantization.data(), lod.quantization.size() * sizeof(Vector4f)
+	);
+
+	if (lod.enabled) {
+		for (const Lod::Range& range : lod.draw_ranges)
+			SDL_DrawGPUPrimitives(pass, range.count, 1, range.first, 0);
+	} else {
+		SDL_DrawGPUPrimitives(pass, mesh.vertices.size(), 1, 0, 0);
+	}
 
 	if (render_vector_field)
 	{
@@ -1223,50 +1712,144 @@ void Planet::categorize_tiles() {
 	}
 }
 
-void Planet::final_categorize_tiles() {
-	for (size_t i = 0; i < tiles.size(); i += 1) {
-		Tile& tile = tiles[i];
+Planet::Biome_Thresholds Planet::get_biome_thresholds() const {
+	Biome_Thresholds thresholds;
+	thresholds.min_temp_desert = min_temp_desert;
+	thresholds.max_temp_tundra = max_temp_tundra;
+	thresholds.humidity_desert = humidity_desert;
+	thresholds.humidity_steppe = humidity_steppe;
+	thresholds.humidity_rainforest = humidity_rainforest;
+	thresholds.snow_peak_factor = snow_peak_factor;
+	thresholds.max_ice_temp = max_ice_temp;
+	thresholds.max_snow_temp = max_snow_temp;
+	return thresholds;
+}
 
-		if (tile.kind == Tile::Kind::DEEP_OCEAN){
-			if (tile.year_temperature < max_ice_temp) {
-				tile.kind = Tile::Kind::SNOW;
-			}
-			continue;
-		}
-		if (tile.kind == Tile::Kind::SHALLOW_OCEAN)
-		{
-			if (tile.year_temperature < max_snow_temp) {
-				tile.kind = Tile::Kind::ICE;
-			}
-			continue;
+static Tile::Kind classify_biome(
+	Tile::Kind kind, const Tile& tile, const Planet::Biome_Thresholds& thresholds
+) {
+	if (kind == Tile::Kind::DEEP_OCEAN){
+		if (tile.year_temperature < thresholds.max_ice_temp) {
+			return Tile::Kind::SNOW;
 		}
-		if (tile.year_temperature < max_snow_temp) {
-			tile.kind = Tile::Kind::SNOW;
-			continue;
+		return kind;
+	}
+	if (kind == Tile::Kind::SHALLOW_OCEAN)
+	{
+		if (tile.year_temperature < thresholds.max_snow_temp) {
+			return Tile::Kind::ICE;
 		}
-		if (tile.kind == Tile::Kind::BEACH)
-			continue;
-		if (tile.kind == Tile::Kind::PEAK)
-		{
-			if (tile.height * snow_peak_factor > tile.year_temperature)
-				tile.kind = Tile::Kind::SNOW_PEAK;
-			continue;
+		return kind;
+	}
+	if (tile.year_temperature < thresholds.max_snow_temp) {
+		return Tile::Kind::SNOW;
+	}
+	if (kind == Tile::Kind::BEACH)
+		return kind;
+	if (kind == Tile::Kind::PEAK)
+	{
+		if (tile.height * thresholds.snow_peak_factor > tile.year_temperature)
+			return Tile::Kind::SNOW_PEAK;
+		return kind;
+	}
+
+	if (tile.humidity < thresholds.humidity_desert) {
+		if (tile.year_temperature > thresholds.min_temp_desert) {
+			return Tile::Kind::DESERT;
+		} else if (tile.year_temperature < thresholds.max_temp_tundra) {
+			return Tile::Kind::TUNDRA;
 		}
+	}
+	else if (tile.humidity < thresholds.humidity_steppe) {
+		return Tile::Kind::STEPPE;
+	}
+	else if (tile.humidity > thresholds.humidity_rainforest) {
+		return Tile::Kind::RAIN_FOREST;
+	}
+	return kind;
+}
+
+void Planet::final_categorize_tiles() {
+	Biome_Thresholds thresholds = get_biome_thresholds();
+	for (size_t i = 0; i < tiles.size(); i += 1) {
+		tiles[i].kind = classify_biome(tiles[i].kind, tiles[i], thresholds);
+	}
+}
+
+void Planet::recategorize_tiles() {
+	Biome_Thresholds next = get_biome_thresholds();
+	tile_version += 1;
+
+	if (!biome_index.valid) {
+		auto by_feature = [&] (std::vector<Biome_Index::Entry>& sorted) {
+			std::sort(std::begin(sorted), std::end(sorted), [] (const auto& a, const auto& b) {
+				return a.feature < b.feature;
+			});
+		};
 
-		if (tile.humidity < humidity_desert) {
-			if (tile.year_temperature > min_temp_desert) {
-				tile.kind = Tile::Kind::DESERT;
-			} else if (tile.year_temperature < max_temp_tundra) {
-				tile.kind = Tile::Kind::TUNDRA;
+		biome_index.by_temperature.resize(tiles.size());
+		biome_index.by_humidity.resize(tiles.size());
+		biome_index.by_peak_ratio.clear();
+		for (size_t i = 0; i < tiles.size(); i += 1) {
+			biome_index.by_temperature[i] = { tiles[i].year_temperature, (u32)i };
+			biome_index.by_humidity[i] = { tiles[i].humidity, (u32)i };
+
+			// height * factor > temperature flips exactly when factor crosses temperature / height.
+			if (biome_index.base_kind[i] == Tile::Kind::PEAK && tiles[i].height != 0) {
+				biome_index.by_peak_ratio.push_back({
+					tiles[i].year_temperature / tiles[i].height, (u32)i
+				});
 			}
 		}
-		else if (tile.humidity < humidity_steppe) {
-			tile.kind = Tile::Kind::STEPPE;
-		}
-		else if (tile.humidity > humidity_rainforest) {
-			tile.kind = Tile::Kind::RAIN_FOREST;
+		by_feature(biome_index.by_temperature);
+		by_feature(biome_index.by_humidity);
+		by_feature(biome_index.by_peak_ratio);
+
+		for (size_t i = 0; i < tiles.size(); i += 1) {
+			tiles[i].kind = classify_biome(biome_index.base_kind[i], tiles[i], next);
 		}
+
+		biome_index.thresholds = next;
+		biome_index.valid = true;
+		return;
 	}
+
+	// A tile can only change biome if one of its features is between the old and new value of a
+	// threshold, so we only revisit those ranges of the sorted features.
+	auto revisit = [&] (const std::vector<Biome_Index::Entry>& sorted, f32 a, f32 b) {
+		if (a == b)
+			return;
+		if (a > b)
+			std::swap(a, b);
+
+		auto first = std::lower_bound(
+			std::begin(sorted), std::end(sorted), a, [] (const auto& e, f32 x) {
+				return e.feature < x;
+			}
+		);
+		auto last = std::upper_bound(
+			first, std::end(sorted), b, [] (f32 x, const auto& e) {
+				return x < e.feature;
+			}
+		);
+		for (auto it = first; it != last; ++it) {
+			tiles[it->tile].kind = classify_biome(
+				biome_index.base_kind[it->tile], tiles[it->tile], next
+			);
+		}
+	};
+
+	const Biome_Thresholds& prev = biome_index.thresholds;
+	revisit(biome_index.by_temperature, prev.max_ice_temp, next.max_ice_temp);
+	revisit(biome_index.by_temperature, prev.max_snow_temp, next.max_snow_temp);
+	revisit(biome_index.by_temperature, prev.min_temp_desert, next.min_temp_desert);
+	revisit(biome_index.by_temperature, prev.max_temp_tundra, next.max_temp_tundra);
+	revisit(biome_index.by_humidity, prev.humidity_desert, next.humidity_desert);
+	revisit(biome_index.by_humidity, prev.humidity_steppe, next.humidity_steppe);
+	revisit(biome_index.by_humidity, prev.humidity_rainforest, next.humidity_rainforest);
+	revisit(biome_index.by_peak_ratio, prev.snow_peak_factor, next.snow_peak_factor);
+
+	biome_index.thresholds = next;
 }
 
 
@@ -1372,113 +1955,72 @@ void Planet::grow_plates(
 
 	std::vector<f32> fail_lines_dt(tiles.size(), 0);
 
-	// Tweak height on the boundary based on the neighbouring plate divergence.
-	for (size_t i = 0; i < tiles.size(); i += 1) {
-		size_t pi = tiles[i].plate_index;
-		size_t pa = pi;
-		size_t pb = pi;
-		size_t pc = pi;
-
-		if (tiles[i].na != SIZE_MAX) {
-			pa = tiles[tiles[i].na].plate_index;
-		}
-		if (tiles[i].nb != SIZE_MAX) {
-			pb = tiles[tiles[i].nb].plate_index;
-		}
-		if (tiles[i].nc != SIZE_MAX) {
-			pc = tiles[tiles[i].nc].plate_index;
-		}
-
-		Vector3f ca = tiles[i].center;
-		Vector3f cb = tiles[i].center;
-		Vector3f cc = tiles[i].center;
-		Vector3f ci = tiles[i].center;
-		if (tiles[i].na != SIZE_MAX) {
-			ca = tiles[tiles[i].na].center;
-		}
-		if (tiles[i].nb != SIZE_MAX) {
-			cb = tiles[tiles[i].nb].center;
-		}
-		if (tiles[i].nc != SIZE_MAX) {
-			cc = tiles[tiles[i].nc].center;
-		}
-
-		f32 si = plates[pi].speed;
-		Vector3f vi = { std::cosf(plates[pi].angle), std::sinf(plates[pi].angle), 0 };
-		Quaternionf q = Quaternionf::from_unit_vectors({0, 0, 1}, normalize(ci));
-		vi = q * vi;
-		
-		Vector3f va = vi;
-		f32 sa = plates[pa].speed;
-		if (tiles[i].na != SIZE_MAX) {
-			va = { std::cosf(plates[pa].angle), std::sinf(plates[pa].angle), 0 };
-			q = Quaternionf::from_unit_vectors({0, 0, 1}, normalize(ca));
-			va = q * va;
-		}
-
-		Vector3f vb = vi;
-		f32 sb = plates[pb].speed;
-		if (tiles[i].nb != SIZE_MAX) {
-			vb = { std::cosf(plates[pb].angle), std::sinf(plates[pb].angle), 0 };
-			q = Quaternionf::from_unit_vectors({0, 0, 1}, normalize(cb));
-			vb = q * vb;
-		}
+	fill_plate_velocity();
 
-		Vector3f vc = vi;
-		f32 sc = plates[pc].speed;
-		if (tiles[i].nc != SIZE_MAX) {
-			vc = { std::cosf(plates[pc].angle), std::sinf(plates[pc].angle), 0 };
-			q = Quaternionf::from_unit_vectors({0, 0, 1}, normalize(cc));
-			vc = q * vc;
-		}
+	// Tweak height on the boundary based on the neighbouring plate divergence.
+	std::vector<f32> plate_divergence(tiles.size());
+	std::vector<f32> neighbour_speed(tiles.size());
+	divergence(graph, plate_velocities.data(), plate_divergence.data());
+	mean_of_neighbours(graph, plate_speeds.data(), neighbour_speed.data());
 
-		Vector3f da = normalize(ca - ci);
-		Vector3f db = normalize(cb - ci);
-		Vector3f dc = normalize(cc - ci);
+	for (size_t i = 0; i < tiles.size(); i += 1) {
+		f32 speed = 3 * (plate_speeds[i] + neighbour_speed[i]);
 
-		f32 div = 0;
-		div += (si * dot(vi, da) - sa * dot(va, da));
-		div += (si * dot(vi, db) - sb * dot(vb, db));
-		div += (si * dot(vi, dc) - sc * dot(vc, dc));
-		div /= std::max(3 * si + sa + sb + sc, 0.1f);
+		f32 div = -plate_divergence[i];
+		div /= std::max(speed, 0.1f);
 
 		div *= std::abs(div * div);
 
-		div *= (3 * si + sa + sb + sc);
+		div *= speed;
 		if (div > 0)
 			fail_lines_dt[i] = tiles[i].height * +div;
 		else
 			fail_lines_dt[i] = tiles[i].height * -div;
 	}
 
-	// Smooth out the fail_lines
-	for (size_t i = 0; i < fail_smooth; i += 1) {
-		std::vector<f32> new_fail_lines = fail_lines_dt;
+	// Smooth out the fail_lines, every tile spreads a third of fail_smooth_factor of its value to
+	// each neighbour. The adjacency is symmetric so we can gather instead of scatter.
+	diffuse(graph, fail_lines_dt.data(), fail_smooth, 1.f, fail_smooth_factor);
 
-		for (size_t j = 0; j < tiles.size(); j += 1) {
-			size_t a = tiles[j].na;
-			size_t b = tiles[j].nb;
-			size_t c = tiles[j].nc;
+	for (size_t i = 0; i < tiles.size(); i += 1) {
+		tiles[i].height += fail_lines_dt[i];
+	}
+}
 
-			f32 to_spread = fail_lines_dt[j] * fail_smooth_factor;
+void Planet::fill_plate_velocity() {
+	std::vector<Vector2f> plate_directions(plates.size());
+	for (size_t i = 0; i < plates.size(); i += 1) {
+		plate_directions[i] = { std::cosf(plates[i].angle), std::sinf(plates[i].angle) };
+	}
 
-			if (a != SIZE_MAX) {
-				new_fail_lines[a] += to_spread / 3;
-			}
-			if (b != SIZE_MAX) {
-				new_fail_lines[b] += to_spread / 3;
+	plate_velocities.resize(tiles.size());
+	plate_speeds.resize(tiles.size());
+
+	// The plate moves along its (cos, sin, 0) direction expressed in the tangent frame obtained by
+	// the shortest rotation from +z to the tile normal. That rotation is written out in closed
+	// form so the loop has no trig and no quaternion.
+	parallel_for(tiles.size(), 16 * 1024, [&] (size_t begin, size_t end) {
+		for (size_t i = begin; i < end; i += 1) {
+			const Tile& tile = tiles[i];
+			Vector2f d = plate_directions[tile.plate_index];
+			f32 speed = plates[tile.plate_index].speed;
+			Vector3f n = normalize(tile.center);
+
+			Vector3f v;
+			if (n.z > -0.999999f) {
+				f32 k = 1 / (1 + n.z);
+				v.x = d.x * (1 - n.x * n.x * k) - d.y * n.x * n.y * k;
+				v.y = d.y * (1 - n.y * n.y * k) - d.x * n.x * n.y * k;
+				v.z = -(d.x * n.x + d.y * n.y);
+			} else {
+				Quaternionf q = Quaternionf::from_unit_vectors({0, 0, 1}, n);
+				v = q * Vector3f(d.x, d.y, 0);
 			}
-			if (c != SIZE_MAX) {
-				new_fail_lines[c] += to_spread / 3;
-			}
-		}
 
-		fail_lines_dt = new_fail_lines;
-	}
-
-	for (size_t i = 0; i < tiles.size(); i += 1) {
-		tiles[i].height += fail_lines_dt[i];
-	}
+			plate_velocities[i] = v * speed;
+			plate_speeds[i] = speed;
+		}
+	});
 }
 
 Vector3f Planet::get_rotation_axis()
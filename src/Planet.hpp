@@ -6,6 +6,11 @@
 #include "SDL3/SDL.h"
 #include "Random.hpp"
 #include "Graphics.hpp"
+#include "Noise.hpp"
+#include "HeightCache.hpp"
+#include "Chunk.hpp"
+#include "PackedVertex.hpp"
+#include "Stencil.hpp"
 #include "SDL3/SDL_gpu.h"
 
 #include <vector>
@@ -65,6 +70,8 @@ struct Planet {
 		};
 
 		std::vector<Vertex> vertices;
+		// What upload sends, see Packed_Vertex.
+		std::vector<Packed_Vertex> packed;
 
 		SDL_GPUBuffer* gpu_vertex_buffer = nullptr;
 		SDL_GPUTransferBuffer* gpu_transfer_buffer = nullptr;
@@ -72,8 +79,14 @@ struct Planet {
 
 		SDL_GPUGraphicsPipeline* pipeline = nullptr;
 
+		// Vertices the gpu buffers can hold, only grown by reserve.
+		usz gpu_capacity = 0;
+
+		void reserve(SDL_GPUDevice* gpu, usz count);
+		// Packs every vertex into quantization slot 0, the unit sphere.
+		void pack();
 		void upload(SDL_GPUDevice* gpu, std::vector<SDL_GPUFence*>& fences);
-		bool create_pipeline(SDL_GPUDevice* gpu, SDL_GPUTextureFormat format);
+		bool create_pipeline(SDL_GPUDevice* gpu, const Render_Settings& settings);
 
 		void release(SDL_GPUDevice* gpu);
 	};
@@ -89,6 +102,12 @@ struct Planet {
 		size_t plate_fail_smooth = 9;
 		f32 plate_fail_smooth_factor = 0.65f;
 		f32 average_temperature = 20.f;
+		Noise_Basis noise_basis = Noise_Basis::Perlin;
+		// Face resolution of the baked height cube map, 0 evaluates the noise for every tile.
+		// Off by default, every slider step would bake a cube for a key used once.
+		u32 height_cache_resolution = 0;
+		// Use the FastMath approximations in the climate passes instead of libm.
+		bool fast_math = false;
 	};
 
 	struct Uniform {
@@ -101,7 +120,21 @@ struct Planet {
 	Uniform uniform;
 	Common_Uniform common_uniform;
 	std::vector<Tile> tiles;
+	Tile_Graph graph;
+	Height_Cube height_cube;
 	std::vector<Plate> plates;
+	std::vector<Vector3f> plate_velocities; // per tile, tangent velocity of its plate
+	std::vector<f32> plate_speeds; // per tile, speed of its plate
+
+	// Per tile position relative to the rotation axis, only depends on the tiles and the tilt.
+	struct Geo_Field {
+		std::vector<f32> sin_latitude;
+		std::vector<f32> cos_latitude;
+		std::vector<f32> cos_longitude;
+
+		f32 axial_tilt = 0.f;
+		bool valid = false;
+	} geo;
 
 	f32 min_height = +FLT_MAX;
 	f32 max_height = -FLT_MAX;
@@ -129,6 +162,8 @@ struct Planet {
 
 	size_t order = 6;
 	Generation_Param generation_param;
+	// Bumped whenever the tiles or their kinds change.
+	u64 tile_version = 0;
 
 	f32 time = 0.0f;
 	f32 time_day = 0.0f;
@@ -158,23 +193,143 @@ struct Planet {
 	f32 max_ice_temp = 25.f;
 	f32 max_snow_temp = 28.f;
 
+	struct Biome_Thresholds {
+		f32 min_temp_desert;
+		f32 max_temp_tundra;
+		f32 humidity_desert;
+		f32 humidity_steppe;
+		f32 humidity_rainforest;
+		f32 snow_peak_factor;
+		f32 max_ice_temp;
+		f32 max_snow_temp;
+	};
+
+	// Kinds before the biome pass and every tile sorted by the features the biome thresholds are
+	// compared against, so moving a threshold only revisits the tiles that cross it.
+	struct Biome_Index {
+		struct Entry {
+			f32 feature;
+			u32 tile;
+		};
+
+		std::vector<Tile::Kind> base_kind;
+		std::vector<Entry> by_temperature;
+		std::vector<Entry> by_humidity;
+		std::vector<Entry> by_peak_ratio;
+
+		Biome_Thresholds thresholds;
+		bool valid = false;
+	} biome_index;
+
+	// Render mesh made of quadtree chunks picked every frame from the camera. The simulation keeps
+	// its tiles on the order mesh, chunk triangles take the color of the tile they lie in.
+	// The vertex buffer holds every selected chunk and is only rebuilt when the selection or the
+	// tiles change, culling then picks the ranges to draw every frame.
+	struct Lod {
+		struct Range {
+			u32 first;
+			u32 count;
+		};
+
+		struct Stats {
+			usz chunks = 0;
+			usz frustum_culled = 0;
+			usz horizon_culled = 0;
+			usz visible_triangles = 0;
+		};
+
+		Chunk_Lod_Param param;
+		Chunk_Cache cache;
+		std::vector<Chunk_Key> selected;
+		std::vector<Vector3f> tile_corners;
+
+		// Chunks in mesh.packed, in the same order, chunk i is quantized in slot i + 1.
+		std::vector<u64> assembled;
+		std::vector<Chunk_Bounds> bounds;
+		std::vector<Range> chunk_ranges;
+		u64 assembled_tile_version = UINT64_MAX;
+		Overlay_Render assembled_overlay = Overlay_Render::Count;
+		f32 occluder_radius = 1.f;
+		bool needs_upload = false;
+
+		std::vector<Range> draw_ranges;
+		Stats stats;
+		// (center, scale) of every quantization slot, pushed whole to planet.vert.
+		std::vector<Vector4f> quantization =
+			std::vector<Vector4f>(Max_Quantization_Slots, Vector4f(0, 0, 0, 1));
+		bool culling = true;
+
+		Mesh mesh;
+		bool enabled = true;
+	} lod;
+
+	// Arrows of the MacroWind overlay. Level l holds one arrow per triangle of the order l mesh,
+	// averaging the tiles under it, so the levels form the same quadtree as the tiles. Every
+	// level sits in the instance buffer, uploaded once per tile_version, and each frame draws a
+	// cut of the quadtree where the arrows are about spacing pixels apart.
+	struct Arrow_Field {
+		std::vector<WorldArrow::Instance> instances;
+		// Radius around the arrow of the tile centers under it.
+		std::vector<f32> radius;
+		// First instance of every level, coarsest first.
+		std::vector<u32> level_offset;
+		u64 tile_version = UINT64_MAX;
+		bool needs_upload = false;
+
+		f32 spacing = 32.f;
+		usz max_arrows = 16384;
+
+		std::vector<WorldArrow::Range> draw_ranges;
+		usz drawn = 0;
+		std::vector<u32> open;
+		std::vector<u32> next;
+	} arrows;
+
 	bool render_vector_field = false;
 
 	Planet();
 
 	void release(SDL_GPUDevice* gpu);
-	void create_pipeline(SDL_GPUDevice* gpu, SDL_GPUTextureFormat format);
+	void create_pipeline(SDL_GPUDevice* gpu, const Render_Settings& settings);
 
 	void upload(SDL_GPUDevice* gpu, std::vector<SDL_GPUFence*>& fences);
 	void update(f32 dt);
+	// eye is the camera position relative to the planet center, in world orientation, view and
+	// projection are the ones the frame is rendered with.
+	void update_lod(
+		const Matrix4f& view,
+		const Matrix4f& projection,
+		Vector3f eye,
+		f32 fov,
+		f32 viewport_height
+	);
+	// Same arguments as update_lod.
+	void update_arrows(
+		const Matrix4f& view,
+		const Matrix4f& projection,
+		Vector3f eye,
+		f32 fov,
+		f32 viewport_height
+	);
+	void build_arrow_field();
 	void render(SDL_GPURenderPass* pass, SDL_GPUCommandBuffer* command);
 	void imgui(SDL_GPUDevice* gpu);
 
 	void generate_icosphere(SDL_GPUDevice* gpu, size_t order);
 
 	void generate_from_mesh(const Generation_Param& param);
-
-	void fill_height(size_t octave, f32 roughness, f32 lacunarity);
+	// The height cube generate_from_mesh prepares, resolution 0 if it evaluates the noise instead.
+	static Height_Cache_Key height_cache_key(const Generation_Param& param);
+
+	void fill_height(
+		Noise_Basis basis, size_t octave, f32 roughness, f32 lacunarity, u32 cache_resolution
+	);
+	void fill_geo_field();
+	// Same result as fill_year_temperature, fill_base_pressure then fill_macro_wind, in two sweeps.
+	void fill_climate();
+	// Runs the separate passes then fill_climate on the same tiles, returns how many tiles do not
+	// have the same bits in every climate field. The tiles are left as fill_climate makes them.
+	size_t check_climate();
 	void fill_year_temperature();
 	void fill_base_pressure();
 	void fill_macro_wind();
@@ -182,8 +337,11 @@ struct Planet {
 	void find_water(f32 water_level, f32 peak_level);
 	void fill_humidity();
 	void grow_plates(size_t n_plates, f32 plate_speed, size_t fail_smooth, f32 fail_smooth_factor);
+	void fill_plate_velocity();
 	void categorize_tiles();
 	void final_categorize_tiles();
+	void recategorize_tiles();
+	Biome_Thresholds get_biome_thresholds() const;
 
 	Vector3f get_rotation_axis();
 	Vector3f get_zero_longitude_axis();
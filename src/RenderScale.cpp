@@ -0,0 +1,43 @@
+#include "RenderScale.hpp"
+
+#include <algorithm>
+#include <math.h>
+
+bool Render_Scale::update(f32 frame_ms) {
+	if (!dynamic)
+		return false;
+
+	if (smoothed_ms <= 0.f)
+		smoothed_ms = frame_ms;
+	else
+		smoothed_ms += (frame_ms - smoothed_ms) * smoothing;
+
+	if (wait > 0) {
+		wait -= 1;
+		return false;
+	}
+
+	f32 ratio = target_ms / std::max(smoothed_ms, 1e-3f);
+	if (ratio > 1.f - band && ratio < 1.f + band)
+		return false;
+
+	// As if the scaled passes were the whole frame, their cost goes with the pixel count. When
+	// they are not the step falls short and the next updates finish the job.
+	f32 wanted = roundf(scale * sqrtf(ratio) / step) * step;
+	if (ratio < 1.f)
+		wanted = std::min(wanted, scale - step);
+	else
+		wanted = std::max(wanted, scale + step);
+	wanted = std::clamp(wanted, min_scale, max_scale);
+	if (wanted == scale)
+		return false;
+
+	scale = wanted;
+	wait = settle_frames;
+	smoothed_ms = 0.f;
+	return true;
+}
+
+u32 Render_Scale::apply(u32 size) const {
+	return std::max<u32>((u32)ceilf((f32)size * scale), 1);
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+#include "Common.hpp"
+
+// Fraction of the window the scaled passes render at, driven by the frame time. Knows nothing
+// of the gpu, the caller feeds it frame times and rebuilds its targets when update says so.
+struct Render_Scale {
+	f32 scale = 1.f;
+	f32 min_scale = 0.25f;
+	f32 max_scale = 1.f;
+	// Scales are multiples of step, the targets are not rebuilt for every small variation.
+	f32 step = 1.f / 16.f;
+
+	bool dynamic = false;
+	f32 target_ms = 1000.f / 60.f;
+	// Nothing changes while the smoothed frame time is within target_ms * (1 +- band).
+	f32 band = 0.1f;
+	// Weight of the newest frame in the moving average.
+	f32 smoothing = 0.1f;
+	// Frames ignored after a change, while the rebuilt targets and the frames in flight settle.
+	u32 settle_frames = 20;
+
+	f32 smoothed_ms = 0.f;
+	u32 wait = 0;
+
+	// Feeds the duration of the last frame, true when scale changed.
+	bool update(f32 frame_ms);
+	// size scaled and rounded up, at least 1.
+	u32 apply(u32 size) const;
+};
@@ -0,0 +1,154 @@
+#include "RenderSettings.hpp"
+
+#include "imgui/imgui.h"
+
+#include <stdio.h>
+
+struct Format_Choice {
+	SDL_GPUTextureFormat format;
+	const char* name;
+};
+
+static const Format_Choice Color_Formats[] = {
+	{ SDL_GPU_TEXTUREFORMAT_R32G32B32A32_FLOAT, "RGBA32F" },
+	{ SDL_GPU_TEXTUREFORMAT_R16G16B16A16_FLOAT, "RGBA16F" },
+	{ SDL_GPU_TEXTUREFORMAT_R11G11B10_UFLOAT, "R11G11B10F" },
+};
+static const Format_Choice Depth_Formats[] = {
+	{ SDL_GPU_TEXTUREFORMAT_D32_FLOAT, "D32F" },
+	{ SDL_GPU_TEXTUREFORMAT_D24_UNORM, "D24" },
+	{ SDL_GPU_TEXTUREFORMAT_D16_UNORM, "D16" },
+};
+// R11G11B10 has no alpha to hold the guide.
+static const Format_Choice Scaled_Formats[] = {
+	{ SDL_GPU_TEXTUREFORMAT_R32G32B32A32_FLOAT, "RGBA32F" },
+	{ SDL_GPU_TEXTUREFORMAT_R16G16B16A16_FLOAT, "RGBA16F" },
+};
+static const SDL_GPUSampleCount Sample_Counts[] = {
+	SDL_GPU_SAMPLECOUNT_1, SDL_GPU_SAMPLECOUNT_2, SDL_GPU_SAMPLECOUNT_4, SDL_GPU_SAMPLECOUNT_8,
+};
+
+u32 texel_bytes(SDL_GPUTextureFormat format) {
+	switch (format) {
+	case SDL_GPU_TEXTUREFORMAT_R32G32B32A32_FLOAT: return 16;
+	case SDL_GPU_TEXTUREFORMAT_R16G16B16A16_FLOAT: return 8;
+	case SDL_GPU_TEXTUREFORMAT_R11G11B10_UFLOAT: return 4;
+	case SDL_GPU_TEXTUREFORMAT_D32_FLOAT: return 4;
+	// Padded to 4 bytes by every driver that has it.
+	case SDL_GPU_TEXTUREFORMAT_D24_UNORM: return 4;
+	case SDL_GPU_TEXTUREFORMAT_D16_UNORM: return 2;
+	default: return 0;
+	}
+}
+
+u32 sample_count_value(SDL_GPUSampleCount count) {
+	switch (count) {
+	case SDL_GPU_SAMPLECOUNT_2: return 2;
+	case SDL_GPU_SAMPLECOUNT_4: return 4;
+	case SDL_GPU_SAMPLECOUNT_8: return 8;
+	default: return 1;
+	}
+}
+
+Render_Target_Memory render_target_memory(
+	const Render_Settings& settings, u32 width, u32 height, u32 scaled_width, u32 scaled_height
+) {
+	u64 pixels = (u64)width * height;
+	u64 samples = sample_count_value(settings.sample_count);
+
+	// With one sample the scene draws straight into the resolve texture.
+	Render_Target_Memory memory;
+	if (samples > 1)
+		memory.color = pixels * samples * texel_bytes(settings.color_format);
+	memory.depth = pixels * samples * texel_bytes(settings.depth_format);
+	memory.resolve = pixels * texel_bytes(settings.color_format);
+	memory.scaled = (u64)scaled_width * scaled_height * texel_bytes(settings.scaled_format);
+	return memory;
+}
+
+static bool format_combo(
+	SDL_GPUDevice* gpu,
+	const char* label,
+	SDL_GPUTextureFormat& format,
+	const Format_Choice* choices,
+	usz n,
+	SDL_GPUTextureUsageFlags usage
+) {
+	const char* preview = "?";
+	for (usz i = 0; i < n; i += 1) {
+		if (choices[i].format == format)
+			preview = choices[i].name;
+	}
+
+	bool changed = false;
+	if (ImGui::BeginCombo(label, preview)) {
+		for (usz i = 0; i < n; i += 1) {
+			SDL_GPUTextureFormat choice = choices[i].format;
+			if (!SDL_GPUTextureSupportsFormat(gpu, choice, SDL_GPU_TEXTURETYPE_2D, usage))
+				continue;
+			if (ImGui::Selectable(choices[i].name, choices[i].format == format)) {
+				changed = choices[i].format != format;
+				format = choices[i].format;
+			}
+		}
+		ImGui::EndCombo();
+	}
+	return changed;
+}
+
+bool render_settings_imgui(SDL_GPUDevice* gpu, Render_Settings& settings) {
+	bool changed = false;
+	changed |= format_combo(
+		gpu,
+		"Color",
+		settings.color_format,
+		Color_Formats,
+		sizeof(Color_Formats) / sizeof(*Color_Formats),
+		SDL_GPU_TEXTUREUSAGE_COLOR_TARGET | SDL_GPU_TEXTUREUSAGE_SAMPLER
+	);
+	changed |= format_combo(
+		gpu,
+		"Depth",
+		settings.depth_format,
+		Depth_Formats,
+		sizeof(Depth_Formats) / sizeof(*Depth_Formats),
+		SDL_GPU_TEXTUREUSAGE_DEPTH_STENCIL_TARGET
+	);
+	changed |= format_combo(
+		gpu,
+		"Atmosphere",
+		settings.scaled_format,
+		Scaled_Formats,
+		sizeof(Scaled_Formats) / sizeof(*Scaled_Formats),
+		SDL_GPU_TEXTUREUSAGE_COLOR_TARGET | SDL_GPU_TEXTUREUSAGE_SAMPLER
+	);
+
+	// Both the color and the depth formats have to support the count.
+	auto supported = [&] (SDL_GPUSampleCount count) {
+		return
+			SDL_GPUTextureSupportsSampleCount(gpu, settings.color_format, count) &&
+			SDL_GPUTextureSupportsSampleCount(gpu, settings.depth_format, count);
+	};
+	if (!supported(settings.sample_count)) {
+		settings.sample_count = SDL_GPU_SAMPLECOUNT_1;
+		changed = true;
+	}
+
+	char preview[16];
+	snprintf(preview, sizeof(preview), "%ux", sample_count_value(settings.sample_count));
+	if (ImGui::BeginCombo("MSAA", preview)) {
+		for (SDL_GPUSampleCount count : Sample_Counts) {
+			if (!supported(count))
+				continue;
+
+			char name[16];
+			snprintf(name, sizeof(name), "%ux", sample_count_value(count));
+			if (ImGui::Selectable(name, count == settings.sample_count)) {
+				changed |= count != settings.sample_count;
+				settings.sample_count = count;
+			}
+		}
+		ImGui::EndCombo();
+	}
+	return changed;
+}
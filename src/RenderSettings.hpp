@@ -0,0 +1,38 @@
+#pragma once
+
+#include "Common.hpp"
+#include "SDL3/SDL_gpu.h"
+
+// Formats and sample count of the render targets, the targets and every pipeline drawing into
+// them are created from the same settings.
+struct Render_Settings {
+	// The scene: cosmos, planet, arrows and the upsampled atmosphere. The resolve texture has the
+	// same format.
+	SDL_GPUTextureFormat color_format = SDL_GPU_TEXTUREFORMAT_R32G32B32A32_FLOAT;
+	SDL_GPUTextureFormat depth_format = SDL_GPU_TEXTUREFORMAT_D32_FLOAT;
+	SDL_GPUSampleCount sample_count = SDL_GPU_SAMPLECOUNT_8;
+	// The atmosphere at render scale, its alpha holds the guide of the upsample.
+	SDL_GPUTextureFormat scaled_format = SDL_GPU_TEXTUREFORMAT_R16G16B16A16_FLOAT;
+
+	bool operator==(const Render_Settings& other) const = default;
+};
+
+// Bytes of every render target of Main for a window and a render scaled size.
+struct Render_Target_Memory {
+	u64 color = 0; // multisampled, none with a single sample
+	u64 depth = 0;
+	u64 resolve = 0;
+	u64 scaled = 0;
+
+	u64 total() const { return color + depth + resolve + scaled; }
+};
+
+// Bytes per texel of the formats Render_Settings offers, 0 for the others.
+extern u32 texel_bytes(SDL_GPUTextureFormat format);
+extern u32 sample_count_value(SDL_GPUSampleCount count);
+extern Render_Target_Memory render_target_memory(
+	const Render_Settings& settings, u32 width, u32 height, u32 scaled_width, u32 scaled_height
+);
+
+// Combos for every field offering what gpu supports for that usage, true when settings changed.
+extern bool render_settings_imgui(SDL_GPUDevice* gpu, Render_Settings& settings);
@@ -0,0 +1,202 @@
+#pragma once
+
+// Shared by Build.cpp and the Reload button of Main, so everything here is inline.
+
+#include "Common.hpp"
+#include "Parallel.hpp"
+
+#include <filesystem>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+// Compiles every src/shaders/*.frag and *.vert into assets/shaders/frag_<name>.spv or
+// vert_<name>.spv with glslc. A shader is only compiled again when the hash of its flags, its
+// source and the files it #includes differs from the one cache/shaders.txt recorded after its
+// last successful compile, or when its output is missing. The stale ones compile in parallel.
+struct Shader_Build_Result {
+	// File names of the sources, like "cosmos.frag".
+	std::vector<std::string> compiled;
+	std::vector<std::string> failed;
+	// Paths of the SPIR-V of compiled, like "assets/shaders/frag_cosmos.spv".
+	std::vector<std::string> outputs;
+	usz up_to_date = 0;
+
+	// Whether a shader of that name, stage aside, was compiled successfully.
+	bool touched(const char* stem) const {
+		for (const std::string& name : compiled) {
+			if (std::filesystem::path(name).stem() == stem)
+				return true;
+		}
+		return false;
+	}
+};
+
+inline constexpr const char* Shader_Manifest_Path = "cache/shaders.txt";
+
+inline bool read_whole_file(const std::filesystem::path& path, std::string& out) {
+	FILE* file = fopen(path.string().c_str(), "rb");
+	if (!file)
+		return false;
+	defer {
+		fclose(file);
+	};
+
+	out.clear();
+	char buffer[4096];
+	for (usz n; (n = fread(buffer, 1, sizeof(buffer), file)) > 0;)
+		out.append(buffer, n);
+	return true;
+}
+
+inline void fnv1a(u64& hash, const void* data, usz size) {
+	const u8* bytes = (const u8*)data;
+	for (usz i = 0; i < size; i += 1) {
+		hash ^= bytes[i];
+		hash *= 1099511628211ull;
+	}
+}
+
+// Hashes the path and the content of path then of every file it includes with
+// #include "file", relative to its directory like glslc resolves them. A missing include
+// hashes as its path alone, glslc will be the one to complain.
+inline void hash_shader_source(
+	const std::filesystem::path& path, u64& hash, std::unordered_set<std::string>& visited
+) {
+	std::string key = path.lexically_normal().generic_string();
+	if (!visited.insert(key).second)
+		return;
+	fnv1a(hash, key.data(), key.size());
+
+	std::string source;
+	if (!read_whole_file(path, source))
+		return;
+	fnv1a(hash, source.data(), source.size());
+
+	for (usz line = 0; line < source.size();) {
+		usz end = source.find('\n', line);
+		if (end == std::string::npos)
+			end = source.size();
+
+		usz i = source.find_first_not_of(" \t", line);
+		const char* directive = "#include";
+		if (i < end && source.compare(i, strlen(directive), directive) == 0) {
+			usz open = source.find('"', i);
+			usz close = open < end ? source.find('"', open + 1) : std::string::npos;
+			if (close < end) {
+				std::string include = source.substr(open + 1, close - open - 1);
+				hash_shader_source(path.parent_path() / include, hash, visited);
+			}
+		}
+		line = end + 1;
+	}
+}
+
+inline Shader_Build_Result build_shaders(const std::string& flags = "") {
+	std::filesystem::path root = std::filesystem::current_path();
+	std::filesystem::path shader_dir = root / "src" / "shaders";
+	std::filesystem::path output_dir = root / "assets" / "shaders";
+
+	// "<output name> <hash>" per line.
+	std::unordered_map<std::string, u64> manifest;
+	std::string text;
+	if (read_whole_file(Shader_Manifest_Path, text)) {
+		char name[256];
+		unsigned long long hash;
+		for (const char* line = text.c_str(); *line;) {
+			if (sscanf(line, "%255s %llx", name, &hash) == 2)
+				manifest[name] = hash;
+			const char* next = strchr(line, '\n');
+			if (!next)
+				break;
+			line = next + 1;
+		}
+	}
+
+	struct Job {
+		std::filesystem::path input;
+		std::string output_name;
+		u64 hash;
+		bool ok;
+	};
+	std::vector<Job> jobs;
+
+	Shader_Build_Result result;
+	std::error_code error;
+	for (const auto& entry : std::filesystem::directory_iterator(shader_dir, error)) {
+		if (!entry.is_regular_file())
+			continue;
+
+		std::string extension = entry.path().extension().generic_string();
+		if (extension != ".frag" && extension != ".vert")
+			continue;
+
+		std::string output_name = extension.substr(1) + "_" +
+			entry.path().filename().replace_extension(".spv").generic_string();
+
+		u64 hash = 14695981039346656037ull;
+		fnv1a(hash, flags.data(), flags.size());
+		std::unordered_set<std::string> visited;
+		hash_shader_source(entry.path(), hash, visited);
+
+		auto it = manifest.find(output_name);
+		std::error_code missing;
+		bool exists = std::filesystem::exists(output_dir / output_name, missing);
+		if (exists && it != manifest.end() && it->second == hash) {
+			result.up_to_date += 1;
+			continue;
+		}
+		jobs.push_back({ entry.path(), output_name, hash, false });
+	}
+	if (error)
+		printf("Failed to list the shaders: %s\n", error.message().c_str());
+
+	// One glslc per job, every worker takes a contiguous range of them.
+	parallel_for(jobs.size(), 1, [&] (usz begin, usz end) {
+		for (usz i = begin; i < end; i += 1) {
+			Job& job = jobs[i];
+			std::string command = "glslc " + flags + " " + job.input.generic_string();
+			command += " -o " + (output_dir / job.output_name).generic_string();
+			printf("Compiling %s\n", command.c_str());
+			job.ok = system(command.c_str()) == 0;
+		}
+	});
+
+	for (const Job& job : jobs) {
+		std::string name = job.input.filename().generic_string();
+		if (job.ok) {
+			manifest[job.output_name] = job.hash;
+			result.compiled.push_back(name);
+			result.outputs.push_back("assets/shaders/" + job.output_name);
+		} else {
+			// Forgotten so the next build tries again.
+			manifest.erase(job.output_name);
+			result.failed.push_back(name);
+		}
+	}
+
+	if (!jobs.empty()) {
+		std::filesystem::path manifest_path = Shader_Manifest_Path;
+		std::filesystem::create_directories(manifest_path.parent_path(), error);
+		FILE* file = fopen(Shader_Manifest_Path, "wb");
+		if (file) {
+			for (const auto& [name, hash] : manifest)
+				fprintf(file, "%s %016llx\n", name.c_str(), (unsigned long long)hash);
+			fclose(file);
+		} else {
+			printf("Failed to write %s\n", Shader_Manifest_Path);
+		}
+	}
+
+	printf(
+		"Shaders: %zu compiled, %zu failed, %zu up to date\n",
+		result.compiled.size(),
+		result.failed.size(),
+		result.up_to_date
+	);
+	return result;
+}
@@ -0,0 +1,103 @@
+#include "ShaderWatcher.hpp"
+
+#include <algorithm>
+#include <chrono>
+
+void Shader_Watcher::start() {
+	if (running())
+		return;
+	stopping = false;
+	write_times.clear();
+	thread = std::thread([this] { loop(); });
+}
+
+void Shader_Watcher::stop() {
+	if (!running())
+		return;
+	{
+		std::lock_guard lock(mutex);
+		stopping = true;
+	}
+	wake.notify_one();
+	thread.join();
+}
+
+void Shader_Watcher::request_build() {
+	{
+		std::lock_guard lock(mutex);
+		requested = true;
+	}
+	wake.notify_one();
+}
+
+Shader_Build_Result Shader_Watcher::take() {
+	std::lock_guard lock(mutex);
+	Shader_Build_Result result = std::move(pending);
+	pending = {};
+	return result;
+}
+
+// The first look counts as a change, the sources may have been edited while nothing watched.
+bool Shader_Watcher::sources_changed() {
+	std::filesystem::path shader_dir = std::filesystem::current_path() / "src" / "shaders";
+
+	bool changed = false;
+	usz seen = 0;
+	std::error_code error;
+	for (const auto& entry : std::filesystem::recursive_directory_iterator(shader_dir, error)) {
+		if (!entry.is_regular_file(error))
+			continue;
+
+		std::filesystem::file_time_type time = entry.last_write_time(error);
+		if (error)
+			continue;
+
+		seen += 1;
+		auto [it, inserted] = write_times.try_emplace(entry.path().generic_string(), time);
+		if (inserted || it->second != time) {
+			it->second = time;
+			changed = true;
+		}
+	}
+
+	// A deleted file.
+	if (seen != write_times.size()) {
+		write_times.clear();
+		changed = true;
+	}
+	return changed;
+}
+
+void Shader_Watcher::loop() {
+	auto interval_duration = std::chrono::duration<f32>(interval);
+
+	std::unique_lock lock(mutex);
+	while (!stopping) {
+		bool forced = requested;
+		requested = false;
+		lock.unlock();
+
+		if (sources_changed() || forced) {
+			Shader_Build_Result result = build_shaders();
+
+			lock.lock();
+			for (std::string& name : result.compiled) {
+				if (std::find(pending.compiled.begin(), pending.compiled.end(), name) ==
+					pending.compiled.end())
+					pending.compiled.push_back(std::move(name));
+			}
+			for (std::string& path : result.outputs) {
+				if (std::find(pending.outputs.begin(), pending.outputs.end(), path) ==
+					pending.outputs.end())
+					pending.outputs.push_back(std::move(path));
+			}
+			for (std::string& name : result.failed)
+				pending.failed.push_back(std::move(name));
+			pending.up_to_date = result.up_to_date;
+		} else {
+			lock.lock();
+		}
+
+		wake.wait_for(lock, interval_duration, [&] { return stopping || requested; });
+	}
+}
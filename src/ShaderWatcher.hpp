@@ -0,0 +1,43 @@
+#pragma once
+
+#include "Common.hpp"
+#include "ShaderBuild.hpp"
+
+#include <condition_variable>
+#include <filesystem>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+
+// Looks at the write times of src/shaders on a thread of its own and runs build_shaders there
+// as soon as one of them changes, so only the stages whose source or includes changed compile
+// again and the frame never waits on glslc. The main thread picks up what was compiled with take
+// and recreates the pipelines of those shaders.
+struct Shader_Watcher {
+	// Seconds between two looks at the write times.
+	f32 interval = 0.25f;
+
+	void start();
+	void stop();
+
+	// Builds on the next look even if nothing changed.
+	void request_build();
+
+	// Everything the builds finished since the last call compiled or failed to compile.
+	Shader_Build_Result take();
+	bool running() const { return thread.joinable(); }
+
+	std::thread thread;
+	std::mutex mutex;
+	std::condition_variable wake;
+	bool stopping = false;
+	bool requested = false;
+	Shader_Build_Result pending;
+
+	// Only touched by the thread.
+	std::unordered_map<std::string, std::filesystem::file_time_type> write_times;
+
+	bool sources_changed();
+	void loop();
+};
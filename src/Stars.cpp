@@ -0,0 +1,310 @@
+#include "Stars.hpp"
+
+#include "Parallel.hpp"
+
+#include <algorithm>
+#include <math.h>
+#include <string.h>
+
+// CIE 1931 colour matching functions from 380 to 780 nm by 5 nm, from
+// https://www.fourmilab.ch/documents/specrend/ like cosmos.frag had them.
+static const f32 Cie_Colour_Match[81][3] = {
+	{ 0.0014f, 0.0000f, 0.0065f }, { 0.0022f, 0.0001f, 0.0105f }, { 0.0042f, 0.0001f, 0.0201f },
+	{ 0.0076f, 0.0002f, 0.0362f }, { 0.0143f, 0.0004f, 0.0679f }, { 0.0232f, 0.0006f, 0.1102f },
+	{ 0.0435f, 0.0012f, 0.2074f }, { 0.0776f, 0.0022f, 0.3713f }, { 0.1344f, 0.0040f, 0.6456f },
+	{ 0.2148f, 0.0073f, 1.0391f }, { 0.2839f, 0.0116f, 1.3856f }, { 0.3285f, 0.0168f, 1.6230f },
+	{ 0.3483f, 0.0230f, 1.7471f }, { 0.3481f, 0.0298f, 1.7826f }, { 0.3362f, 0.0380f, 1.7721f },
+	{ 0.3187f, 0.0480f, 1.7441f }, { 0.2908f, 0.0600f, 1.6692f }, { 0.2511f, 0.0739f, 1.5281f },
+	{ 0.1954f, 0.0910f, 1.2876f }, { 0.1421f, 0.1126f, 1.0419f }, { 0.0956f, 0.1390f, 0.8130f },
+	{ 0.0580f, 0.1693f, 0.6162f }, { 0.0320f, 0.2080f, 0.4652f }, { 0.0147f, 0.2586f, 0.3533f },
+	{ 0.0049f, 0.3230f, 0.2720f }, { 0.0024f, 0.4073f, 0.2123f }, { 0.0093f, 0.5030f, 0.1582f },
+	{ 0.0291f, 0.6082f, 0.1117f }, { 0.0633f, 0.7100f, 0.0782f }, { 0.1096f, 0.7932f, 0.0573f },
+	{ 0.1655f, 0.8620f, 0.0422f }, { 0.2257f, 0.9149f, 0.0298f }, { 0.2904f, 0.9540f, 0.0203f },
+	{ 0.3597f, 0.9803f, 0.0134f }, { 0.4334f, 0.9950f, 0.0087f }, { 0.5121f, 1.0000f, 0.0057f },
+	{ 0.5945f, 0.9950f, 0.0039f }, { 0.6784f, 0.9786f, 0.0027f }, { 0.7621f, 0.9520f, 0.0021f },
+	{ 0.8425f, 0.9154f, 0.0018f }, { 0.9163f, 0.8700f, 0.0017f }, { 0.9786f, 0.8163f, 0.0014f },
+	{ 1.0263f, 0.7570f, 0.0011f }, { 1.0567f, 0.6949f, 0.0010f }, { 1.0622f, 0.6310f, 0.0008f },
+	{ 1.0456f, 0.5668f, 0.0006f }, { 1.0026f, 0.5030f, 0.0003f }, { 0.9384f, 0.4412f, 0.0002f },
+	{ 0.8544f, 0.3810f, 0.0002f }, { 0.7514f, 0.3210f, 0.0001f }, { 0.6424f, 0.2650f, 0.0000f },
+	{ 0.5419f, 0.2170f, 0.0000f }, { 0.4479f, 0.1750f, 0.0000f }, { 0.3608f, 0.1382f, 0.0000f },
+	{ 0.2835f, 0.1070f, 0.0000f }, { 0.2187f, 0.0816f, 0.0000f }, { 0.1649f, 0.0610f, 0.0000f },
+	{ 0.1212f, 0.0446f, 0.0000f }, { 0.0874f, 0.0320f, 0.0000f }, { 0.0636f, 0.0232f, 0.0000f },
+	{ 0.0468f, 0.0170f, 0.0000f }, { 0.0329f, 0.0119f, 0.0000f }, { 0.0227f, 0.0082f, 0.0000f },
+	{ 0.0158f, 0.0057f, 0.0000f }, { 0.0114f, 0.0041f, 0.0000f }, { 0.0081f, 0.0029f, 0.0000f },
+	{ 0.0058f, 0.0021f, 0.0000f }, { 0.0041f, 0.0015f, 0.0000f }, { 0.0029f, 0.0010f, 0.0000f },
+	{ 0.0020f, 0.0007f, 0.0000f }, { 0.0014f, 0.0005f, 0.0000f }, { 0.0010f, 0.0004f, 0.0000f },
+	{ 0.0007f, 0.0002f, 0.0000f }, { 0.0005f, 0.0002f, 0.0000f }, { 0.0003f, 0.0001f, 0.0000f },
+	{ 0.0002f, 0.0001f, 0.0000f }, { 0.0002f, 0.0001f, 0.0000f }, { 0.0001f, 0.0000f, 0.0000f },
+	{ 0.0001f, 0.0000f, 0.0000f }, { 0.0001f, 0.0000f, 0.0000f }, { 0.0000f, 0.0000f, 0.0000f },
+};
+
+Vector3f blackbody_color(f32 temperature) {
+	// Planck's law integrated against the matching functions, in doubles since it is per star.
+	f64 X = 0;
+	f64 Y = 0;
+	f64 Z = 0;
+	for (u32 i = 0; i < 81; i += 1) {
+		f64 wavelength = (380.0 + 5.0 * i) * 1e-9;
+		f64 spectrum = 3.74183e-16 * pow(wavelength, -5.0)
+			/ (exp(1.4388e-2 / (wavelength * temperature)) - 1.0);
+		X += spectrum * Cie_Colour_Match[i][0];
+		Y += spectrum * Cie_Colour_Match[i][1];
+		Z += spectrum * Cie_Colour_Match[i][2];
+	}
+	f64 sum = X + Y + Z;
+	f64 xc = X / sum;
+	f64 yc = Y / sum;
+	f64 zc = Z / sum;
+
+	// NTSC primaries and white point, the chromaticity goes through the inverse of their matrix.
+	f64 xr = 0.67, yr = 0.33, zr = 1.0 - (xr + yr);
+	f64 xg = 0.21, yg = 0.71, zg = 1.0 - (xg + yg);
+	f64 xb = 0.14, yb = 0.08, zb = 1.0 - (xb + yb);
+	f64 xw = 0.3101, yw = 0.3162, zw = 1.0 - (xw + yw);
+
+	f64 rx = yg * zb - yb * zg, ry = xb * zg - xg * zb, rz = xg * yb - xb * yg;
+	f64 gx = yb * zr - yr * zb, gy = xr * zb - xb * zr, gz = xb * yr - xr * yb;
+	f64 bx = yr * zg - yg * zr, by = xg * zr - xr * zg, bz = xr * yg - xg * yr;
+
+	f64 rw = (rx * xw + ry * yw + rz * zw) / yw;
+	f64 gw = (gx * xw + gy * yw + gz * zw) / yw;
+	f64 bw = (bx * xw + by * yw + bz * zw) / yw;
+
+	f64 r = (rx * xc + ry * yc + rz * zc) / rw;
+	f64 g = (gx * xc + gy * yc + gz * zc) / gw;
+	f64 b = (bx * xc + by * yc + bz * zc) / bw;
+
+	// Out of gamut colors get desaturated with white until no channel is negative.
+	f64 w = -std::min({ r, g, b, 0.0 });
+	r += w;
+	g += w;
+	b += w;
+
+	f64 greatest = std::max({ r, g, b });
+	if (greatest > 0) {
+		r /= greatest;
+		g /= greatest;
+		b /= greatest;
+	}
+	return { (f32)r, (f32)g, (f32)b };
+}
+
+static f32 fract(f32 x) {
+	return x - floorf(x);
+}
+
+// hash13n of cosmos.frag.
+static f32 hash13(Vector3f p) {
+	p = { fract(p.x * 5.3987f), fract(p.y * 5.4472f), fract(p.z * 6.9371f) };
+	f32 d = p.y * (p.x + 21.5351f) + p.z * (p.y + 14.3137f) + p.x * (p.z + 15.3247f);
+	p = { p.x + d, p.y + d, p.z + d };
+	return fract((p.x * p.y + p.z) * 95.4307f);
+}
+
+// Point i of the Fibonacci lattice of n points, id2sf of cosmos.frag.
+static Vector3f fibonacci_point(f32 i, f32 n) {
+	constexpr f32 Phi = 1.6180339887498948482f;
+	f32 phi = 2.f * PIf * fract(i * Phi);
+	f32 z = 1.f - (2.f * i + 1.f) / n;
+	f32 sin_theta = sqrtf(1.f - z * z);
+	return { cosf(phi) * sin_theta, sinf(phi) * sin_theta, z };
+}
+
+void generate_star_catalog(u32 seed, std::vector<Star>& out) {
+	constexpr u32 Rotations = 100;
+	constexpr u32 Lattice = 1 << 12;
+
+	out.clear();
+	for (u32 k = 0; k < Rotations; k += 1) {
+		f32 base = (f32)(k * 3) + (f32)seed * (f32)(Rotations * 3);
+		f32 yaw = hash13({ base, base, base }) * 2.f * PIf;
+		f32 pitch = hash13({ base + 1, base + 1, base + 1 }) * PIf;
+		f32 roll = hash13({ base + 2, base + 2, base + 2 }) * 2.f * PIf;
+
+		// Columns of yaw_pitch_roll, the shader looked up R * rd so the star sits at R^T * p.
+		Vector3f R[3] = {
+			{ cosf(yaw), sinf(yaw), 0.f },
+			{ -sinf(yaw), cosf(yaw), 0.f },
+			{ 0.f, 0.f, 1.f },
+		};
+		Vector3f S[3] = {
+			{ 1.f, 0.f, 0.f },
+			{ 0.f, cosf(pitch), sinf(pitch) },
+			{ 0.f, -sinf(pitch), cosf(pitch) },
+		};
+		Vector3f T[3] = {
+			{ cosf(roll), 0.f, sinf(roll) },
+			{ 0.f, 1.f, 0.f },
+			{ -sinf(roll), 0.f, cosf(roll) },
+		};
+		auto apply = [] (const Vector3f* m, Vector3f v) {
+			return m[0] * v.x + m[1] * v.y + m[2] * v.z;
+		};
+		Vector3f M[3];
+		for (u32 c = 0; c < 3; c += 1)
+			M[c] = apply(R, apply(S, T[c]));
+
+		for (u32 i = 0; i < Lattice; i += 1) {
+			Vector3f p = fibonacci_point((f32)i, (f32)Lattice);
+			f32 r = hash13(p * 100.f);
+			if (r > 0.05f)
+				continue;
+
+			Star star;
+			star.direction = normalize(Vector3f(dot(M[0], p), dot(M[1], p), dot(M[2], p)));
+			star.radius = r * 0.003f + 0.002f;
+			star.color = blackbody_color(hash13(p * 1000.f) * 5000.f + 5000.f);
+			star.intensity = hash13(p * 10.f);
+			out.push_back(star);
+		}
+	}
+}
+
+static f32 smoothstep(f32 edge0, f32 edge1, f32 x) {
+	f32 t = std::clamp((x - edge0) / (edge1 - edge0), 0.f, 1.f);
+	return t * t * (3.f - 2.f * t);
+}
+
+Vector3f star_radiance(const Star& star, Vector3f dir) {
+	f32 d = length(star.direction - dir);
+	f32 core = 1.f - smoothstep(0.f, star.radius, d);
+	f32 halo = 1.f - smoothstep(0.f, star.radius * 2.5f, d);
+	return star.color * ((core + halo * 0.2f) * star.intensity);
+}
+
+Vector3f cube_texel_direction(u32 f, u32 i, u32 j, u32 size) {
+	f32 s = ((f32)i + 0.5f) / (f32)size * 2.f - 1.f;
+	f32 t = ((f32)j + 0.5f) / (f32)size * 2.f - 1.f;
+	switch (f) {
+	case 0: return { 1.f, -t, -s };
+	case 1: return { -1.f, -t, s };
+	case 2: return { s, 1.f, t };
+	case 3: return { s, -1.f, -t };
+	case 4: return { s, -t, 1.f };
+	default: return { -s, -t, -1.f };
+	}
+}
+
+// Inverse of cube_texel_direction, the face coordinates of dir in [-1, 1] when ma > 0.
+static void cube_face_coords(u32 f, Vector3f v, f32& s, f32& t, f32& ma) {
+	switch (f) {
+	case 0: ma = v.x; s = -v.z; t = -v.y; break;
+	case 1: ma = -v.x; s = v.z; t = -v.y; break;
+	case 2: ma = v.y; s = v.x; t = v.z; break;
+	case 3: ma = -v.y; s = v.x; t = -v.z; break;
+	case 4: ma = v.z; s = v.x; t = -v.y; break;
+	default: ma = -v.z; s = -v.x; t = -v.y; break;
+	}
+	if (ma > 0.f) {
+		s /= ma;
+		t /= ma;
+	}
+}
+
+u16 f32_to_f16(f32 x) {
+	u32 bits;
+	memcpy(&bits, &x, sizeof(bits));
+	u32 sign = (bits >> 16) & 0x8000;
+	u32 biased = (bits >> 23) & 0xff;
+	u32 mantissa = bits & 0x7fffff;
+	if (biased == 0xff)
+		return (u16)(sign | 0x7c00 | (mantissa ? 0x200 : 0));
+
+	i32 exponent = (i32)biased - 127 + 15;
+	if (exponent >= 31)
+		return (u16)(sign | 0x7c00);
+
+	// Subnormal halves keep the implicit bit in the mantissa, both cases round to nearest even.
+	u32 shift = 13;
+	if (exponent <= 0) {
+		if (exponent < -10)
+			return (u16)sign;
+		mantissa |= 0x800000;
+		shift = 14 - exponent;
+		exponent = 0;
+	}
+	u32 half = ((u32)exponent << 10) | (mantissa >> shift);
+	u32 rest = mantissa & ((1u << shift) - 1);
+	u32 halfway = 1u << (shift - 1);
+	if (rest > halfway || (rest == halfway && (half & 1)))
+		half += 1; // a carry out of the mantissa bumps the exponent, which is the right result
+	return (u16)(sign | half);
+}
+
+f32 f16_to_f32(u16 h) {
+	u32 sign = (u32)(h & 0x8000) << 16;
+	u32 exponent = (h >> 10) & 0x1f;
+	u32 mantissa = h & 0x3ff;
+	f32 value;
+	if (exponent == 0) {
+		value = (f32)mantissa * (1.f / 16777216.f);
+	} else if (exponent == 31) {
+		value = mantissa ? NAN : INFINITY;
+	} else {
+		u32 bits = ((exponent + 112) << 23) | (mantissa << 13);
+		memcpy(&value, &bits, sizeof(value));
+	}
+	u32 bits;
+	memcpy(&bits, &value, sizeof(bits));
+	bits |= sign;
+	memcpy(&value, &bits, sizeof(value));
+	return value;
+}
+
+void bake_star_cube(const std::vector<Star>& stars, u32 size, std::vector<u16>& texels) {
+	constexpr u32 Tile = 32;
+	u32 tiles = (size + Tile - 1) / Tile;
+	texels.assign((usz)6 * size * size * 4, 0);
+
+	// Every star goes in the tiles its halo overlaps, on every face it reaches. A chord of d
+	// spans at most d / ma^2 of face coordinates around a direction of major component ma.
+	std::vector<std::vector<u32>> bins((usz)6 * tiles * tiles);
+	for (u32 k = 0; k < stars.size(); k += 1) {
+		const Star& star = stars[k];
+		for (u32 f = 0; f < 6; f += 1) {
+			f32 s;
+			f32 t;
+			f32 ma;
+			cube_face_coords(f, star.direction, s, t, ma);
+			if (ma < 0.5f)
+				continue;
+
+			f32 reach = star.radius * 2.5f / (ma * ma) * (f32)size * 0.5f + 1.f;
+			f32 x = (s * 0.5f + 0.5f) * (f32)size - 0.5f;
+			f32 y = (t * 0.5f + 0.5f) * (f32)size - 0.5f;
+			if (x + reach < 0 || y + reach < 0 || x - reach >= size || y - reach >= size)
+				continue;
+
+			u32 x0 = (u32)std::max(x - reach, 0.f) / Tile;
+			u32 y0 = (u32)std::max(y - reach, 0.f) / Tile;
+			u32 x1 = std::min((u32)(x + reach) / Tile, tiles - 1);
+			u32 y1 = std::min((u32)(y + reach) / Tile, tiles - 1);
+			for (u32 ty = y0; ty <= y1; ty += 1)
+			for (u32 tx = x0; tx <= x1; tx += 1)
+				bins[((usz)f * tiles + ty) * tiles + tx].push_back(k);
+		}
+	}
+
+	parallel_for(bins.size(), 16, [&] (usz begin, usz end) {
+		for (usz b = begin; b < end; b += 1) {
+			if (bins[b].empty())
+				continue;
+
+			u32 f = (u32)(b / (tiles * tiles));
+			u32 ty = (u32)(b / tiles % tiles);
+			u32 tx = (u32)(b % tiles);
+			for (u32 j = ty * Tile; j < std::min((ty + 1) * Tile, size); j += 1)
+			for (u32 i = tx * Tile; i < std::min((tx + 1) * Tile, size); i += 1) {
+				Vector3f dir = normalize(cube_texel_direction(f, i, j, size));
+				Vector3f color;
+				for (u32 k : bins[b])
+					color = color + star_radiance(stars[k], dir);
+
+				u16* texel = &texels[(((usz)f * size + j) * size + i) * 4];
+				texel[0] = f32_to_f16(color.x);
+				texel[1] = f32_to_f16(color.y);
+				texel[2] = f32_to_f16(color.z);
+			}
+		}
+	});
+}
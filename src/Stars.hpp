@@ -0,0 +1,36 @@
+#pragma once
+
+#include "Common.hpp"
+#include "Maths.hpp"
+
+#include <vector>
+
+struct Star {
+	Vector3f direction; // unit
+	f32 radius = 0.f; // of the core, as a chord length on the unit sphere like cosmos.frag
+	Vector3f color; // brightest channel at 1
+	f32 intensity = 0.f;
+};
+
+// RGB of a blackbody at temperature kelvins in NTSC primaries, the brightest channel at 1.
+extern Vector3f blackbody_color(f32 temperature);
+
+// The stars cosmos.frag used to draw, 100 rotated Fibonacci lattices of 4096 points where 5% of
+// the points hold a star of 5000 to 10000 K. Seed 0 gives the shader's rotations, any other seed
+// another sky with the same statistics.
+extern void generate_star_catalog(u32 seed, std::vector<Star>& out);
+
+// A core of full brightness fading out at radius, then a halo of 20% out to 2.5 radius.
+extern Vector3f star_radiance(const Star& star, Vector3f dir);
+
+// Direction through the center of texel (i, j) of cube face f, in the gpu convention. Faces are
+// +X -X +Y -Y +Z -Z and row 0 is the top of the face, like a layer of a cube texture.
+extern Vector3f cube_texel_direction(u32 f, u32 i, u32 j, u32 size);
+
+extern u16 f32_to_f16(f32 x);
+extern f32 f16_to_f32(u16 h);
+
+// Sum of star_radiance over the stars at every texel center of a cube of size x size faces, as
+// RGBA16F texels face by face, row by row, alpha 0. Faces are split in tiles that only look at
+// the stars overlapping them, tiles are spread over the workers.
+extern void bake_star_cube(const std::vector<Star>& stars, u32 size, std::vector<u16>& texels);
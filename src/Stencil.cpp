@@ -0,0 +1,144 @@
+#include "Stencil.hpp"
+
+#include "Planet.hpp"
+#include "Parallel.hpp"
+
+#include <barrier>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+static constexpr usz Stencil_Grain = 16 * 1024;
+
+void Tile_Graph::build(const std::vector<Tile>& tiles) {
+	na.resize(tiles.size());
+	nb.resize(tiles.size());
+	nc.resize(tiles.size());
+	da.resize(tiles.size());
+	db.resize(tiles.size());
+	dc.resize(tiles.size());
+
+	auto direction = [&] (size_t i, size_t n) -> Vector3f {
+		if (n == i)
+			return { 0, 0, 0 };
+		return normalize(tiles[n].center - tiles[i].center);
+	};
+
+	for (size_t i = 0; i < tiles.size(); i += 1) {
+		size_t a = tiles[i].na != SIZE_MAX ? tiles[i].na : i;
+		size_t b = tiles[i].nb != SIZE_MAX ? tiles[i].nb : i;
+		size_t c = tiles[i].nc != SIZE_MAX ? tiles[i].nc : i;
+
+		na[i] = (u32)a;
+		nb[i] = (u32)b;
+		nc[i] = (u32)c;
+		da[i] = direction(i, a);
+		db[i] = direction(i, b);
+		dc[i] = direction(i, c);
+	}
+}
+
+// out[i] = self_weight * in[i] + neighbour_weight * mean(in[n]) over [begin, end).
+static void mix_range(
+	const Tile_Graph& graph,
+	const f32* in,
+	f32* out,
+	usz begin,
+	usz end,
+	f32 self_weight,
+	f32 neighbour_weight
+) {
+	const u32* na = graph.na.data();
+	const u32* nb = graph.nb.data();
+	const u32* nc = graph.nc.data();
+	f32 w = neighbour_weight / 3.f;
+
+	usz i = begin;
+#if defined(__AVX2__)
+	__m256 self_w = _mm256_set1_ps(self_weight);
+	__m256 neighbour_w = _mm256_set1_ps(w);
+	for (; i + 8 <= end; i += 8) {
+		__m256i ia = _mm256_loadu_si256((const __m256i*)(na + i));
+		__m256i ib = _mm256_loadu_si256((const __m256i*)(nb + i));
+		__m256i ic = _mm256_loadu_si256((const __m256i*)(nc + i));
+
+		__m256 sum = _mm256_i32gather_ps(in, ia, 4);
+		sum = _mm256_add_ps(sum, _mm256_i32gather_ps(in, ib, 4));
+		sum = _mm256_add_ps(sum, _mm256_i32gather_ps(in, ic, 4));
+
+		__m256 self = _mm256_loadu_ps(in + i);
+		__m256 r = _mm256_add_ps(_mm256_mul_ps(self, self_w), _mm256_mul_ps(sum, neighbour_w));
+		_mm256_storeu_ps(out + i, r);
+	}
+#endif
+	for (; i < end; i += 1) {
+		f32 sum = in[na[i]] + in[nb[i]] + in[nc[i]];
+		out[i] = in[i] * self_weight + sum * w;
+	}
+}
+
+void mean_of_neighbours(const Tile_Graph& graph, const f32* in, f32* out) {
+	parallel_for(graph.size(), Stencil_Grain, [&] (usz begin, usz end) {
+		mix_range(graph, in, out, begin, end, 0.f, 1.f);
+	});
+}
+
+void laplacian(const Tile_Graph& graph, const f32* in, f32* out) {
+	parallel_for(graph.size(), Stencil_Grain, [&] (usz begin, usz end) {
+		mix_range(graph, in, out, begin, end, -1.f, 1.f);
+	});
+}
+
+void gradient(const Tile_Graph& graph, const f32* in, Vector3f* out) {
+	parallel_for(graph.size(), Stencil_Grain, [&] (usz begin, usz end) {
+		for (usz i = begin; i < end; i += 1) {
+			f32 curr = in[i];
+			f32 a = in[graph.na[i]] - curr;
+			f32 b = in[graph.nb[i]] - curr;
+			f32 c = in[graph.nc[i]] - curr;
+			out[i] = a * graph.da[i] + b * graph.db[i] + c * graph.dc[i];
+		}
+	});
+}
+
+void divergence(const Tile_Graph& graph, const Vector3f* in, f32* out) {
+	parallel_for(graph.size(), Stencil_Grain, [&] (usz begin, usz end) {
+		for (usz i = begin; i < end; i += 1) {
+			Vector3f curr = in[i];
+			f32 div = 0;
+			div += dot(in[graph.na[i]] - curr, graph.da[i]);
+			div += dot(in[graph.nb[i]] - curr, graph.db[i]);
+			div += dot(in[graph.nc[i]] - curr, graph.dc[i]);
+			out[i] = div;
+		}
+	});
+}
+
+void diffuse(
+	const Tile_Graph& graph, f32* data, usz iterations, f32 self_weight, f32 neighbour_weight
+) {
+	usz n = graph.size();
+	if (iterations == 0 || n == 0)
+		return;
+
+	std::vector<f32> scratch(n);
+	usz workers = worker_count(n, Stencil_Grain);
+	std::barrier sync((std::ptrdiff_t)workers);
+
+	parallel_workers(workers, [&] (usz w) {
+		usz begin = n * w / workers;
+		usz end = n * (w + 1) / workers;
+
+		f32* src = data;
+		f32* dst = scratch.data();
+		for (usz it = 0; it < iterations; it += 1) {
+			mix_range(graph, src, dst, begin, end, self_weight, neighbour_weight);
+			sync.arrive_and_wait();
+			std::swap(src, dst);
+		}
+	});
+
+	if (iterations % 2 == 1)
+		memcpy(data, scratch.data(), n * sizeof(f32));
+}
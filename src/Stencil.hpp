@@ -0,0 +1,40 @@
+#pragma once
+
+#include "Common.hpp"
+#include "Maths.hpp"
+
+#include <vector>
+
+struct Tile;
+
+// Structure of arrays copy of the tile adjacency, laid out for batched stencil passes.
+// A missing neighbour (SIZE_MAX) is replaced by the tile itself.
+struct Tile_Graph {
+	std::vector<u32> na;
+	std::vector<u32> nb;
+	std::vector<u32> nc;
+
+	// Unit direction from the tile center to each neighbour center, same as macro_wind uses.
+	std::vector<Vector3f> da;
+	std::vector<Vector3f> db;
+	std::vector<Vector3f> dc;
+
+	void build(const std::vector<Tile>& tiles);
+	usz size() const { return na.size(); }
+};
+
+// out[i] = (in[na] + in[nb] + in[nc]) / 3
+extern void mean_of_neighbours(const Tile_Graph& graph, const f32* in, f32* out);
+// out[i] = mean_of_neighbours(in)[i] - in[i]
+extern void laplacian(const Tile_Graph& graph, const f32* in, f32* out);
+// out[i] = sum over neighbours n of (in[n] - in[i]) * d_n
+extern void gradient(const Tile_Graph& graph, const f32* in, Vector3f* out);
+// out[i] = sum over neighbours n of dot(in[n] - in[i], d_n)
+extern void divergence(const Tile_Graph& graph, const Vector3f* in, f32* out);
+
+// Runs `iterations` steps of data[i] = self_weight * data[i] + neighbour_weight * mean(data[n]).
+// Every worker keeps the same block of tiles across all iterations so it stays hot in its cache,
+// workers only synchronize between iterations.
+extern void diffuse(
+	const Tile_Graph& graph, f32* data, usz iterations, f32 self_weight, f32 neighbour_weight
+);
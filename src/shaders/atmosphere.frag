@@ -29,8 +29,18 @@ layout(std140, set = 3, binding = 1) uniform AtmosphereBlock {
 	float u_height_absorption;
 	float u_absorption_falloff;
     float u_intensity;
+	uint u_use_lut;
 };
 
+// Single scattering baked by Atmosphere_Lut, see AtmosphereLut.hpp for the layout.
+layout(set = 2, binding = 0) uniform sampler3D u_rayleigh_lut;
+layout(set = 2, binding = 1) uniform sampler3D u_mie_lut;
+
+#define LUT_NU 16
+#define LUT_MU_S 64
+#define LUT_MU 128
+#define LUT_R 32
+
 vec3 world_ray() {
 	vec3 ndc = vec3(uv * 2.0 - vec2(1.0), -1.0);
 	vec4 ray_eye = inverse(u_projection) * vec4(ndc, 1.0);
@@ -325,6 +335,97 @@ vec3 calculate_scattering(
 }
 
 
+float coord_from_unit(float x, float n) {
+	return 0.5 / n + x * (1.0 - 1.0 / n);
+}
+
+float lut_distance_to_top(float r, float mu, float top) {
+	return max(-r * mu + sqrt(max(r * r * (mu * mu - 1.0) + top * top, 0.0)), 0.0);
+}
+
+float horizon_warp(float x) {
+	return 1.0 - sqrt(clamp(1.0 - x, 0.0, 1.0));
+}
+
+// The mu halves of mu_coord in AtmosphereLut.cpp, the ground at the bottom and the sky on top.
+float lut_mu_coord(float r, float rho, float mu, bool ground, float bottom, float top, float H) {
+	float r_mu = r * mu;
+	float discriminant = r_mu * r_mu - r * r + bottom * bottom;
+	if (ground) {
+		float d = -r_mu - sqrt(max(discriminant, 0.0));
+		float d_min = r - bottom;
+		float x = rho <= d_min ? 1.0 : (d - d_min) / (rho - d_min);
+		return 0.5 - 0.5 * coord_from_unit(horizon_warp(x), float(LUT_MU) / 2.0);
+	}
+
+	float d = -r_mu + sqrt(max(discriminant + H * H, 0.0));
+	float d_min = top - r;
+	float d_max = rho + H;
+	float x = d_max <= d_min ? 1.0 : (d - d_min) / (d_max - d_min);
+	return 0.5 + 0.5 * coord_from_unit(horizon_warp(x), float(LUT_MU) / 2.0);
+}
+
+// Atmosphere_Lut::scattering, the tables hold everything of calculate_scattering but the phases.
+vec3 lut_scattering(vec3 start, vec3 dir, vec3 light_dir) {
+	float bottom = u_planet_radius;
+	float top = u_planet_radius + max(u_thickness, 1e-3);
+	float H = sqrt(top * top - bottom * bottom);
+
+	float r = length(start);
+	float r_mu = dot(start, dir);
+	if (r > top) {
+		float discriminant = r_mu * r_mu - r * r + top * top;
+		float entry = -r_mu - sqrt(max(discriminant, 0.0));
+		if (discriminant < 0.0 || entry < 0.0)
+			return vec3(0.0);
+		start += dir * entry;
+		r = top;
+		r_mu = dot(start, dir);
+	}
+	r = clamp(r, bottom, top);
+
+	float mu = clamp(r_mu / r, -1.0, 1.0);
+	float mu_s = clamp(dot(start, light_dir) / r, -1.0, 1.0);
+	float nu = dot(dir, light_dir);
+	bool ground = mu < 0.0 && r * r * (mu * mu - 1.0) + bottom * bottom >= 0.0;
+
+	float rho = sqrt(max(r * r - bottom * bottom, 0.0));
+	float u_r = coord_from_unit(rho / H, float(LUT_R));
+	float u_mu = lut_mu_coord(r, rho, mu, ground, bottom, top, H);
+
+	float d = lut_distance_to_top(bottom, mu_s, top);
+	float d_min = top - bottom;
+	// The tables go down to mu_s = -1, where the distance to the top is D.
+	float D = bottom + top;
+	float A = (D - d_min) / (H - d_min);
+	float a = (d - d_min) / (H - d_min);
+	float u_mu_s = coord_from_unit(max(1.0 - a / A, 0.0) / (1.0 + a), float(LUT_MU_S));
+
+	// nu slices go by the azimuth of the light and are side by side along x, interpolated by hand.
+	float spread = sqrt(max((1.0 - mu * mu) * (1.0 - mu_s * mu_s), 0.0));
+	float cos_azimuth = spread > 0.0 ? clamp((nu - mu * mu_s) / spread, -1.0, 1.0) : 1.0;
+	float x = acos(cos_azimuth) / 3.14159265359 * float(LUT_NU - 1);
+	float slice = floor(x);
+	float t = x - slice;
+	vec3 uvw0 = vec3((slice + u_mu_s) / float(LUT_NU), u_mu, u_r);
+	vec3 uvw1 = vec3((slice + 1.0 + u_mu_s) / float(LUT_NU), u_mu, u_r);
+	vec4 ray = mix(texture(u_rayleigh_lut, uvw0), texture(u_rayleigh_lut, uvw1), t);
+	vec3 mie = mix(texture(u_mie_lut, uvw0).rgb, texture(u_mie_lut, uvw1).rgb, t);
+
+	float gg = G * G;
+	float phase_ray = 3.0 / (50.2654824574 /* (16 * pi) */) * (1.0 + nu * nu);
+	float phase_mie = ground
+		? 0.0
+		: 3.0 / (25.1327412287 /* (8 * pi) */) * ((1.0 - gg) * (nu * nu + 1.0))
+			/ (pow(1.0 + gg - 2.0 * nu * G, 1.5) * (2.0 + gg));
+
+	return (
+		phase_ray * u_ray_beta * ray.rgb +
+		phase_mie * u_mie_beta * mie +
+		ray.w * u_ambient_beta
+	) * u_intensity;
+}
+
 void main() {
 	uvec2 windowSize = uvec2(width, height);
 	vec2 windowUV = uv * vec2(windowSize);
@@ -340,7 +441,12 @@ void main() {
 
 	float d = t > 0.0 ? 1.0 : 0.0;
 
+	// Alpha holds the distance to the planet, the guide of the upsample in upsample.frag.
 	vec3 color = vec3(0.0);
+	if (u_use_lut != 0) {
+		fragColor = vec4(lut_scattering(eye, rd, -normalize(u_planet_world_position)), t);
+		return;
+	}
 	color += calculate_scattering(
 		eye,
 		rd,
@@ -364,5 +470,5 @@ void main() {
 		LIGHT_STEPS
 	);
 
-	fragColor = vec4(color, 0.1);
+	fragColor = vec4(color, t);
 }
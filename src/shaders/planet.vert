@@ -1,10 +1,9 @@
 #version 450
 
-layout(location = 0) in vec3 v_position;
-layout(location = 1) in vec3 v_normal;
-layout(location = 2) in float v_scalar;
-layout(location = 3) in uint v_palette_index;
-layout(location = 4) in uint v_triangle_index;
+// Packed_Vertex, see PackedVertex.hpp.
+layout(location = 0) in ivec4 v_position_slot;
+layout(location = 1) in uint v_normal_scalar;
+layout(location = 2) in uint v_palette_barycenter;
 
 layout(location = 0) out vec3 world_position;
 layout(location = 1) out vec3 world_normal;
@@ -21,19 +20,28 @@ layout(set = 1, binding = 1) uniform PlanetBlock {
 	vec3 u_palette[64];
 	int u_overlay;
 };
+// (center, scale) of the sphere every slot is quantized in, Max_Quantization_Slots of them.
+layout(set = 1, binding = 2) uniform QuantizationBlock {
+	vec4 u_quantization[1024];
+};
+
+vec3 decode_octahedral(vec2 e) {
+	vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+	float t = max(-n.z, 0.0);
+	n.x += n.x >= 0.0 ? -t : t;
+	n.y += n.y >= 0.0 ? -t : t;
+	return normalize(n);
+}
 
 void main() {
-	if (v_triangle_index == 0) {
-		barycenter = vec3(1.0, 0.0, 0.0);
-	} else if (v_triangle_index == 1) {
-		barycenter = vec3(0.0, 1.0, 0.0);
-	} else if (v_triangle_index == 2) {
-		barycenter = vec3(0.0, 0.0, 1.0);
-	}
+	vec4 q = u_quantization[v_position_slot.w];
+	vec3 position = q.xyz + max(vec3(v_position_slot.xyz) / 32767.0, -1.0) * q.w;
+	vec3 normal = decode_octahedral(unpackSnorm4x8(v_normal_scalar).xy);
 
-	world_position = (u_model * vec4(v_position, 1.0)).xyz;
-	world_normal = normalize((u_model * vec4(v_normal, 0.0)).xyz);
-	palette_index = v_palette_index;
-	scalar = v_scalar;
-	gl_Position = u_projection * u_view * u_model * vec4(v_position, 1.0);
+	world_position = (u_model * vec4(position, 1.0)).xyz;
+	world_normal = normalize((u_model * vec4(normal, 0.0)).xyz);
+	palette_index = v_palette_barycenter & 0xFFu;
+	barycenter = unpackUnorm4x8(v_palette_barycenter).yzw;
+	scalar = float(v_normal_scalar >> 16) / 65535.0;
+	gl_Position = u_projection * u_view * u_model * vec4(position, 1.0);
 }
\ No newline at end of file
@@ -0,0 +1,77 @@
+#version 450
+
+layout(location = 0) in vec2 uv;
+
+layout(location = 0) out vec4 fragColor;
+
+layout(std140, set = 3, binding = 0) uniform MatrixBlock {
+	mat4 u_model;
+	mat4 u_view;
+	mat4 u_projection;
+};
+layout(std140, set = 3, binding = 1) uniform UpsampleBlock {
+	vec3 eye;
+	float u_planet_radius;
+	uvec2 u_low_size;
+};
+
+// The atmosphere at render scale, alpha is the distance to the planet along the ray.
+layout(set = 2, binding = 0) uniform sampler2D u_low;
+
+// How fast a low resolution texel loses weight with its relative distance difference.
+#define SHARPNESS 20.0
+
+vec3 world_ray() {
+	vec3 ndc = vec3(uv * 2.0 - vec2(1.0), -1.0);
+	vec4 ray_eye = inverse(u_projection) * vec4(ndc, 1.0);
+	ray_eye.z = -1.0;
+	ray_eye.w = 0.0;
+	vec3 ray_world = vec3(inverse(u_view) * ray_eye);
+	return normalize(ray_world);
+}
+float raySphereIntersect(vec3 r0, vec3 rd, vec3 s0, float sr) {
+	float a = dot(rd, rd);
+	vec3 s0_r0 = r0 - s0;
+	float b = 2.0 * dot(rd, s0_r0);
+	float c = dot(s0_r0, s0_r0) - (sr * sr);
+	if (b*b - 4.0*a*c < 0.0) {
+		return -1.0;
+	}
+	return (-b - sqrt((b*b) - 4.0*a*c))/(2.0*a);
+}
+
+// Joint bilateral upsample: the 4 texels of the bilinear footprint, each weighted down by how
+// far its distance is from the one of this pixel so the limb stays sharp.
+void main() {
+	float t = raySphereIntersect(eye, world_ray(), vec3(0.0), u_planet_radius);
+	if (t < 0)
+		t = u_planet_radius * 1000;
+
+	vec2 p = uv * vec2(u_low_size) - 0.5;
+	ivec2 base = ivec2(floor(p));
+	vec2 f = p - floor(p);
+
+	vec3 sum = vec3(0.0);
+	float total = 0.0;
+	vec3 closest = vec3(0.0);
+	float closest_diff = 1e30;
+	for (int k = 0; k < 4; k += 1) {
+		ivec2 o = ivec2(k & 1, k >> 1);
+		ivec2 c = clamp(base + o, ivec2(0), ivec2(u_low_size) - 1);
+		vec4 s = texelFetch(u_low, c, 0);
+
+		float diff = abs(s.a - t) / t;
+		vec2 b = mix(1.0 - f, f, vec2(o));
+		float w = b.x * b.y * exp(-SHARPNESS * diff);
+		sum += s.rgb * w;
+		total += w;
+		if (diff < closest_diff) {
+			closest_diff = diff;
+			closest = s.rgb;
+		}
+	}
+
+	// A sliver thinner than a texel has no neighbor on its side, the closest one stands in.
+	vec3 color = total > 1e-4 ? sum / total : closest;
+	fragColor = vec4(color, 0.1);
+}